@@ -0,0 +1,92 @@
+#include "bench_common.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace mpbench {
+namespace {
+std::mutex g_mtx;
+std::map<std::pair<int,int>, cv::Mat> g_color, g_gray, g_mosaic;
+}
+
+PartLayout partLayout(cv::Size size){
+  PartLayout L;
+  L.center = cv::Point2f(size.width*0.5f + 0.37f, size.height*0.5f - 0.21f);
+  L.rOuter = 0.25f*std::min(size.width, size.height);
+  L.rInner = 0.45f*L.rOuter;
+  const int w = int(3.6f*L.rOuter), h = int(3.2f*L.rOuter);
+  L.roi = cv::Rect(int(L.center.x) - w/2, int(L.center.y) - h/2, w, h) & cv::Rect(cv::Point(), size);
+  return L;
+}
+
+const cv::Mat& partImage(cv::Size size){
+  std::lock_guard<std::mutex> lk(g_mtx);
+  cv::Mat& m = g_color[{size.width, size.height}];
+  if (!m.empty()) return m;
+  const PartLayout L = partLayout(size);
+  const float R = L.rOuter;
+  const cv::Point2f c = L.center;
+  m.create(size, CV_8UC3); m.setTo(cv::Scalar::all(40));
+  const cv::Point cp((int)c.x, (int)c.y);
+  const int bw = int(1.6f*R), b0 = int(1.1f*R), b1 = int(1.4f*R);
+  cv::rectangle(m, cv::Rect(cp.x - bw, cp.y - b1, 2*bw, b1 - b0), cv::Scalar::all(200), cv::FILLED);
+  cv::rectangle(m, cv::Rect(cp.x - bw, cp.y + b0, 2*bw, b1 - b0), cv::Scalar::all(200), cv::FILLED);
+  cv::circle(m, cp, (int)R, cv::Scalar::all(200), cv::FILLED, cv::LINE_AA);
+  cv::circle(m, cp, (int)L.rInner, cv::Scalar::all(40), cv::FILLED, cv::LINE_AA);
+  cv::GaussianBlur(m, m, cv::Size(), 1.2);
+  cv::Mat noise(size, CV_16SC3);
+  cv::RNG rng(12345);
+  rng.fill(noise, cv::RNG::NORMAL, 0, 3);
+  cv::add(m, noise, m, cv::noArray(), CV_8U);
+  return m;
+}
+
+const cv::Mat& partGray(cv::Size size){
+  const cv::Mat& color = partImage(size);
+  std::lock_guard<std::mutex> lk(g_mtx);
+  cv::Mat& g = g_gray[{size.width, size.height}];
+  if (g.empty()) cv::cvtColor(color, g, cv::COLOR_BGR2GRAY);
+  return g;
+}
+
+const cv::Mat& partMosaic(cv::Size size){
+  const cv::Mat& color = partImage(size);
+  std::lock_guard<std::mutex> lk(g_mtx);
+  cv::Mat& m = g_mosaic[{size.width, size.height}];
+  if (m.empty()){
+    m.create(size, CV_8UC1);
+    for (int y=0; y<size.height; ++y){
+      const cv::Vec3b* s = color.ptr<cv::Vec3b>(y);
+      uchar* d = m.ptr<uchar>(y);
+      for (int x=0; x<size.width; ++x) d[x] = s[x][y%2 == 0 ? (x%2 == 0 ? 2 : 1) : (x%2 == 0 ? 1 : 0)];
+    }
+  }
+  return m;
+}
+
+std::vector<cv::Point2f> circlePoints(int n, float noise){
+  std::mt19937 rng(7); std::normal_distribution<float> nd(0.f, noise);
+  std::vector<cv::Point2f> pts; pts.reserve(n);
+  for (int i=0;i<n;++i){
+    float t = float(i)*float(2*CV_PI/n);
+    pts.push_back({500 + 200*std::cos(t) + nd(rng), 500 + 200*std::sin(t) + nd(rng)});
+  }
+  return pts;
+}
+
+std::vector<cv::Point2f> linePoints(int n, float noise){
+  std::mt19937 rng(11); std::normal_distribution<float> nd(0.f, noise);
+  std::vector<cv::Point2f> pts; pts.reserve(n);
+  for (int i=0;i<n;++i){ float x = 1000.f*i/n; pts.push_back({x, 0.3f*x + 20 + nd(rng)}); }
+  return pts;
+}
+
+void reportImage(benchmark::State& st, cv::Size size){
+  st.SetLabel(std::to_string(size.width) + "x" + std::to_string(size.height));
+  st.SetItemsProcessed(int64_t(st.iterations())*size.area());
+}
+}
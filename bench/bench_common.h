@@ -0,0 +1,33 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace mpbench {
+// VGA, 1080p, 5MP, 20MP, 50MP
+inline const std::vector<cv::Size>& resolutions(){
+  static const std::vector<cv::Size> r{{640,480}, {1920,1080}, {2592,1944}, {5472,3648}, {8192,6144}};
+  return r;
+}
+// Registers one run per resolution; state.range(0) indexes resolutions().
+inline void AllResolutions(benchmark::internal::Benchmark* b){
+  for (int i=0; i<(int)resolutions().size(); ++i) b->Arg(i);
+  b->ArgName("res")->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+// Lit part on a dark background: a ring (two edges) between two bars, with
+// sensor-like blur and noise. Cached per size; callers must not modify it.
+const cv::Mat& partImage(cv::Size size);
+const cv::Mat& partGray(cv::Size size);
+const cv::Mat& partMosaic(cv::Size size);   // raw R G / G B mosaic, as from a BayerRG8 camera
+// Where partImage() puts things, for ROIs and fits.
+struct PartLayout { cv::Point2f center; float rOuter, rInner; cv::Rect roi; };
+PartLayout partLayout(cv::Size size);
+
+// n noisy points on a circle / line, fixed seed.
+std::vector<cv::Point2f> circlePoints(int n, float noise = 0.3f);
+std::vector<cv::Point2f> linePoints(int n, float noise = 0.3f);
+
+// Sets label and pixel throughput for an image benchmark.
+void reportImage(benchmark::State& st, cv::Size size);
+}
@@ -0,0 +1,114 @@
+#include "bench_common.h"
+#include "measure/geometry.h"
+#include "measure/gauges.h"
+#include "measure/gauge_batch.h"
+#include "measure/geometry_batch.h"
+using namespace mp;
+using namespace mpbench;
+
+// arg = number of edge points
+static void BM_FitLineLSQ(benchmark::State& st){
+  const auto pts = linePoints((int)st.range(0));
+  for (auto _ : st){
+    Line2D L = fitLineLSQ(pts);
+    benchmark::DoNotOptimize(L);
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_FitLineLSQ)->RangeMultiplier(10)->Range(100, 1000000);
+
+static void BM_FitCircleKasa(benchmark::State& st){
+  const auto pts = circlePoints((int)st.range(0));
+  for (auto _ : st){
+    Circle c = fitCircleKasa(pts);
+    benchmark::DoNotOptimize(c);
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_FitCircleKasa)->RangeMultiplier(10)->Range(100, 1000000);
+
+static void BM_RoundnessPx(benchmark::State& st){
+  const auto pts = circlePoints((int)st.range(0));
+  for (auto _ : st){
+    double r = gauge::roundnessPx(pts);
+    benchmark::DoNotOptimize(r);
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_RoundnessPx)->RangeMultiplier(10)->Range(100, 1000000);
+
+static void BM_LineLineDistancePx(benchmark::State& st){
+  const Line2D a{{0.f, 100.f}, {1.f, 0.002f}}, b{{0.f, 300.f}, {1.f, -0.001f}};
+  const cv::Rect roi(0, 0, 2000, 400);
+  for (auto _ : st){
+    double d = gauge::lineLineDistancePx(a, b, roi);
+    benchmark::DoNotOptimize(d);
+  }
+}
+BENCHMARK(BM_LineLineDistancePx);
+
+// arg = points per set; 16 sets fitted per call
+static void BM_FitCirclesBatch(benchmark::State& st){
+  const auto pts = circlePoints((int)st.range(0));
+  PointSetsSoA sets;
+  for (int k=0;k<16;++k) sets.add(pts, cv::Point2f(float(k), 0.f));
+  std::vector<CircleGauge> out;
+  for (auto _ : st){
+    fitCirclesBatch(sets, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  st.SetItemsProcessed(st.iterations()*16*st.range(0));
+}
+BENCHMARK(BM_FitCirclesBatch)->RangeMultiplier(10)->Range(100, 100000);
+
+// arg = line pairs (and as many circle pairs); BM_GaugePairsScalar is the
+// same work through the one-pair gauges
+static cv::Rect gaugeRoi(int i){ return cv::Rect((37*i) % 1000, (53*i) % 1000, 400, 300); }
+static gauge::GaugeBatch gaugeBatch(int n){
+  gauge::GaugeBatch gb;
+  cv::RNG rng(5);
+  for (int i=0;i<=n;++i){
+    float a = (float)rng.uniform(-0.2, 0.2);
+    gb.lines.add(Line2D{{(float)rng.uniform(0., 2000.), (float)rng.uniform(0., 2000.)}, {std::cos(a), std::sin(a)}});
+    gb.circles.add(Circle{{(float)rng.uniform(0., 2000.), (float)rng.uniform(0., 2000.)}, 50.f});
+  }
+  for (int i=0;i<n;++i){
+    gb.addLinePair(i, i+1, gaugeRoi(i), 5.0, 0.2, 0.1);
+    gb.addCirclePair(i, i+1, 1.0);
+  }
+  return gb;
+}
+
+static void BM_GaugeBatch(benchmark::State& st){
+  const auto gb = gaugeBatch((int)st.range(0));
+  Calibration cal;
+  gauge::GaugeBatch::Result r;
+  for (auto _ : st){
+    gb.evaluate(cal, r);
+    benchmark::DoNotOptimize(r.gapMM.data());
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_GaugeBatch)->RangeMultiplier(8)->Range(8, 4096);
+
+static void BM_GaugePairsScalar(benchmark::State& st){
+  const auto gb = gaugeBatch((int)st.range(0));
+  const int n = (int)st.range(0);
+  std::vector<Line2D> L; std::vector<Circle> C;
+  for (int i=0;i<=n;++i){
+    L.push_back({{gb.lines.px[i], gb.lines.py[i]}, {gb.lines.vx[i], gb.lines.vy[i]}});
+    C.push_back({{gb.circles.cx[i], gb.circles.cy[i]}, gb.circles.r[i]});
+  }
+  Calibration cal;
+  std::vector<double> gap(n), par(n), conc(n);
+  for (auto _ : st){
+    for (int i=0;i<n;++i){
+      gap[i] = gauge::metricLineGapMM(L[i], L[i+1], gaugeRoi(i), cal).value_mm;
+      par[i] = gauge::lineLineParallelismDeg(L[i], L[i+1]);
+      conc[i] = gauge::metricConcentricityMM(C[i], C[i+1], cal).value_mm;
+    }
+    benchmark::DoNotOptimize(gap.data()); benchmark::DoNotOptimize(par.data()); benchmark::DoNotOptimize(conc.data());
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_GaugePairsScalar)->RangeMultiplier(8)->Range(8, 4096);
@@ -0,0 +1,128 @@
+#include "bench_common.h"
+#include <QJsonObject>
+#include "backend/measure_service.h"
+#include "core/measurement_engine.h"
+#include "measure/locator.h"
+#include "measure/report.h"
+#include <opencv2/imgproc.hpp>
+using namespace mp;
+using namespace mpbench;
+
+// arg = number of report items
+static void BM_ToJson(benchmark::State& st){
+  std::vector<Item> items;
+  for (int i=0; i<st.range(0); ++i)
+    items.push_back(Item{"metric_" + std::to_string(i), 12.345678 + i, "mm", i % 7 != 0, i % 5 ? "" : "<=0.05"});
+  size_t bytes = 0;
+  for (auto _ : st){
+    std::string s = toJson(items);
+    bytes += s.size();
+    benchmark::DoNotOptimize(s.data());
+  }
+  st.SetBytesProcessed((int64_t)bytes);
+}
+BENCHMARK(BM_ToJson)->RangeMultiplier(4)->Range(8, 2048);
+
+// The whole /measure recipe on a rect ROI around the part
+static void BM_MeasureImage(benchmark::State& st){
+  const cv::Size size = resolutions()[st.range(0)];
+  const cv::Mat& img = partImage(size);
+  const cv::Rect r = partLayout(size).roi;
+  QJsonObject payload{{"mm_per_px", 0.02}, {"specs", QJsonObject{}},
+                      {"roi", QJsonObject{{"type","rect"}, {"x",r.x}, {"y",r.y}, {"w",r.width}, {"h",r.height}}}};
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  for (auto _ : st){
+    measureImage(img, payload, items, limits);
+    benchmark::DoNotOptimize(items.data());
+  }
+  reportImage(st, size);
+}
+BENCHMARK(BM_MeasureImage)->Apply(AllResolutions);
+
+// 16 ROIs tiled over the frame: one shared pass vs one measure() per ROI
+static std::vector<RoiJob> tiledJobs(cv::Size size){
+  auto spec = std::make_shared<const MeasureSpec>();
+  std::vector<RoiJob> jobs;
+  const int w = size.width/4, h = size.height/4;
+  for (int i=0; i<16; ++i){
+    RoiJob j;
+    j.name = "r" + std::to_string(i);
+    j.spec = spec;
+    j.roi.kind = MeasureRoi::Kind::Rect;
+    j.roi.rect = cv::Rect((i%4)*w, (i/4)*h, w, h);
+    jobs.push_back(std::move(j));
+  }
+  return jobs;
+}
+
+static void BM_MeasureRois(benchmark::State& st){
+  const cv::Size size = resolutions()[st.range(0)];
+  const cv::Mat& img = partImage(size);
+  const auto jobs = tiledJobs(size);
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  for (auto _ : st){
+    MeasurementEngine::measureRois(img, jobs, items, limits);
+    benchmark::DoNotOptimize(items.data());
+  }
+  reportImage(st, size);
+}
+BENCHMARK(BM_MeasureRois)->Apply(AllResolutions)->UseRealTime();
+
+static void BM_MeasureRoisOneByOne(benchmark::State& st){
+  const cv::Size size = resolutions()[st.range(0)];
+  const cv::Mat& img = partImage(size);
+  const auto jobs = tiledJobs(size);
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  MeasurementEngine::Session session;
+  for (auto _ : st){
+    for (auto& j : jobs) session.measure(img, *j.spec, j.roi, items, limits);
+    benchmark::DoNotOptimize(items.data());
+  }
+  reportImage(st, size);
+}
+BENCHMARK(BM_MeasureRoisOneByOne)->Apply(AllResolutions)->UseRealTime();
+
+// A ring ROI over the part's ring: polar strip search vs the contour recipe
+// on the rasterised annulus (arg 1 = polar)
+static void BM_MeasureRing(benchmark::State& st){
+  const cv::Size size = resolutions()[st.range(0)];
+  const cv::Mat& img = partImage(size);
+  const PartLayout L = partLayout(size);
+  MeasureSpec spec;
+  spec.polarRing = st.range(1) != 0;
+  MeasureRoi roi;
+  roi.kind = MeasureRoi::Kind::Ring;
+  roi.center = cv::Point(L.center);
+  roi.rInner = int(0.5f*L.rInner);
+  roi.rOuter = int(1.05f*L.rOuter);   // clear of the bars at 1.1 R
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  MeasurementEngine::Session session;
+  for (auto _ : st){
+    session.measure(img, spec, roi, items, limits);
+    benchmark::DoNotOptimize(items.data());
+  }
+  reportImage(st, size);
+}
+BENCHMARK(BM_MeasureRing)->Apply([](benchmark::internal::Benchmark* b){
+  for (int i=0; i<(int)resolutions().size(); ++i) for (int polar : {0, 1}) b->Args({i, polar});
+  b->ArgNames({"res", "polar"})->Unit(benchmark::kMillisecond)->UseRealTime();
+});
+
+// ShapeLocator::locate on the part moved by (+23.5, -11.25) px and 4 deg;
+// trained on the part's box in the unmoved image (default +-15 deg search)
+static void BM_Locate(benchmark::State& st){
+  const cv::Size size = resolutions()[st.range(0)];
+  const cv::Mat& ref = partGray(size);
+  const PartLayout L = partLayout(size);
+  ShapeLocator loc;
+  if (!loc.train(ref, L.roi)){ st.SkipWithError("train failed"); return; }
+  cv::Mat M = cv::getRotationMatrix2D(loc.refCenter(), 4.0, 1.0);
+  M.at<double>(0,2) += 23.5; M.at<double>(1,2) -= 11.25;
+  cv::Mat img; cv::warpAffine(ref, img, M, size, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  for (auto _ : st){
+    Pose p = loc.locate(img);
+    benchmark::DoNotOptimize(p);
+  }
+  reportImage(st, size);
+}
+BENCHMARK(BM_Locate)->Apply(AllResolutions);
@@ -0,0 +1,144 @@
+#include "bench_common.h"
+#include <opencv2/imgproc.hpp>
+#include "core/bayer.h"
+#include "core/pipeline.h"
+#include "ops/canny.h"
+#include "ops/morph.h"
+#include "ops/threshold.h"
+#include "measure/caliper.h"
+#include "measure/edge_points.h"
+#include "measure/perspective.h"
+using namespace mp;
+using namespace mpbench;
+
+static void runOp(benchmark::State& st, IModule& op, const cv::Mat& img){
+  Frame in{img, "bench"};
+  for (auto _ : st){
+    Frame out = op.process(in);
+    benchmark::DoNotOptimize(out.mat.data);
+  }
+  reportImage(st, img.size());
+}
+
+static void BM_Canny(benchmark::State& st){
+  op::Canny op(50,150,3,true);
+  runOp(st, op, partImage(resolutions()[st.range(0)]));
+}
+BENCHMARK(BM_Canny)->Apply(AllResolutions);
+
+static void BM_Morph(benchmark::State& st){
+  op::Morph op(cv::MORPH_CLOSE, 3, 1);
+  runOp(st, op, partImage(resolutions()[st.range(0)]));
+}
+BENCHMARK(BM_Morph)->Apply(AllResolutions);
+
+static void BM_Threshold(benchmark::State& st){
+  op::Threshold op(128.0, cv::THRESH_BINARY);
+  runOp(st, op, partImage(resolutions()[st.range(0)]));
+}
+BENCHMARK(BM_Threshold)->Apply(AllResolutions);
+
+static void BM_PipelineRun(benchmark::State& st){
+  const cv::Mat& img = partImage(resolutions()[st.range(0)]);
+  Pipeline p;
+  p.add(std::make_shared<op::Canny>(50,150,3,true));
+  p.add(std::make_shared<op::Morph>(cv::MORPH_CLOSE, 3, 1));
+  p.add(std::make_shared<op::Threshold>(128.0, cv::THRESH_BINARY));
+  Frame in{img, "bench"};
+  for (auto _ : st){
+    Frame out = p.run(in);
+    benchmark::DoNotOptimize(out.mat.data);
+  }
+  reportImage(st, img.size());
+}
+BENCHMARK(BM_PipelineRun)->Apply(AllResolutions);
+
+// Caliper across the ring's outer edge; arg = samples along the line
+static void BM_Caliper1D(benchmark::State& st){
+  const cv::Size size = resolutions()[1];
+  const cv::Mat& gray = partGray(size);
+  const PartLayout L = partLayout(size);
+  const cv::Point2f a(L.center.x + 0.8f*L.rOuter, L.center.y), b(L.center.x + 1.2f*L.rOuter, L.center.y);
+  for (auto _ : st){
+    CaliperResult r = caliper1D(gray, a, b, (int)st.range(0));
+    benchmark::DoNotOptimize(r);
+  }
+  st.SetItemsProcessed(st.iterations()*st.range(0));
+}
+BENCHMARK(BM_Caliper1D)->RangeMultiplier(4)->Range(64, 4096);
+
+// Fixture rectification; tables are built once and served from the cache
+static void BM_WarpWithH(benchmark::State& st){
+  const cv::Mat& img = partImage(resolutions()[st.range(0)]);
+  const float w = (float)img.cols, h = (float)img.rows;
+  cv::Mat H = estimateH({cv::Point2f(0.02f*w, 0.03f*h), {0.97f*w, 0.01f*h}, {0.99f*w, 0.98f*h}, {0.01f*w, 0.96f*h}},
+                        {cv::Point2f(0, 0), {w, 0}, {w, h}, {0, h}});
+  benchmark::DoNotOptimize(warpWithH(img, H, img.size()).data);   // warm the table cache
+  for (auto _ : st){
+    cv::Mat out = warpWithH(img, H, img.size());
+    benchmark::DoNotOptimize(out.data);
+  }
+  reportImage(st, img.size());
+}
+BENCHMARK(BM_WarpWithH)->Apply(AllResolutions);
+
+// Edge points for the fitters: sparse gradient/NMS pass vs the dense
+// Canny/close/threshold image scanned by findContours
+static void BM_EdgePoints(benchmark::State& st){
+  const cv::Mat& gray = partGray(resolutions()[st.range(0)]);
+  EdgePoints e;
+  for (auto _ : st){
+    edgePoints(gray, e);
+    benchmark::DoNotOptimize(e.pt.data());
+  }
+  reportImage(st, gray.size());
+}
+BENCHMARK(BM_EdgePoints)->Apply(AllResolutions);
+
+static void BM_EdgeImageContours(benchmark::State& st){
+  const cv::Mat& img = partImage(resolutions()[st.range(0)]);
+  Pipeline p;
+  p.add(std::make_shared<op::Canny>(50,150,3,true));
+  p.add(std::make_shared<op::Morph>(cv::MORPH_CLOSE, 3, 1));
+  p.add(std::make_shared<op::Threshold>(128.0, cv::THRESH_BINARY));
+  cv::Mat gray;
+  std::vector<std::vector<cv::Point>> contours;
+  std::vector<cv::Point2f> pts;
+  for (auto _ : st){
+    cv::cvtColor(p.run(Frame{img, "bench"}).mat, gray, cv::COLOR_BGR2GRAY);
+    cv::findContours(gray, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+    pts.clear();
+    for (auto& c : contours) for (auto& q : c) pts.emplace_back(q);
+    benchmark::DoNotOptimize(pts.data());
+  }
+  reportImage(st, img.size());
+}
+BENCHMARK(BM_EdgeImageContours)->Apply(AllResolutions);
+
+// Grey input from a raw RG8 mosaic: the fused half-size pass vs demosaicing
+// to BGR and converting back to grey
+static void BM_BayerHalfGray(benchmark::State& st){
+  const cv::Mat& raw = partMosaic(resolutions()[st.range(0)]);
+  cv::Mat gray;
+  for (auto _ : st){
+    bayerToHalfGray(raw, gray, BayerPattern::RG, st.range(1) ? BayerReduce::Luma : BayerReduce::Green);
+    benchmark::DoNotOptimize(gray.data);
+  }
+  reportImage(st, raw.size());
+}
+BENCHMARK(BM_BayerHalfGray)->Apply([](benchmark::internal::Benchmark* b){
+  for (int i=0; i<(int)resolutions().size(); ++i) for (int luma : {0, 1}) b->Args({i, luma});
+  b->ArgNames({"res", "luma"})->Unit(benchmark::kMillisecond)->UseRealTime();
+});
+
+static void BM_DemosaicGray(benchmark::State& st){
+  const cv::Mat& raw = partMosaic(resolutions()[st.range(0)]);
+  cv::Mat bgr, gray;
+  for (auto _ : st){
+    cv::cvtColor(raw, bgr, cv::COLOR_BayerBG2BGR);   // OpenCV's name for R G / G B
+    cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+    benchmark::DoNotOptimize(gray.data);
+  }
+  reportImage(st, raw.size());
+}
+BENCHMARK(BM_DemosaicGray)->Apply(AllResolutions);
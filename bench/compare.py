@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Compare two Google Benchmark JSON reports and fail on regressions.
+
+    myproject_bench --benchmark_repetitions=5 --benchmark_out=current.json --benchmark_out_format=json
+    python3 bench/compare.py baseline.json current.json [--threshold 10]
+    python3 bench/compare.py baseline.json current.json --update   # accept current as the new baseline
+
+Runs are matched by name. With repetitions the median aggregate is used,
+otherwise the single iteration run. Exits 1 if any benchmark is slower than
+the baseline by more than the threshold (percent), or if a baseline
+benchmark is missing from the current run (--allow-missing for runs
+narrowed with --benchmark_filter).
+"""
+import argparse
+import json
+import shutil
+import sys
+
+UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        runs = json.load(f)["benchmarks"]
+    medians, singles = {}, {}
+    for r in runs:
+        t = r["real_time"] * UNIT_NS[r.get("time_unit", "ns")]
+        if r.get("run_type") == "aggregate":
+            if r.get("aggregate_name") == "median":
+                medians[r["run_name"]] = t
+        elif r.get("repetitions", 1) <= 1:
+            singles[r.get("run_name", r["name"])] = t
+    singles.update(medians)
+    return singles
+
+
+def fmt(ns):
+    for unit in ("s", "ms", "us"):
+        if ns >= UNIT_NS[unit]:
+            return "%.3f %s" % (ns / UNIT_NS[unit], unit)
+    return "%.1f ns" % ns
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent (default 10)")
+    ap.add_argument("--allow-missing", action="store_true", help="do not fail on baseline benchmarks absent from current")
+    ap.add_argument("--update", action="store_true", help="copy current over baseline after reporting")
+    a = ap.parse_args()
+
+    base, cur = load(a.baseline), load(a.current)
+    regressions = 0
+    width = max((len(n) for n in set(cur) | set(base)), default=10)
+    print("%-*s %12s %12s %8s" % (width, "benchmark", "baseline", "current", "delta"))
+    for name in sorted(cur):
+        if name not in base:
+            print("%-*s %12s %12s %8s" % (width, name, "-", fmt(cur[name]), "new"))
+            continue
+        delta = 100.0 * (cur[name] - base[name]) / base[name] if base[name] > 0 else 0.0
+        bad = delta > a.threshold
+        regressions += bad
+        print("%-*s %12s %12s %+7.1f%%%s" % (width, name, fmt(base[name]), fmt(cur[name]), delta, "  REGRESSION" if bad else ""))
+    missing = sorted(set(base) - set(cur))
+    for name in missing:
+        print("%-*s %12s %12s %8s%s" % (width, name, fmt(base[name]), "-", "missing", "" if a.allow_missing else "  FAIL"))
+
+    if a.update:
+        shutil.copyfile(a.current, a.baseline)
+        print("baseline updated: %s" % a.baseline)
+        return 0
+    failed = False
+    if regressions:
+        print("%d benchmark(s) regressed by more than %.1f%%" % (regressions, a.threshold))
+        failed = True
+    if missing and not a.allow_missing:
+        print("%d baseline benchmark(s) missing from the current run" % len(missing))
+        failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
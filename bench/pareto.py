@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Plot pareto.csv from myproject_sweep: time vs p95 length error per config.
+
+    python3 bench/pareto.py pareto.csv [-o pareto.png]
+"""
+import argparse
+import csv
+import math
+
+import matplotlib
+matplotlib.use("Agg")
+import matplotlib.pyplot as plt
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("csv")
+    ap.add_argument("-o", "--out", default="pareto.png")
+    a = ap.parse_args()
+
+    with open(a.csv, newline="", encoding="utf-8") as f:
+        rows = [r for r in csv.DictReader(f) if not math.isnan(float(r["err_p95_px"]))]
+    fig, ax = plt.subplots(figsize=(8, 5))
+    for r in rows:
+        t, e = float(r["time_ms"]), float(r["err_p95_px"])
+        front = r["pareto"] == "1"
+        ax.scatter(t, e, c="tab:red" if front else "tab:gray", marker="o" if int(r["missing"]) == 0 else "x")
+        ax.annotate(r["config"], (t, e), textcoords="offset points", xytext=(4, 4), fontsize=7)
+    front = sorted((float(r["time_ms"]), float(r["err_p95_px"])) for r in rows if r["pareto"] == "1")
+    if front:
+        ax.plot(*zip(*front), c="tab:red", lw=1)
+    ax.set_xscale("log")
+    ax.set_xlabel("median time per image (ms)")
+    ax.set_ylabel("p95 length error (px)")
+    ax.set_title("measure recipe variants on synthetic parts (red: Pareto front, x: lost a metric)")
+    ax.grid(True, which="both", alpha=0.3)
+    fig.tight_layout()
+    fig.savefig(a.out, dpi=120)
+    print("wrote %s" % a.out)
+
+
+if __name__ == "__main__":
+    main()
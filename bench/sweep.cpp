@@ -0,0 +1,182 @@
+// myproject_sweep: accuracy / speed trade-off of the /measure recipe variants
+// on synthetic parts with known geometry.
+//
+//   myproject_sweep [--sizes 640x480,1920x1080,2592x1944] [--noise 0,2,5] [--repeats 5]
+//                   [--out sweep.csv] [--pareto pareto.csv]
+//
+// Every variant measures every scene (lines, ring with an offset hole,
+// out-of-round disk) at every size and noise level, once with the part's ROI
+// and once on the full frame. sweep.csv holds one row per metric with truth,
+// measured value, error and time; pareto.csv ranks the configurations by
+// median time against p95 length error (px) and flags the Pareto front.
+// bench/pareto.py plots it.
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "backend/measure_service.h"
+#include "measure/synth.h"
+using namespace mp;
+
+namespace {
+constexpr double kMmPerPx = 0.01;
+
+struct Variant { const char* name; QJsonObject specs; };
+
+std::vector<Variant> variants(){
+  auto on = [](QJsonObject o){ o["enabled"] = true; return o; };
+  return {
+    {"contour", {}},
+    {"pyramid_l1", {{"pyramid", on({{"levels", 1}})}}},
+    {"pyramid_l2", {{"pyramid", on({{"levels", 2}})}}},
+    {"pyramid_l3", {{"pyramid", on({{"levels", 3}})}}},
+    {"subpixel", {{"subpixel", on({{"sigma", 1.0}})}}},
+    {"subpixel_robust", {{"subpixel", on({{"sigma", 1.0}})}, {"robust_fit", on({{"threshold_px", 1.0}})}}},
+    {"robust", {{"robust_fit", on({{"threshold_px", 1.0}})}}},
+  };
+}
+
+struct Scene {
+  const char* name;
+  std::function<cv::Mat(const SynthParams&, SynthTruth&)> make;
+};
+
+std::vector<Scene> scenes(){
+  // sizes scale with the frame so every resolution sees the same part
+  return {
+    {"lines", [](const SynthParams& p, SynthTruth& t){
+       const double s = std::min(p.size.width, p.size.height);
+       return synthParallelLines(p, 0.31*s, 1.7, 0.12, t, {0.37, -0.21}); }},
+    {"ring", [](const SynthParams& p, SynthTruth& t){
+       const double s = std::min(p.size.width, p.size.height);
+       return synthRing(p, 0.3*s, 0.12*s, {0.013*s, -0.007*s}, t, {0.37, -0.21}); }},
+    {"out_of_round", [](const SynthParams& p, SynthTruth& t){
+       const double s = std::min(p.size.width, p.size.height);
+       return synthOutOfRound(p, 0.3*s, 0.004*s, 3, t, {-0.29, 0.43}); }},
+  };
+}
+
+// metric name in the report -> truth in px (deg for parallelism)
+struct Truthed { const char* metric; double SynthTruth::* field; bool length; };
+const Truthed kTruths[] = {
+  {"line_gap", &SynthTruth::lineGapPx, true},
+  {"parallelism", &SynthTruth::parallelismDeg, false},
+  {"diameter_A", &SynthTruth::diameterAPx, true},
+  {"roundness_A", &SynthTruth::roundnessAPx, true},
+  {"concentricity_AB", &SynthTruth::concentricityPx, true},
+};
+
+std::vector<std::string> split(const char* s){
+  std::vector<std::string> out; std::string cur;
+  for (; *s; ++s){ if (*s==','){ if (!cur.empty()) out.push_back(cur); cur.clear(); } else cur += *s; }
+  if (!cur.empty()) out.push_back(cur);
+  return out;
+}
+
+struct Config { std::string name; std::vector<double> times, lengthErr; int missing = 0; };
+
+double quantile(std::vector<double> v, double q){
+  if (v.empty()) return std::nan("");
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size()-1, (size_t)std::ceil(q*v.size()) - (q>0))];
+}
+}
+
+int main(int argc, char** argv){
+  std::vector<cv::Size> sizes{{640,480}, {1920,1080}, {2592,1944}};
+  std::vector<double> noise{0, 2, 5};
+  int repeats = 5;
+  const char* out = "sweep.csv";
+  const char* pareto = "pareto.csv";
+  for (int i=1; i<argc; ++i){
+    const bool more = i+1 < argc;
+    if (!std::strcmp(argv[i], "--sizes") && more){
+      sizes.clear();
+      for (auto& s : split(argv[++i])){ int w=0, h=0; if (std::sscanf(s.c_str(), "%dx%d", &w, &h)==2) sizes.emplace_back(w, h); }
+    }
+    else if (!std::strcmp(argv[i], "--noise") && more){ noise.clear(); for (auto& s : split(argv[++i])) noise.push_back(std::atof(s.c_str())); }
+    else if (!std::strcmp(argv[i], "--repeats") && more) repeats = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--out") && more) out = argv[++i];
+    else if (!std::strcmp(argv[i], "--pareto") && more) pareto = argv[++i];
+    else { std::fprintf(stderr, "usage: %s [--sizes WxH,...] [--noise s,...] [--repeats n] [--out csv] [--pareto csv]\n", argv[0]); return 2; }
+  }
+
+  FILE* f = std::fopen(out, "w");
+  if (!f){ std::perror(out); return 1; }
+  std::fprintf(f, "variant,roi,scene,width,height,noise,metric,truth,measured,abs_err,time_ms\n");
+
+  const auto vars = variants();
+  const auto scs = scenes();
+  std::vector<Config> configs;
+  for (const Variant& v : vars) for (int roi=1; roi>=0; --roi)
+    configs.push_back({std::string(v.name) + (roi? "+roi" : "")});
+
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  for (const cv::Size& size : sizes){
+    for (double ns : noise){
+      for (const Scene& sc : scs){
+        SynthParams sp; sp.size = size; sp.noiseSigma = ns; sp.gradient = 0.2; sp.gradientAngleDeg = 30;
+        SynthTruth truth;
+        const cv::Mat img = sc.make(sp, truth);
+        for (size_t vi=0; vi<vars.size(); ++vi){
+          for (int roi=1; roi>=0; --roi){
+            Config& cfg = configs[2*vi + (1-roi)];
+            QJsonObject specs = vars[vi].specs;
+            specs["mm_per_px"] = kMmPerPx;
+            QJsonObject payload{{"mm_per_px", kMmPerPx}, {"specs", specs}};
+            if (roi) payload["roi"] = QJsonObject{{"type","rect"}, {"x",truth.roi.x}, {"y",truth.roi.y},
+                                                  {"w",truth.roi.width}, {"h",truth.roi.height}};
+            std::vector<double> t;
+            for (int r=0; r<repeats; ++r){
+              const auto t0 = std::chrono::steady_clock::now();
+              measureImage(img, payload, items, limits);
+              t.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            }
+            const double ms = quantile(t, 0.5);
+            cfg.times.push_back(ms);
+            for (const Truthed& tr : kTruths){
+              const double truePx = truth.*tr.field;
+              if (std::isnan(truePx)) continue;
+              const double trueVal = tr.length? truePx*kMmPerPx : truePx;
+              auto it = std::find_if(items.begin(), items.end(), [&](const Item& i){ return i.name == tr.metric; });
+              const double measured = it != items.end()? it->value : std::nan("");
+              const double err = std::abs(measured - trueVal);
+              if (std::isnan(measured)) ++cfg.missing;
+              else if (tr.length) cfg.lengthErr.push_back(err / kMmPerPx);
+              std::fprintf(f, "%s,%d,%s,%d,%d,%g,%s,%.6f,%.6f,%.6f,%.4f\n", vars[vi].name, roi, sc.name,
+                           size.width, size.height, ns, tr.metric, trueVal, measured, err, ms);
+            }
+          }
+        }
+      }
+    }
+  }
+  std::fclose(f);
+
+  // Pareto front over (median time, p95 length error); configs that lost a metric are never on it
+  struct Row { const Config* c; double ms, p95, maxErr; bool front = false; };
+  std::vector<Row> rows;
+  for (const Config& c : configs) rows.push_back({&c, quantile(c.times, 0.5), quantile(c.lengthErr, 0.95), quantile(c.lengthErr, 1.0)});
+  for (Row& a : rows){
+    if (a.c->missing || std::isnan(a.p95)) continue;
+    a.front = std::none_of(rows.begin(), rows.end(), [&](const Row& b){
+      return &a != &b && !b.c->missing && b.ms <= a.ms && b.p95 <= a.p95 && (b.ms < a.ms || b.p95 < a.p95); });
+  }
+  std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b){ return a.ms < b.ms; });
+  FILE* pf = std::fopen(pareto, "w");
+  if (!pf){ std::perror(pareto); return 1; }
+  std::fprintf(pf, "config,time_ms,err_p95_px,err_max_px,missing,pareto\n");
+  std::printf("%-24s %10s %12s %12s %8s\n", "config", "time_ms", "err_p95_px", "err_max_px", "missing");
+  for (const Row& r : rows){
+    std::fprintf(pf, "%s,%.4f,%.5f,%.5f,%d,%d\n", r.c->name.c_str(), r.ms, r.p95, r.maxErr, r.c->missing, (int)r.front);
+    std::printf("%-24s %10.3f %12.4f %12.4f %8d%s\n", r.c->name.c_str(), r.ms, r.p95, r.maxErr, r.c->missing, r.front? "  *" : "");
+  }
+  std::fclose(pf);
+  return 0;
+}
@@ -0,0 +1,42 @@
+#include "backend/measure_service.h"
+#include "core/measurement_engine.h"
+
+namespace {
+void poseFields(std::string& out, const mp::Pose& p){
+    out += "\"x\":"; mp::appendNumber(out, p.center.x);
+    out += ",\"y\":"; mp::appendNumber(out, p.center.y);
+    out += ",\"angle_deg\":"; mp::appendNumber(out, p.angleDeg);
+    out += ",\"score\":"; mp::appendNumber(out, p.score);
+    out += p.found? ",\"found\":true" : ",\"found\":false";
+}
+// drops the report's closing brace; the caller writes the field and restores it
+void openReport(std::string& report){
+    CV_Assert(!report.empty() && report.back() == '}');
+    report.pop_back();
+}
+}
+
+void mp::measureImage(const cv::Mat& src, const QJsonObject& payload, std::vector<Item>& items, std::vector<SpecLimits>& limits,
+                      Pose* pose){
+    MeasureSpec spec = MeasureSpec::fromJson(payload.value("specs").toObject());
+    spec.mmPerPx = payload.value("mm_per_px").toDouble(0.02);
+    MeasurementEngine::threadSession().measure(src, spec, MeasureRoi::fromJson(payload.value("roi").toObject()), items, limits, 0, pose);
+}
+
+void mp::appendPoseJson(std::string& report, const Pose& pose){
+    openReport(report);
+    report += ",\"pose\":{"; poseFields(report, pose); report += "}}";
+}
+
+void mp::appendPosesJson(std::string& report, const std::vector<std::string>& jobNames, const std::vector<Pose>& poses){
+    CV_Assert(jobNames.size() == poses.size());
+    openReport(report);
+    report += ",\"poses\":[";
+    for (size_t i=0;i<poses.size();++i){
+        if (i) report += ',';
+        report += "{\"roi\":"; appendJsonString(report, jobNames[i]); report += ',';
+        poseFields(report, poses[i]);
+        report += '}';
+    }
+    report += "]}";
+}
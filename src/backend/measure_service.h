@@ -0,0 +1,25 @@
+#pragma once
+#include <QJsonObject>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+#include "measure/locator.h"
+#include "measure/report.h"
+
+namespace mp {
+// The /measure recipe for a JSON payload ({"mm_per_px", "specs", "roi"}):
+// prepares the spec and measures on this thread's MeasurementEngine session.
+// Fills `items` with the measured metrics and `limits` with their spec
+// limits (same order), and `pose` (optional) with the locator's result.
+// Callers that measure repeatedly with one spec should prepare it once and
+// use the engine directly.
+void measureImage(const cv::Mat& src, const QJsonObject& payload, std::vector<Item>& items, std::vector<SpecLimits>& limits,
+                  Pose* pose = nullptr);
+
+// Adds the located part to a JSON report ({"metrics": [...]}) before its
+// closing brace: "pose": {"x", "y", "angle_deg", "score", "found"} for one
+// ROI, or "poses": [{"roi", "x", ...}, ...] with one entry per job of a
+// multi-ROI request. x and y are the trained region's centre in image px.
+void appendPoseJson(std::string& report, const Pose& pose);
+void appendPosesJson(std::string& report, const std::vector<std::string>& jobNames, const std::vector<Pose>& poses);
+}
@@ -3,265 +3,261 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QCoreApplication>
-#include <opencv2/imgcodecs.hpp>
-#include <opencv2/imgproc.hpp>
-#include "core/pipeline.h"
-#include "ops/canny.h"
-#include "ops/morph.h"
-#include "ops/threshold.h"
-#include "measure/geometry.h"
-#include "measure/gauges.h"
-#include "measure/calibration.h"
+#include <QCommandLineParser>
+#include <cmath>
+#include <memory>
+#include "core/image_buffer.h"
+#include "measure/perspective.h"
+#include "measure/report.h"
+#include "core/measurement_engine.h"
+#include "backend/measure_service.h"
 #include "backend/specs_store.h"
+#include "backend/spc_store.h"
 #include "backend/json_utils.h"
 
 using namespace mp;
 
-static QJsonObject measureImage(const cv::Mat& img, const QJsonObject& payload){
-    // Get specs / calibration
-    double mm_per_px = payload.value("mm_per_px").toDouble(0.02);
-    Calibration cal; cal.scale_mm_per_px = mm_per_px;
-
-    // ROI mask from payload
-    cv::Mat mask(img.rows, img.cols, CV_8UC1, cv::Scalar(255)); // default full
-    auto roi = payload.value("roi").toObject();
-    QString type = roi.value("type").toString();
-    if (!type.isEmpty()){
-        mask.setTo(0);
-        if (type == "rect"){
-            int x = roi.value("x").toInt();
-            int y = roi.value("y").toInt();
-            int w = roi.value("w").toInt();
-            int h = roi.value("h").toInt();
-            cv::rectangle(mask, cv::Rect(x,y,w,h), cv::Scalar(255), cv::FILLED);
-        } else if (type == "polygon"){
-            QJsonArray pts = roi.value("points").toArray();
-            std::vector<cv::Point> poly; poly.reserve(pts.size());
-            for (auto v: pts){
-                auto a = v.toArray();
-                poly.emplace_back(a.at(0).toInt(), a.at(1).toInt());
-            }
-            if (poly.size()>=3){
-                std::vector<std::vector<cv::Point>> polys{poly};
-                cv::fillPoly(mask, polys, cv::Scalar(255));
-            }
-        } else if (type == "ring"){
-            int cx = roi.value("cx").toInt();
-            int cy = roi.value("cy").toInt();
-            int r_in = roi.value("r_in").toInt();
-            int r_out = roi.value("r_out").toInt();
-            cv::circle(mask, {cx,cy}, r_out, 255, cv::FILLED);
-            cv::circle(mask, {cx,cy}, r_in, 0, cv::FILLED);
-        }
-    }
-
-    // Process pipeline
-    Pipeline p;
-    p.add(std::make_shared<op::Canny>(50,150,3,true));
-    p.add(std::make_shared<op::Morph>(cv::MORPH_CLOSE, 3, 1));
-    p.add(std::make_shared<op::Threshold>(128.0, cv::THRESH_BINARY));
-    cv::Mat masked; p.run(Frame{img,"api"}).mat.copyTo(masked, mask);
-
-    // Extract contours inside mask bbox
-    cv::Rect roiRect(0,0,img.cols,img.rows);
-    if (type=="rect"){
-        roiRect = cv::Rect(roi.value("x").toInt(), roi.value("y").toInt(),
-                           roi.value("w").toInt(), roi.value("h").toInt()) & cv::Rect(0,0,img.cols,img.rows);
-    } else if (type=="polygon" || type=="ring"){
-        // approximate by mask bbox
-        std::vector<std::vector<cv::Point>> cc;
-        cv::findContours(mask, cc, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-        if (!cc.empty()) roiRect = cv::boundingRect(cc[0]);
-    }
-
-    cv::Mat gray; if (masked.channels()==3) cv::cvtColor(masked, gray, cv::COLOR_BGR2GRAY); else gray=masked;
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(gray, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-    std::sort(contours.begin(), contours.end(), [](auto& a, auto& b){ return cv::contourArea(a) > cv::contourArea(b); });
-
-    // Fit circles
-    QJsonObject result;
-    QJsonArray outMetrics;
-
-    std::vector<cv::Point2f> ptsA, ptsB;
-    if (contours.size() >= 1) for (auto& p: contours[0]) ptsA.push_back(cv::Point2f(p) + cv::Point2f((float)roiRect.x,(float)roiRect.y));
-    if (contours.size() >= 2) for (auto& p: contours[1]) ptsB.push_back(cv::Point2f(p) + cv::Point2f((float)roiRect.x,(float)roiRect.y));
-
-    bool hasA=false, hasB=false;
-    Circle circA{{0,0},0}, circB{{0,0},0};
-    if (ptsA.size() >= 12){ circA = fitCircleKasa(ptsA); hasA=true; }
-    if (ptsB.size() >= 12){ circB = fitCircleKasa(ptsB); hasB=true; }
-
-    // Lines from top/bottom halves
-    std::vector<cv::Point2f> topPts, botPts;
-    for (auto& c : contours){
-        for (auto& p : c){
-            cv::Point pt = p + cv::Point(roiRect.x, roiRect.y);
-            if (pt.y < roiRect.y + roiRect.height*0.5) topPts.push_back(pt);
-            else botPts.push_back(pt);
-        }
-    }
-    bool hasTop=false, hasBot=false; Line2D Ltop{{0,0},{1,0}}, Lbot{{0,0},{1,0}};
-    if (topPts.size() >= 20){ Ltop = fitLineLSQ(topPts); hasTop=true; }
-    if (botPts.size() >= 20){ Lbot = fitLineLSQ(botPts); hasBot=true; }
-
-    auto pushMetric = [&](const QString& name, double val, const QString& unit, bool ok, const QString& note=QString()){
-        QJsonObject m; m["name"]=name; m["value"]=val; m["unit"]=unit; m["ok"]=ok; if (!note.isEmpty()) m["note"]=note;
-        outMetrics.push_back(m);
-    };
-
-    // Specs from payload
-    auto specs = payload.value("specs").toObject();
-
-    // Line gap & parallelism
-    if (hasTop && hasBot){
-        auto mGap = gauge::metricLineGapMM(Ltop, Lbot, roiRect, cal);
-        double target = specs.value("line_gap").toObject().value("target").toDouble(0);
-        double tol = specs.value("line_gap").toObject().value("tol").toDouble(0);
-        bool okGap = (std::abs(mGap.value_mm - target) <= tol + 1e-9);
-        pushMetric("line_gap", mGap.value_mm, "mm", okGap, QString("%1±%2").arg(target).arg(tol));
-
-        auto mPar = gauge::metricParallelismDeg(Ltop, Lbot);
-        double maxdeg = specs.value("parallelism").toObject().value("max_deg").toDouble(1.0);
-        bool okPar = (std::abs(mPar.value_mm) <= maxdeg + 1e-9);
-        pushMetric("parallelism", mPar.value_mm, "deg", okPar, QString("≤%1").arg(maxdeg));
-    }
-
-    // Circle metrics
-    if (hasA){
-        auto mDia = gauge::metricDiameterMM(circA, cal);
-        double target = specs.value("diameter").toObject().value("target").toDouble(0);
-        double tol = specs.value("diameter").toObject().value("tol").toDouble(0);
-        bool okDia = (std::abs(mDia.value_mm - target) <= tol + 1e-9);
-        pushMetric("diameter_A", mDia.value_mm, "mm", okDia, QString("%1±%2").arg(target).arg(tol));
-
-        auto mRnd = gauge::metricRoundnessMM(ptsA, cal);
-        double maxmm = specs.value("roundness").toObject().value("max_mm").toDouble(0.05);
-        bool okRnd = (mRnd.value_mm <= maxmm + 1e-9);
-        pushMetric("roundness_A", mRnd.value_mm, "mm", okRnd, QString("≤%1").arg(maxmm));
-    }
-
-    if (hasA && hasB){
-        auto mCon = gauge::metricConcentricityMM(circA, circB, cal);
-        double maxmm = specs.value("concentricity").toObject().value("max_mm").toDouble(0.1);
-        bool okCon = (mCon.value_mm <= maxmm + 1e-9);
-        pushMetric("concentricity_AB", mCon.value_mm, "mm", okCon, QString("≤%1").arg(maxmm));
-    }
-
-    result["metrics"] = outMetrics;
-    return result;
-}
-
 class HttpServer : public QTcpServer {
     Q_OBJECT
 public:
     HttpServer(const QString& specsPath, QObject* parent=nullptr)
-      : QTcpServer(parent), store_(specsPath) { store_.load(); }
+      : QTcpServer(parent), store_(specsPath), spc_(QFileInfo(specsPath).absolutePath() + "/spc") { store_.load(); }
 protected:
     void incomingConnection(qintptr sd) override {
         auto* sock = new QTcpSocket(this);
         sock->setSocketDescriptor(sd);
-        connect(sock, &QTcpSocket::readyRead, this, [this, sock](){
-            buf_ += sock->readAll();
-            // very small/simple HTTP parser: handle one request per connection
-            if (!buf_.contains("\r\n\r\n")) return;
-            auto headerEnd = buf_.indexOf("\r\n\r\n");
-            QByteArray head = buf_.left(headerEnd);
-            QByteArray body = buf_.mid(headerEnd+4);
-            QList<QByteArray> lines = head.split('\n');
-            QByteArray reqline = lines.first().trimmed();
-            auto parts = reqline.split(' ');
-            if (parts.size()<2){ writePlain(sock, 400, "Bad Request", "bad"); return; }
-            QByteArray method = parts[0];
-            QByteArray path = parts[1];
+        // Each connection owns its receive buffer; a request is complete once
+        // its headers and Content-Length bytes of body have arrived. HTTP/1.1
+        // connections stay open for further requests unless the client asks
+        // for "Connection: close".
+        auto buf = std::make_shared<QByteArray>();
+        connect(sock, &QTcpSocket::readyRead, this, [this, sock, buf](){
+            *buf += sock->readAll();
+            while (sock->state() == QAbstractSocket::ConnectedState){
+                const auto headerEnd = buf->indexOf("\r\n\r\n");
+                if (headerEnd < 0){
+                    if (buf->size() > kMaxHeader){ writePlain(sock, 431, "Request Header Fields Too Large", "header too large", false); sock->disconnectFromHost(); }
+                    return;
+                }
+                QList<QByteArray> lines = buf->left(headerEnd).split('\n');
+                auto parts = lines.first().trimmed().split(' ');
+                if (parts.size()<2){ writePlain(sock, 400, "Bad Request", "bad", false); sock->disconnectFromHost(); return; }
+                qint64 length = 0;
+                bool keep = parts.size()>2 && parts[2]=="HTTP/1.1";
+                for (int i=1;i<lines.size();++i){
+                    const auto colon = lines[i].indexOf(':');
+                    if (colon < 0) continue;
+                    const QByteArray key = lines[i].left(colon).trimmed().toLower();
+                    const QByteArray val = lines[i].mid(colon+1).trimmed().toLower();
+                    if (key=="content-length") length = val.toLongLong();
+                    else if (key=="connection") keep = val=="keep-alive" || (keep && val!="close");
+                }
+                if (length < 0 || length > kMaxBody){ writePlain(sock, 413, "Payload Too Large", "body too large", false); sock->disconnectFromHost(); return; }
+                if (buf->size() < headerEnd + 4 + length) return;   // wait for the rest of the body
+                const QByteArray body = buf->mid(headerEnd+4, length);
+                buf->remove(0, headerEnd + 4 + length);
+                handle(sock, parts[0], parts[1], body, keep);
+                if (!keep){ sock->disconnectFromHost(); return; }
+            }
+        });
+        connect(sock, &QTcpSocket::disconnected, sock, &QObject::deleteLater);
+    }
+private:
+    static constexpr qint64 kMaxHeader = 64 * 1024;
+    static constexpr qint64 kMaxBody = 64 * 1024 * 1024;
 
-            if (method=="GET" && path.startsWith("/health")){
-                writeJson(sock, 200, QJsonObject{{"status","ok"}});
+    void handle(QTcpSocket* sock, const QByteArray& method, const QByteArray& path, const QByteArray& body, bool keep){
+        if (method=="GET" && path.startsWith("/health")){
+            writeJson(sock, 200, QJsonObject{{"status","ok"}}, keep);
+        }
+        else if (method=="GET" && path.startsWith("/specs/")){
+            QString id = QString::fromUtf8(path.mid(strlen("/specs/")));
+            auto spec = store_.get(id);
+            if (spec.isEmpty()) writeJson(sock, 404, QJsonObject{{"error","not found"},{"id",id}}, keep);
+            else writeJson(sock, 200, spec, keep);
+        }
+        else if (method=="GET" && path.startsWith("/stats/")){
+            QString id = QString::fromUtf8(path.mid(strlen("/stats/")));
+            writeJson(sock, 200, spc_.statsJson(id), keep);
+        }
+        else if (method=="POST" && path == "/specs"){
+            auto doc = QJsonDocument::fromJson(body);
+            if (!doc.isObject()){ writePlain(sock, 400, "Bad Request", "invalid json", keep); return; }
+            auto obj = doc.object();
+            QString id = obj.value("id").toString();
+            QJsonObject spec = obj.value("spec").toObject();
+            if (id.isEmpty() || spec.isEmpty()){ writePlain(sock, 400, "Bad Request", "missing id/spec", keep); return; }
+            store_.put(id, spec);
+            store_.save();
+            engine_.putSpec(id.toStdString(), spec);
+            writeJson(sock, 200, QJsonObject{{"ok", true},{"id", id}}, keep);
+        }
+        else if (method=="POST" && path == "/measure"){
+            auto doc = QJsonDocument::fromJson(body);
+            if (!doc.isObject()){ writePlain(sock, 400, "Bad Request", "invalid json", keep); return; }
+            auto obj = doc.object();
+            // Resolve image
+            QString imgPath = obj.value("image_path").toString();
+            ImageBuffer img = ImageBuffer::read(imgPath.toStdString());
+            if (img.empty()){ writePlain(sock, 400, "Bad Request", "bad image path", keep); return; }
+            // Resolve specs: inline (prepared per request) or by id (prepared once, see engineSpec)
+            const double mmPerPx = obj.value("mm_per_px").toDouble(0.02);
+            QString specId;
+            std::shared_ptr<const MeasureSpec> spec = resolveSpec(obj, mmPerPx, specId);
+            // "bayer": "RG" | "BG" | "GR" | "GB": the file holds the camera's raw
+            // mosaic, measured as a half-size grey image (ROIs in half-size pixels)
+            if (obj.contains("bayer")){
+                const BayerPattern p = bayerPattern(obj.value("bayer").toString().toStdString());
+                if (p == BayerPattern::None || img.mat().channels() != 1){ writePlain(sock, 400, "Bad Request", "bad bayer frame", keep); return; }
+                bayerToHalfGray(img.mat(), halfGray_, p, spec->bayerReduce);
+                img = ImageBuffer(halfGray_);
             }
-            else if (method=="GET" && path.startsWith("/specs/")){
-                QString id = QString::fromUtf8(path.mid(strlen("/specs/")));
-                auto spec = store_.get(id);
-                if (spec.isEmpty()) writeJson(sock, 404, QJsonObject{{"error","not found"},{"id",id}});
-                else writeJson(sock, 200, spec);
+
+            // Response body: "format": "json" (default), "csv" or "binary" (ReportRecord stream)
+            QString fmt = obj.value("format").toString("json");
+            ReportFormat rf = fmt=="csv"? ReportFormat::Csv : fmt=="binary"? ReportFormat::Binary : ReportFormat::Json;
+            static const char* kTypes[] = {"application/json", "text/csv", "application/octet-stream"};
+            // "rois": [{"name", "roi", "specs"|"spec_id", "gauges": [...]}, ...] measures
+            // every region in one pass over the image; entries without their own
+            // spec use the request's. Items come back as "<name>.<item>".
+            // Where a spec has a locator, the JSON report also carries the part's
+            // pose ("pose", or "poses" per job); csv and binary carry items only.
+            jobSpecIds_.clear();
+            bool located = false;
+            if (obj.contains("rois")){
+                const QJsonArray rois = obj.value("rois").toArray();
+                if (rois.isEmpty()){ writePlain(sock, 400, "Bad Request", "empty rois", keep); return; }
+                jobs_.resize(rois.size());
+                for (int i=0;i<rois.size();++i){
+                    const QJsonObject r = rois.at(i).toObject();
+                    RoiJob& job = jobs_[i];
+                    job.name = r.value("name").toString(QString("roi%1").arg(i)).toStdString();
+                    if (rf == ReportFormat::Binary && job.name.size() > kReportRoiNameMax){
+                        writePlain(sock, 400, "Bad Request", "roi name too long for a binary report", keep); return;
+                    }
+                    QString id = specId;
+                    job.spec = r.contains("specs") || r.contains("spec_id") ? resolveSpec(r, mmPerPx, id) : spec;
+                    job.roi = MeasureRoi::fromJson(r.value("roi").toObject());
+                    job.gauges.clear();
+                    for (const auto& g : r.value("gauges").toArray()) job.gauges.push_back(g.toString().toStdString());
+                    jobSpecIds_.push_back(id);
+                    located = located || job.spec->locator != nullptr;
+                }
+                MeasurementEngine::measureRois(img.mat(), jobs_, items_, limits_, &jobOf_, &jobPoses_);
+            } else {
+                MeasurementEngine::threadSession().measure(img.mat(), *spec, MeasureRoi::fromJson(obj.value("roi").toObject()), items_, limits_,
+                                                           0, &pose_);
+                jobSpecIds_.push_back(specId);
+                jobOf_.assign(items_.size(), 0);
+                located = spec->locator != nullptr;
             }
-            else if (method=="POST" && path == "/specs"){
-                auto doc = QJsonDocument::fromJson(body);
-                if (!doc.isObject()){ writePlain(sock, 400, "Bad Request", "invalid json"); return; }
-                auto obj = doc.object();
-                QString id = obj.value("id").toString();
-                QJsonObject spec = obj.value("spec").toObject();
-                if (id.isEmpty() || spec.isEmpty()){ writePlain(sock, 400, "Bad Request", "missing id/spec"); return; }
-                store_.put(id, spec);
-                store_.save();
-                writeJson(sock, 200, QJsonObject{{"ok", true},{"id", id}});
+            // SPC history is kept per stored spec (inline specs have no stable id)
+            // and only for items with a spec limit to chart against
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            for (size_t i=0;i<items_.size();++i){
+                const QString& id = jobSpecIds_[jobOf_[i]];
+                if (!id.isEmpty() && !(std::isnan(limits_[i].lsl) && std::isnan(limits_[i].usl)))
+                    spc_.append(id, QString::fromStdString(items_[i].name), items_[i].value, items_[i].ok, limits_[i].lsl, limits_[i].usl, now);
             }
-            else if (method=="POST" && path == "/measure"){
-                auto doc = QJsonDocument::fromJson(body);
-                if (!doc.isObject()){ writePlain(sock, 400, "Bad Request", "invalid json"); return; }
-                auto obj = doc.object();
-                // Resolve image
-                QString imgPath = obj.value("image_path").toString();
-                cv::Mat img = cv::imread(imgPath.toStdString());
-                if (img.empty()){ writePlain(sock, 400, "Bad Request", "bad image path"); return; }
-                // Resolve specs: inline or by id
-                QJsonObject specs;
-                if (obj.contains("specs")) specs = obj.value("specs").toObject();
-                else if (obj.contains("spec_id")) specs = store_.get(obj.value("spec_id").toString());
-                // attach calibration
-                if (!specs.contains("mm_per_px")){
-                    double s = obj.value("mm_per_px").toDouble(0.02);
-                    specs.insert("mm_per_px", s);
+            writeReport(*writers_[int(rf)], items_, report_);
+            if (located && rf == ReportFormat::Json){
+                if (!obj.contains("rois")) appendPoseJson(report_, pose_);
+                else {
+                    jobNames_.clear();
+                    for (const RoiJob& j : jobs_) jobNames_.push_back(j.name);
+                    appendPosesJson(report_, jobNames_, jobPoses_);
                 }
-                QJsonObject payload;
-                payload["mm_per_px"] = specs.value("mm_per_px");
-                payload["specs"] = specs;
-                if (obj.contains("roi")) payload["roi"] = obj.value("roi").toObject();
-
-                auto result = measureImage(img, payload);
-                writeJson(sock, 200, result);
-            }
-            else {
-                writePlain(sock, 404, "Not Found", "not found");
             }
-            sock->disconnectFromHost();
-            buf_.clear();
-        });
-        connect(sock, &QTcpSocket::disconnected, sock, &QObject::deleteLater);
+            writeBody(sock, 200, kTypes[int(rf)], report_.data(), (qint64)report_.size(), keep);
+        }
+        else {
+            writePlain(sock, 404, "Not Found", "not found", keep);
+        }
     }
-private:
-    void writeJson(QTcpSocket* sock, int code, const QJsonObject& obj){
+    // Spec of a request or ROI entry: inline "specs" (id cleared) or a stored
+    // "spec_id". The request's calibration applies unless the spec has its own.
+    std::shared_ptr<const MeasureSpec> resolveSpec(const QJsonObject& o, double mmPerPx, QString& id){
+        QJsonObject specs;
+        std::shared_ptr<const MeasureSpec> prepared;
+        if (o.contains("specs")){
+            id.clear();
+            specs = o.value("specs").toObject();
+            prepared = std::make_shared<const MeasureSpec>(MeasureSpec::fromJson(specs));
+        } else {
+            id = o.value("spec_id").toString();
+            specs = store_.get(id);
+            prepared = engineSpec(id, specs);
+        }
+        if (specs.contains("mm_per_px") || prepared->mmPerPx == mmPerPx) return prepared;
+        auto spec = std::make_shared<MeasureSpec>(*prepared);
+        spec->mmPerPx = mmPerPx;
+        return spec;
+    }
+    // Stored specs are prepared on first use and re-prepared by POST /specs.
+    std::shared_ptr<const MeasureSpec> engineSpec(const QString& id, const QJsonObject& specs){
+        const std::string key = id.toStdString();
+        if (auto s = engine_.spec(key)) return s;
+        engine_.putSpec(key, specs);
+        return engine_.spec(key);
+    }
+    void writeJson(QTcpSocket* sock, int code, const QJsonObject& obj, bool keep){
         auto bytes = toBytes(obj);
-        QByteArray resp;
-        resp += "HTTP/1.1 " + QByteArray::number(code) + " OK\r\n";
-        resp += "Content-Type: application/json\r\n";
-        resp += "Content-Length: " + QByteArray::number(bytes.size()) + "\r\n";
-        resp += "Connection: close\r\n\r\n";
-        resp += bytes;
-        sock->write(resp);
+        writeBody(sock, code, "application/json", bytes.constData(), bytes.size(), keep);
+    }
+    void writeBody(QTcpSocket* sock, int code, const char* type, const char* data, qint64 n, bool keep){
+        QByteArray head;
+        head += "HTTP/1.1 " + QByteArray::number(code) + " OK\r\n";
+        head += "Content-Type: "; head += type; head += "\r\n";
+        head += "Content-Length: " + QByteArray::number(n) + "\r\n";
+        head += keep? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        sock->write(head);
+        sock->write(data, n);
     }
-    void writePlain(QTcpSocket* sock, int code, const char* text, const char* body){
+    void writePlain(QTcpSocket* sock, int code, const char* text, const char* body, bool keep){
         QByteArray resp;
         resp += "HTTP/1.1 " + QByteArray::number(code) + " "; resp += text; resp += "\r\n";
         resp += "Content-Type: text/plain\r\n";
         resp += "Content-Length: " + QByteArray::number(strlen(body)) + "\r\n";
-        resp += "Connection: close\r\n\r\n";
+        resp += keep? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
         resp += body;
         sock->write(resp);
     }
-    QByteArray buf_;
     SpecsStore store_;
+    SpcStore spc_;
+    MeasurementEngine engine_;
+    // report writers indexed by ReportFormat; items/body buffers are reused across requests
+    std::unique_ptr<IReportWriter> writers_[3]{makeReportWriter(ReportFormat::Json, "metrics"),
+                                               makeReportWriter(ReportFormat::Csv),
+                                               makeReportWriter(ReportFormat::Binary)};
+    std::vector<Item> items_;
+    std::vector<SpecLimits> limits_;
+    std::vector<RoiJob> jobs_;
+    std::vector<QString> jobSpecIds_;   // per job; empty for inline specs
+    std::vector<int> jobOf_;            // per item
+    std::vector<std::string> jobNames_;
+    std::vector<Pose> jobPoses_;        // per job
+    Pose pose_;                         // single-ROI requests
+    std::string report_;
+    cv::Mat halfGray_;                  // Bayer input, reused across requests
 };
 
 #include "server.moc"
 
 int main(int argc, char** argv){
     QCoreApplication app(argc, argv);
+    QCommandLineParser cli;
+    cli.addHelpOption();
+    cli.addOption({"port", "Listen port (default 8080).", "port", "8080"});
+    cli.process(app);
+    const quint16 port = (quint16)cli.value("port").toUInt();
     QString cfg = QCoreApplication::applicationDirPath() + "/../../config/specs.json";
+    // Rectification tables are persisted next to the config and mapped on restart
+    PerspectiveRemap::setCacheDir((QFileInfo(cfg).absolutePath() + "/remap_cache").toStdString());
     HttpServer s(cfg);
-    if (!s.listen(QHostAddress::AnyIPv4, 8080)){
+    if (!s.listen(QHostAddress::AnyIPv4, port)){
         qWarning() << "Listen failed";
         return 1;
     }
-    qInfo() << "REST http://localhost:8080  (POST /measure, GET /specs/{id}, POST /specs)";
+    qInfo().noquote() << QString("REST http://localhost:%1  (POST /measure, GET /specs/{id}, POST /specs, GET /stats/{id})").arg(port);
     return app.exec();
 }
@@ -0,0 +1,202 @@
+#include "spc_store.h"
+#include <QDir>
+#include <QJsonArray>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+constexpr char kMagic[8] = {'M','P','S','P','C','0','0','1'};
+struct SpcHeader {
+  char magic[8];
+  uint32_t recordSize, capacity;
+  uint64_t total;          // records ever appended; next slot = total % capacity
+  SpcStats stats;
+  char metric[64];         // full names, NUL-terminated: they tell apart series
+  char specId[64];         // whose file names sanitise alike (empty in older files)
+};
+constexpr qint64 kHeaderBytes = 256;
+static_assert(sizeof(SpcHeader) <= kHeaderBytes, "SPC header must fit its slot");
+
+QString safeName(const QString& s){
+  QString out = s;
+  for (auto& c : out) if (!(c.isLetterOrNumber() || c=='_' || c=='-' || c=='.')) c = '_';
+  return out.isEmpty() || out.startsWith('.')? "_" + out : out;
+}
+
+// Series keys join spec id and metric with a character neither uses in practice
+QString seriesKey(const QString& specId, const QString& metric){ return specId + QChar(0x1f) + metric; }
+
+bool readHeader(const QString& path, SpcHeader& h){
+  QFile f(path);
+  if (!f.open(QIODevice::ReadOnly) || f.read(reinterpret_cast<char*>(&h), sizeof h) != (qint64)sizeof h) return false;
+  h.metric[sizeof h.metric - 1] = 0; h.specId[sizeof h.specId - 1] = 0;
+  return std::memcmp(h.magic, kMagic, sizeof kMagic) == 0;
+}
+
+bool owns(const SpcHeader& h, const QByteArray& specId, const QByteArray& metric){
+  return metric == h.metric && (!h.specId[0] || specId == h.specId);
+}
+}
+
+void SpcStats::add(double x, bool ok, double lo, double hi){
+  if (n == 0){ min = max = x; }
+  else {
+    min = std::min(min, x); max = std::max(max, x);
+    mrSum += std::abs(x - last); ++mrN;
+  }
+  ++n;
+  const double d = x - mean;
+  mean += d / double(n);
+  m2 += d * (x - mean);
+  last = x;
+  if (!ok) ++oot;
+  lsl = lo; usl = hi;
+}
+double SpcStats::stddev() const { return n > 1? std::sqrt(m2 / double(n-1)) : 0.0; }
+double SpcStats::sigmaShortTerm() const { return mrN > 0? (mrSum / double(mrN)) / 1.128 : 0.0; }
+
+static double capability(double mean, double sigma, double lsl, double usl){
+  if (!(sigma > 0)) return std::numeric_limits<double>::quiet_NaN();
+  double up = std::isfinite(usl)? (usl - mean) / (3*sigma) : std::numeric_limits<double>::infinity();
+  double lo = std::isfinite(lsl)? (mean - lsl) / (3*sigma) : std::numeric_limits<double>::infinity();
+  double c = std::min(up, lo);
+  return std::isfinite(c)? c : std::numeric_limits<double>::quiet_NaN();
+}
+double SpcStats::cp() const{
+  double s = sigmaShortTerm();
+  return (s > 0 && std::isfinite(lsl) && std::isfinite(usl))? (usl - lsl) / (6*s) : std::numeric_limits<double>::quiet_NaN();
+}
+double SpcStats::cpk() const { return capability(mean, sigmaShortTerm(), lsl, usl); }
+double SpcStats::ppk() const { return capability(mean, stddev(), lsl, usl); }
+
+struct SpcStore::Series {
+  QFile file;
+  SpcHeader* head = nullptr;
+  SpcRecord* ring = nullptr;
+  explicit Series(const QString& path): file(path) {}
+};
+
+SpcStore::SpcStore(const QString& dir, uint32_t capacity): dir_(dir), capacity_(std::max<uint32_t>(capacity, 1)){}
+SpcStore::~SpcStore() = default;
+
+SpcStore::Series* SpcStore::series(const QString& specId, const QString& metric, bool create){
+  const QString key = seriesKey(specId, metric);
+  if (auto it = series_.constFind(key); it != series_.constEnd()) return it.value().get();
+
+  // names are kept in full in the header, so longer ones are refused
+  const QByteArray id8 = specId.toUtf8(), m8 = metric.toUtf8();
+  if (id8.size() >= (int)sizeof(SpcHeader::specId) || m8.size() >= (int)sizeof(SpcHeader::metric)) return nullptr;
+  // names that sanitise alike share a base name; the first file whose header
+  // names this series is it, otherwise the first free (or unreadable) one
+  const QString sub = dir_ + "/" + safeName(specId);
+  QString path;
+  for (int i=0; path.isEmpty(); ++i){
+    const QString p = sub + "/" + safeName(metric) + (i? QString("~%1").arg(i) : QString()) + ".spc";
+    SpcHeader h;
+    if (!QFile::exists(p)){ if (!create) return nullptr; path = p; }
+    else if (readHeader(p, h)){ if (owns(h, id8, m8)) path = p; }
+    else if (create) path = p;
+  }
+  QDir().mkpath(sub);
+  auto s = std::make_shared<Series>(path);
+  if (!s->file.open(QIODevice::ReadWrite)) return nullptr;
+
+  qint64 bytes = s->file.size();
+  bool fresh = bytes < kHeaderBytes;
+  if (!fresh){
+    SpcHeader h;
+    if (s->file.read(reinterpret_cast<char*>(&h), sizeof h) != (qint64)sizeof h) return nullptr;
+    fresh = std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 || h.recordSize != sizeof(SpcRecord)
+         || bytes != kHeaderBytes + qint64(h.capacity) * (qint64)sizeof(SpcRecord);
+  }
+  if (fresh && !create) return nullptr;
+  if (fresh){
+    // new (or unreadable) series: lay out an empty ring
+    bytes = kHeaderBytes + qint64(capacity_) * (qint64)sizeof(SpcRecord);
+    if (!s->file.resize(0) || !s->file.resize(bytes)) return nullptr;
+  }
+  uchar* p = s->file.map(0, bytes);
+  if (!p) return nullptr;
+  s->head = reinterpret_cast<SpcHeader*>(p);
+  s->ring = reinterpret_cast<SpcRecord*>(p + kHeaderBytes);
+  if (fresh){
+    std::memset(p, 0, kHeaderBytes);
+    SpcHeader* h = s->head;
+    std::memcpy(h->magic, kMagic, sizeof kMagic);
+    h->recordSize = sizeof(SpcRecord); h->capacity = capacity_;
+    h->stats = SpcStats{};
+    std::memcpy(h->metric, m8.constData(), m8.size());
+  }
+  if (!s->head->specId[0]) std::memcpy(s->head->specId, id8.constData(), id8.size());
+  series_.insert(key, s);
+  return s.get();
+}
+
+bool SpcStore::append(const QString& specId, const QString& metric, double value, bool ok, double lsl, double usl, int64_t t_ms){
+  Series* s = series(specId, metric, true);
+  if (!s) return false;
+  SpcHeader* h = s->head;
+  s->ring[h->total % h->capacity] = SpcRecord{t_ms, value, ok? 1u : 0u, 0u};
+  ++h->total;
+  h->stats.add(value, ok, lsl, usl);
+  return true;
+}
+
+std::vector<SpcRecord> SpcStore::recent(const QString& specId, const QString& metric, int n){
+  std::vector<SpcRecord> out;
+  Series* s = series(specId, metric, false);
+  if (!s || n <= 0) return out;
+  const SpcHeader* h = s->head;
+  const uint64_t stored = std::min<uint64_t>(h->total, h->capacity);
+  const uint64_t k = std::min<uint64_t>(stored, uint64_t(n));
+  out.reserve(size_t(k));
+  for (uint64_t i = h->total - k; i < h->total; ++i) out.push_back(s->ring[i % h->capacity]);
+  return out;
+}
+
+const SpcStats* SpcStore::stats(const QString& specId, const QString& metric){
+  Series* s = series(specId, metric, false);
+  return s? &s->head->stats : nullptr;
+}
+
+void SpcStore::discover(const QString& specId){
+  // map series written by earlier runs; only the directory is listed
+  if (discovered_.value(specId)) return;
+  discovered_.insert(specId, true);
+  QDir d(dir_ + "/" + safeName(specId));
+  const QByteArray id8 = specId.toUtf8();
+  for (const QString& f : d.entryList({"*.spc"}, QDir::Files)){
+    SpcHeader h;
+    if (!readHeader(d.filePath(f), h) || (h.specId[0] && id8 != h.specId)) continue;   // another spec's series
+    series(specId, QString::fromUtf8(h.metric), false);
+  }
+}
+
+QJsonObject SpcStore::statsJson(const QString& specId){
+  discover(specId);
+  auto num = [](QJsonObject& o, const char* k, double v){ if (std::isfinite(v)) o[k] = v; };
+  QJsonArray arr;
+  const QString prefix = seriesKey(specId, QString());
+  QStringList keys = series_.keys();
+  std::sort(keys.begin(), keys.end());
+  for (const QString& key : keys){
+    if (!key.startsWith(prefix)) continue;
+    const SpcHeader* h = series_.value(key)->head;
+    const SpcStats& st = h->stats;
+    QJsonObject m;
+    m["name"] = key.mid(prefix.size());
+    m["n"] = qint64(st.n);
+    m["stored"] = qint64(std::min<uint64_t>(h->total, h->capacity));
+    m["oot"] = qint64(st.oot);
+    if (st.n > 0){
+      m["mean"] = st.mean; m["stddev"] = st.stddev(); m["min"] = st.min; m["max"] = st.max;
+      m["mr_mean"] = st.mrN? st.mrSum / double(st.mrN) : 0.0;
+    }
+    num(m, "lsl", st.lsl); num(m, "usl", st.usl);
+    num(m, "cp", st.cp()); num(m, "cpk", st.cpk()); num(m, "ppk", st.ppk());
+    arr.push_back(m);
+  }
+  return QJsonObject{{"spec_id", specId}, {"metrics", arr}};
+}
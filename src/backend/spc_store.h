@@ -0,0 +1,52 @@
+#pragma once
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Running statistics kept in each series header; every update is O(1).
+// Cpk uses the short-term sigma (mean moving range / d2), Ppk the overall one.
+struct SpcStats {
+  uint64_t n = 0, oot = 0, mrN = 0;
+  double mean = 0, m2 = 0, min = 0, max = 0, last = 0, mrSum = 0;
+  double lsl = std::numeric_limits<double>::quiet_NaN();  // latest limits, NaN when absent
+  double usl = std::numeric_limits<double>::quiet_NaN();
+  void add(double x, bool ok, double lo, double hi);
+  double stddev() const;         // overall (n-1)
+  double sigmaShortTerm() const; // MRbar / 1.128
+  double cp() const;
+  double cpk() const;
+  double ppk() const;
+};
+
+struct SpcRecord { int64_t t_ms; double value; uint32_t ok; uint32_t reserved; };
+
+// Per (spec_id, metric) history: a memory-mapped file holding a header with
+// SpcStats followed by a fixed-capacity ring of SpcRecord. Files live in
+// <dir>/<spec_id>/<metric>.spc and are mapped once, on first use. Names are
+// sanitised for the file system; the header keeps them in full, so names
+// that sanitise alike get <metric>~1.spc, ... Spec ids and metrics of 64
+// UTF-8 bytes or more are refused.
+class SpcStore {
+public:
+  explicit SpcStore(const QString& dir, uint32_t capacity = 65536);
+  ~SpcStore();
+  bool append(const QString& specId, const QString& metric, double value, bool ok, double lsl, double usl, int64_t t_ms);
+  // Latest `n` records, oldest first.
+  std::vector<SpcRecord> recent(const QString& specId, const QString& metric, int n);
+  const SpcStats* stats(const QString& specId, const QString& metric);
+  QJsonObject statsJson(const QString& specId);   // all metrics of one spec
+
+private:
+  struct Series;
+  Series* series(const QString& specId, const QString& metric, bool create);
+  void discover(const QString& specId);
+  QString dir_;
+  uint32_t capacity_;
+  QHash<QString, std::shared_ptr<Series>> series_;   // key: spec_id + '\x1f' + metric
+  QHash<QString, bool> discovered_;
+};
@@ -0,0 +1,92 @@
+#include "core/bayer.h"
+#include <opencv2/core/hal/intrin.hpp>
+namespace mp {
+namespace {
+// BT.601 luma weights in 1/256: 77 R + 2*75 G + 29 B = 256
+constexpr unsigned kR = 77, kG = 75, kB = 29;
+
+// the samples of one cell in R, G1, G2, B order
+template<class V>
+inline void cellRGB(BayerPattern p, const V& c00, const V& c01, const V& c10, const V& c11,
+                    V& r, V& g1, V& g2, V& b){
+  switch (p){
+  case BayerPattern::RG: r = c00; g1 = c01; g2 = c10; b = c11; break;
+  case BayerPattern::BG: b = c00; g1 = c01; g2 = c10; r = c11; break;
+  case BayerPattern::GR: g1 = c00; r = c01; b = c10; g2 = c11; break;
+  default:               g1 = c00; b = c01; r = c10; g2 = c11; break;   // GB
+  }
+}
+
+// cells 0..n-1 of the mosaic rows s0/s1 into d; returns the first cell left to do
+template<class T>
+int halfRowSimd(const T*, const T*, T*, int, BayerPattern, BayerReduce){ return 0; }
+
+#if CV_SIMD
+template<>
+int halfRowSimd<uchar>(const uchar* s0, const uchar* s1, uchar* d, int n, BayerPattern p, BayerReduce mode){
+  int x = 0;
+  const int VL = cv::v_uint8::nlanes;
+  const cv::v_uint16 wr = cv::vx_setall_u16(kR), wg = cv::vx_setall_u16(kG), wb = cv::vx_setall_u16(kB);
+  for (; x <= n-VL; x += VL){
+    cv::v_uint8 c00, c01, c10, c11, r, g1, g2, b;
+    cv::v_load_deinterleave(s0 + 2*x, c00, c01);
+    cv::v_load_deinterleave(s1 + 2*x, c10, c11);
+    cellRGB(p, c00, c01, c10, c11, r, g1, g2, b);
+    if (mode == BayerReduce::Green){ cv::v_store(d + x, cv::v_avg(g1, g2)); continue; }
+    // 16-bit sums peak at 256*255, so the weighted sum cannot overflow
+    cv::v_uint16 rl, rh, al, ah, bl, bh, gl, gh;
+    cv::v_expand(r, rl, rh); cv::v_expand(g1, al, ah); cv::v_expand(g2, gl, gh); cv::v_expand(b, bl, bh);
+    cv::v_store(d + x, cv::v_rshr_pack<8>(rl*wr + (al + gl)*wg + bl*wb, rh*wr + (ah + gh)*wg + bh*wb));
+  }
+  return x;
+}
+
+template<>
+int halfRowSimd<ushort>(const ushort* s0, const ushort* s1, ushort* d, int n, BayerPattern p, BayerReduce mode){
+  int x = 0;
+  const int VL = cv::v_uint16::nlanes;
+  const cv::v_uint32 wr = cv::vx_setall_u32(kR), wg = cv::vx_setall_u32(kG), wb = cv::vx_setall_u32(kB);
+  for (; x <= n-VL; x += VL){
+    cv::v_uint16 c00, c01, c10, c11, r, g1, g2, b;
+    cv::v_load_deinterleave(s0 + 2*x, c00, c01);
+    cv::v_load_deinterleave(s1 + 2*x, c10, c11);
+    cellRGB(p, c00, c01, c10, c11, r, g1, g2, b);
+    if (mode == BayerReduce::Green){ cv::v_store(d + x, cv::v_avg(g1, g2)); continue; }
+    cv::v_uint32 rl, rh, al, ah, bl, bh, gl, gh;
+    cv::v_expand(r, rl, rh); cv::v_expand(g1, al, ah); cv::v_expand(g2, gl, gh); cv::v_expand(b, bl, bh);
+    cv::v_store(d + x, cv::v_rshr_pack<8>(rl*wr + (al + gl)*wg + bl*wb, rh*wr + (ah + gh)*wg + bh*wb));
+  }
+  return x;
+}
+#endif
+
+template<class T>
+void halfRow(const T* s0, const T* s1, T* d, int n, BayerPattern p, BayerReduce mode){
+  for (int x = halfRowSimd<T>(s0, s1, d, n, p, mode); x < n; ++x){
+    unsigned r, g1, g2, b;
+    cellRGB<unsigned>(p, s0[2*x], s0[2*x+1], s1[2*x], s1[2*x+1], r, g1, g2, b);
+    d[x] = T(mode == BayerReduce::Green ? (g1 + g2 + 1) >> 1 : (kR*r + kG*(g1 + g2) + kB*b + 128) >> 8);
+  }
+}
+}
+
+BayerPattern bayerPattern(const std::string& name){
+  std::string s = name.rfind("Bayer", 0) == 0 ? name.substr(5, 2) : name;
+  if (s == "RG") return BayerPattern::RG;
+  if (s == "BG") return BayerPattern::BG;
+  if (s == "GR") return BayerPattern::GR;
+  if (s == "GB") return BayerPattern::GB;
+  return BayerPattern::None;
+}
+
+void bayerToHalfGray(const cv::Mat& raw, cv::Mat& out, BayerPattern p, BayerReduce mode){
+  CV_Assert(p != BayerPattern::None && raw.channels() == 1 && (raw.depth() == CV_8U || raw.depth() == CV_16U));
+  const cv::Mat src = raw;   // `out` may be `raw`
+  const int n = src.cols/2, h = src.rows/2;
+  out.create(h, n, src.type());
+  for (int y=0; y<h; ++y){
+    if (src.depth() == CV_8U) halfRow(src.ptr<uchar>(2*y), src.ptr<uchar>(2*y+1), out.ptr<uchar>(y), n, p, mode);
+    else halfRow(src.ptr<ushort>(2*y), src.ptr<ushort>(2*y+1), out.ptr<ushort>(y), n, p, mode);
+  }
+}
+}
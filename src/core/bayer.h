@@ -0,0 +1,21 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <string>
+namespace mp {
+// Raw colour-filter mosaics, named by the top-left 2x2 cell read row by row
+// as camera vendors do (BayerRG8 = R G / G B). OpenCV's COLOR_Bayer* codes
+// name the same layouts by their second row: RG here is COLOR_BayerBG2BGR.
+enum class BayerPattern { None = 0, RG, BG, GR, GB };
+enum class BayerReduce { Green, Luma };
+
+// "RG", "BG", "GR", "GB" (or "BayerRG8", ...) -> pattern; None otherwise.
+BayerPattern bayerPattern(const std::string& name);
+
+// One grey pixel per 2x2 cell, in a single pass over the mosaic: the mean of
+// the cell's two green samples, or BT.601 luma of its R, G and B. Replaces
+// demosaicing plus cvtColor for measurement input. The result has half the
+// mosaic's size (an odd last row or column is dropped) and its depth (8U or
+// 16U); 8U and 16U have their own vector kernels.
+void bayerToHalfGray(const cv::Mat& raw, cv::Mat& out, BayerPattern p,
+                     BayerReduce mode = BayerReduce::Green);
+}
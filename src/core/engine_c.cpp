@@ -0,0 +1,146 @@
+#include "core/engine_c.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <opencv2/imgproc.hpp>
+#include <exception>
+#include <string>
+#include "core/measurement_engine.h"
+
+using namespace mp;
+
+struct mp_engine { MeasurementEngine engine; };
+struct mp_session {
+  mp_engine* owner;
+  MeasurementEngine::Session session;
+  std::vector<Item> items;
+  std::vector<SpecLimits> limits;
+  Pose pose;
+  cv::Mat converted;        // BGRA -> BGR or Bayer -> half-size grey, reused across calls
+  uint64_t convertedId = 0; // image_id of a converted Bayer frame, 0 = none
+  int convertedAs = -1;     // pattern and bayer_reduce it was converted with
+};
+
+namespace {
+thread_local std::string g_error;
+
+int fail(int code, const char* what){ g_error = what; return code; }
+
+template<class F> int guarded(F&& f){
+  try { return f(); }
+  catch (const std::exception& ex){ return fail(MP_E_INTERNAL, ex.what()); }
+  catch (...){ return fail(MP_E_INTERNAL, "unknown exception"); }
+}
+}
+
+extern "C" {
+
+int mp_engine_abi_version(void){ return MP_ENGINE_ABI_VERSION; }
+
+mp_engine* mp_engine_create(void){
+  try { return new mp_engine(); }
+  catch (...){ g_error = "out of memory"; return nullptr; }
+}
+
+void mp_engine_destroy(mp_engine* e){ delete e; }
+
+int mp_engine_put_spec(mp_engine* e, const char* id, const char* spec_json, size_t len){
+  if (!e || !id || !spec_json) return fail(MP_E_ARG, "null argument");
+  return guarded([&]() -> int {
+    const QJsonDocument doc = QJsonDocument::fromJson(QByteArray(spec_json, (qsizetype)len));
+    if (!doc.isObject()) return fail(MP_E_SPEC, "spec is not a JSON object");
+    e->engine.putSpec(id, doc.object());
+    return MP_OK;
+  });
+}
+
+mp_session* mp_session_create(mp_engine* e){
+  if (!e){ g_error = "null engine"; return nullptr; }
+  try { return new mp_session{e, {}, {}, {}, {}}; }
+  catch (...){ g_error = "out of memory"; return nullptr; }
+}
+
+void mp_session_destroy(mp_session* s){ delete s; }
+
+int mp_measure(mp_session* s, const char* spec_id, const mp_image* img, const mp_roi* roi,
+               uint64_t image_id, mp_metric* out, int32_t capacity, int32_t* count){
+  if (!s || !spec_id || !img || !img->data || !count || (capacity > 0 && !out)) return fail(MP_E_ARG, "null argument");
+  if (img->width <= 0 || img->height <= 0) return fail(MP_E_ARG, "empty image");
+  int type = -1, bpp = 0, bits = 0;
+  BayerPattern bayer = BayerPattern::None;
+  switch (img->format){
+    case MP_PIXEL_GRAY8:  type = CV_8UC1; bpp = 1; break;
+    case MP_PIXEL_BGR8:   type = CV_8UC3; bpp = 3; break;
+    case MP_PIXEL_BGRA8:  type = CV_8UC4; bpp = 4; break;
+    case MP_PIXEL_GRAY16: type = CV_16UC1; bpp = 2; break;
+    case MP_PIXEL_GRAY12: type = CV_16UC1; bpp = 2; bits = 12; break;
+    case MP_PIXEL_GRAY10: type = CV_16UC1; bpp = 2; bits = 10; break;
+    case MP_PIXEL_BAYER_RG8: type = CV_8UC1; bpp = 1; bayer = BayerPattern::RG; break;
+    case MP_PIXEL_BAYER_BG8: type = CV_8UC1; bpp = 1; bayer = BayerPattern::BG; break;
+    case MP_PIXEL_BAYER_GR8: type = CV_8UC1; bpp = 1; bayer = BayerPattern::GR; break;
+    case MP_PIXEL_BAYER_GB8: type = CV_8UC1; bpp = 1; bayer = BayerPattern::GB; break;
+    default: return fail(MP_E_ARG, "unknown pixel format");
+  }
+  if (img->stride < img->width*bpp) return fail(MP_E_ARG, "stride too small");
+  std::shared_ptr<const MeasureSpec> spec = s->owner->engine.spec(spec_id);
+  if (!spec) return fail(MP_E_SPEC, "unknown spec id");
+  if (bits && !spec->bitDepth){
+    auto packed = std::make_shared<MeasureSpec>(*spec);
+    packed->setBitDepth(bits);
+    spec = packed;
+  }
+
+  return guarded([&]() -> int {
+    // wraps the caller's pixels; nothing is copied
+    const cv::Mat view(img->height, img->width, type, const_cast<void*>(img->data), (size_t)img->stride);
+    const bool convert = type == CV_8UC4 || bayer != BayerPattern::None;
+    uint64_t frameId = image_id;
+    if (type == CV_8UC4){ cv::cvtColor(view, s->converted, cv::COLOR_BGRA2BGR); s->convertedId = 0; }
+    else if (convert){
+      // the half-size grey depends on the spec's bayer_reduce as well as on the
+      // raw pixels, so a frame is only reused for the same id and reduction
+      const int as = int(bayer)*2 + int(spec->bayerReduce);
+      if (image_id == 0 || image_id != s->convertedId || as != s->convertedAs){
+        bayerToHalfGray(view, s->converted, bayer, spec->bayerReduce);
+        if (image_id != 0 && image_id == s->convertedId) frameId = 0;   // same id, other pixels: no cached edges
+        s->convertedId = image_id; s->convertedAs = as;
+      }
+    }
+    const cv::Mat& frame = convert ? s->converted : view;
+
+    MeasureRoi r;
+    if (roi){
+      switch (roi->type){
+        case MP_ROI_FULL: break;
+        case MP_ROI_RECT: r.kind = MeasureRoi::Kind::Rect; r.rect = cv::Rect(roi->x, roi->y, roi->w, roi->h); break;
+        case MP_ROI_RING:
+          r.kind = MeasureRoi::Kind::Ring; r.center = cv::Point(roi->cx, roi->cy);
+          r.rInner = roi->r_in; r.rOuter = roi->r_out;
+          break;
+        case MP_ROI_POLYGON:
+          if (!roi->points || roi->npoints < 3) return fail(MP_E_ARG, "polygon needs 3 points");
+          r.kind = MeasureRoi::Kind::Polygon;
+          for (int i=0;i<roi->npoints;++i) r.polygon.emplace_back(roi->points[2*i], roi->points[2*i+1]);
+          break;
+        default: return fail(MP_E_ARG, "unknown roi type");
+      }
+    }
+    s->session.measure(frame, *spec, r, s->items, s->limits, frameId, &s->pose);
+
+    *count = (int32_t)s->items.size();
+    for (int32_t i=0; i<*count && i<capacity; ++i){
+      const Item& it = s->items[i];
+      out[i] = mp_metric{it.name.c_str(), it.unit.c_str(), it.value, s->limits[i].lsl, s->limits[i].usl, it.ok ? 1 : 0};
+    }
+    return *count > capacity ? fail(MP_E_CAPACITY, "more metrics than capacity") : MP_OK;
+  });
+}
+
+int mp_last_pose(const mp_session* s, mp_pose* out){
+  if (!s || !out) return fail(MP_E_ARG, "null argument");
+  *out = mp_pose{s->pose.center.x, s->pose.center.y, s->pose.angleDeg, s->pose.score, s->pose.found ? 1 : 0};
+  return MP_OK;
+}
+
+const char* mp_last_error(void){ return g_error.c_str(); }
+
+}
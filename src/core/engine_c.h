@@ -0,0 +1,102 @@
+#pragma once
+/* C ABI of the measurement engine, for line software that embeds it in its
+ * own process. Images are passed as raw pixel pointers and results come
+ * back as plain structs: no serialisation, no sockets, no C++ types.
+ *
+ * Handles are opaque. One engine may be shared by all threads; each thread
+ * that measures needs its own session. Strings in results stay valid until
+ * the next mp_measure() on the same session. Functions returning int give
+ * MP_OK or a negative MP_E* code; mp_last_error() describes the last failure
+ * on the calling thread. */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(MP_ENGINE_SHARED)
+#  ifdef MP_ENGINE_BUILD
+#    define MP_ENGINE_API __declspec(dllexport)
+#  else
+#    define MP_ENGINE_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define MP_ENGINE_API __attribute__((visibility("default")))
+#else
+#  define MP_ENGINE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MP_ENGINE_ABI_VERSION 1
+
+enum { MP_OK = 0, MP_E_ARG = -1, MP_E_SPEC = -2, MP_E_CAPACITY = -3, MP_E_INTERNAL = -4 };
+/* GRAY10/12/16 are 16-bit little-endian words, LSB-aligned; GRAY10/12 set the
+ * spec's bit depth for the call unless the spec sets "bit_depth" itself.
+ * BAYER_*8 are raw 8-bit mosaics named as in GenICam (RG8 = R G / G B). They
+ * are measured as a half-size grey image (the spec's "bayer_reduce": green
+ * or luma), so ROIs and the spec's mm_per_px refer to half-size pixels. */
+enum { MP_PIXEL_GRAY8 = 0, MP_PIXEL_BGR8 = 1, MP_PIXEL_BGRA8 = 2,
+       MP_PIXEL_GRAY16 = 3, MP_PIXEL_GRAY12 = 4, MP_PIXEL_GRAY10 = 5,
+       MP_PIXEL_BAYER_RG8 = 6, MP_PIXEL_BAYER_BG8 = 7, MP_PIXEL_BAYER_GR8 = 8, MP_PIXEL_BAYER_GB8 = 9 };
+enum { MP_ROI_FULL = 0, MP_ROI_RECT = 1, MP_ROI_RING = 2, MP_ROI_POLYGON = 3 };
+
+typedef struct mp_engine mp_engine;
+typedef struct mp_session mp_session;
+
+typedef struct mp_image {
+  const void* data;       /* not copied; must stay valid during mp_measure() */
+  int32_t width, height;
+  int32_t stride;         /* bytes per row */
+  int32_t format;         /* MP_PIXEL_* */
+} mp_image;
+
+typedef struct mp_roi {
+  int32_t type;                          /* MP_ROI_* */
+  int32_t x, y, w, h;                    /* RECT */
+  int32_t cx, cy, r_in, r_out;           /* RING */
+  const int32_t* points; int32_t npoints; /* POLYGON: x0,y0,x1,y1,... */
+} mp_roi;
+
+typedef struct mp_metric {
+  const char* name;       /* "line_gap", "diameter_A", ... as in the REST report */
+  const char* unit;
+  double value;
+  double lsl, usl;        /* NaN where the spec has no limit */
+  int32_t ok;
+} mp_metric;
+
+/* Part pose from the spec's locator: where the trained region's centre
+ * landed (px) and its rotation (deg). found = 0 when the part was not found
+ * or the spec has no locator. */
+typedef struct mp_pose {
+  double x, y, angle_deg, score;
+  int32_t found;
+} mp_pose;
+
+MP_ENGINE_API int mp_engine_abi_version(void);
+MP_ENGINE_API mp_engine* mp_engine_create(void);
+MP_ENGINE_API void mp_engine_destroy(mp_engine* e);
+/* Prepares a spec (JSON text, same keys as config/specs.json) under `id`,
+ * replacing any spec of that id. */
+MP_ENGINE_API int mp_engine_put_spec(mp_engine* e, const char* id, const char* spec_json, size_t len);
+
+MP_ENGINE_API mp_session* mp_session_create(mp_engine* e);
+MP_ENGINE_API void mp_session_destroy(mp_session* s);
+
+/* Measures `img` inside `roi` (NULL = full frame) with spec `spec_id`.
+ * `image_id` != 0 declares equal ids to be equal pixels, so several ROIs of
+ * one image share its edge map (and, for Bayer input, its half-size grey
+ * frame while the specs agree on "bayer_reduce"). Writes up to `capacity` metrics to `out`;
+ * `*count` receives the number produced (MP_E_CAPACITY if it exceeds
+ * `capacity`). */
+MP_ENGINE_API int mp_measure(mp_session* s, const char* spec_id, const mp_image* img, const mp_roi* roi,
+                             uint64_t image_id, mp_metric* out, int32_t capacity, int32_t* count);
+
+/* Pose of the last mp_measure() on `s`; it is reported here, not as a metric. */
+MP_ENGINE_API int mp_last_pose(const mp_session* s, mp_pose* out);
+
+MP_ENGINE_API const char* mp_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+#include "core/frame_ring.h"
+#include <cstring>
+#include <new>
+namespace mp {
+namespace {
+constexpr char kMagic[8] = {'M','P','R','I','N','G','0','1'};
+inline size_t slotBytes(const FrameRingHeader* r){ return size_t(r->step)*r->height; }
+inline const uint8_t* slotPtr(const FrameRingHeader* r, uint64_t i){
+  return reinterpret_cast<const uint8_t*>(r + 1) + (i % r->slots)*slotBytes(r);
+}
+}
+
+size_t frameRingBytes(cv::Size size, int type, int slots){
+  return sizeof(FrameRingHeader) + size_t(slots)*size.height*size.width*CV_ELEM_SIZE(type);
+}
+
+FrameRingHeader* frameRingInit(void* mem, cv::Size size, int type, int slots, BayerPattern bayer){
+  CV_Assert(mem && size.width>0 && size.height>0 && slots>=2);
+  CV_Assert(bayer == BayerPattern::None || CV_MAT_CN(type) == 1);
+  auto r = new (mem) FrameRingHeader{};
+  std::memcpy(r->magic, kMagic, sizeof kMagic);
+  r->width = size.width; r->height = size.height; r->type = type;
+  r->step = uint32_t(size.width*CV_ELEM_SIZE(type)); r->slots = slots; r->bayer = uint32_t(bayer);
+  r->seq.store(0, std::memory_order_release);
+  return r;
+}
+
+const FrameRingHeader* frameRingAttach(const void* mem, size_t bytes){
+  if (!mem || bytes < sizeof(FrameRingHeader)) return nullptr;
+  auto r = static_cast<const FrameRingHeader*>(mem);
+  if (std::memcmp(r->magic, kMagic, sizeof kMagic)!=0 || r->width==0 || r->height==0 || r->slots<2) return nullptr;
+  if (r->step < r->width*uint32_t(CV_ELEM_SIZE(r->type))) return nullptr;
+  if (r->bayer > uint32_t(BayerPattern::GB) || (r->bayer && CV_MAT_CN(r->type) != 1)) return nullptr;
+  if (bytes < sizeof(FrameRingHeader) + r->slots*slotBytes(r)) return nullptr;
+  return r;
+}
+
+uint64_t frameRingPush(FrameRingHeader* ring, const cv::Mat& frame){
+  CV_Assert(frame.type()==ring->type && frame.cols==(int)ring->width && frame.rows==(int)ring->height);
+  const uint64_t s = ring->seq.load(std::memory_order_relaxed);
+  uint8_t* dst = const_cast<uint8_t*>(slotPtr(ring, s));
+  // keeps the pixel writes after the previous publish, so a reader that saw
+  // any of them also sees seq >= s on its re-check
+  std::atomic_thread_fence(std::memory_order_release);
+  const size_t row = size_t(frame.cols)*frame.elemSize();
+  for (int y=0; y<frame.rows; ++y) std::memcpy(dst + size_t(y)*ring->step, frame.ptr(y), row);
+  ring->seq.store(s + 1, std::memory_order_release);
+  return s + 1;
+}
+
+bool frameRingLatest(const FrameRingHeader* ring, cv::Mat& out, uint64_t& lastSeq){
+  const uint64_t s = ring->seq.load(std::memory_order_acquire);
+  if (s == 0 || s == lastSeq) return false;
+  out.create((int)ring->height, (int)ring->width, ring->type);
+  const uint8_t* src = slotPtr(ring, s - 1);
+  const size_t row = size_t(out.cols)*out.elemSize();
+  for (int y=0; y<out.rows; ++y) std::memcpy(out.ptr(y), src + size_t(y)*ring->step, row);
+  // the copy must complete before seq is read again (seqlock re-check); the
+  // slot is rewritten once the producer has moved `slots - 1` frames past it
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (ring->seq.load(std::memory_order_relaxed) - s >= ring->slots - 1) return false;
+  lastSeq = s;
+  return true;
+}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "core/bayer.h"
+
+namespace mp {
+// Single-producer frame ring laid out in one flat block of memory, meant to
+// live in shared memory between a camera process and the GUI/backend.
+// The block is a 64-byte header followed by `slots` frames of
+// rows*step bytes each. The producer fills slot seq % slots and then
+// publishes seq+1. Readers copy the newest frame and treat it as torn if
+// the producer lapped them while they were copying. Raw Bayer frames are
+// 8UC1/16UC1 with `bayer` naming their mosaic, a third of the bytes of BGR.
+struct FrameRingHeader {
+  char magic[8];                 // "MPRING01"
+  uint32_t width, height;
+  int32_t type;                  // OpenCV type, e.g. CV_8UC3
+  uint32_t step;                 // bytes per row
+  uint32_t slots;
+  uint32_t bayer;                // BayerPattern of raw mosaic frames, 0 = none
+  std::atomic<uint64_t> seq;     // frames published so far
+  uint8_t pad[64 - 8 - 6*4 - 8];
+};
+static_assert(sizeof(FrameRingHeader)==64, "frame ring header must stay 64 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "frame ring needs lock-free 64-bit atomics");
+
+size_t frameRingBytes(cv::Size size, int type, int slots);
+// Formats `mem` (frameRingBytes() long) as an empty ring.
+FrameRingHeader* frameRingInit(void* mem, cv::Size size, int type, int slots,
+                               BayerPattern bayer = BayerPattern::None);
+// Checks magic and geometry of an existing ring of `bytes` bytes; nullptr if invalid.
+const FrameRingHeader* frameRingAttach(const void* mem, size_t bytes);
+// Producer: copies `frame` into the next slot and publishes it. Returns its sequence number.
+uint64_t frameRingPush(FrameRingHeader* ring, const cv::Mat& frame);
+// Reader: copies the newest frame into `out` if it is newer than `lastSeq`.
+// Returns false if there is nothing new or the copy was overwritten.
+bool frameRingLatest(const FrameRingHeader* ring, cv::Mat& out, uint64_t& lastSeq);
+}
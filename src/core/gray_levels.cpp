@@ -0,0 +1,51 @@
+#include "core/gray_levels.h"
+#include <opencv2/imgproc.hpp>
+#include <vector>
+namespace mp {
+
+double fullScale(int depth, int bits){
+  switch (depth){
+  case CV_8U:  return 255.0;
+  case CV_16U: return bits > 0 && bits < 16 ? double((1 << bits) - 1) : 65535.0;
+  default:     return 1.0;   // float data is taken as normalised
+  }
+}
+
+void cannyEdges(const cv::Mat& gray, cv::Mat& edges, double low, double high, int aperture, bool L2, int bits){
+  CV_Assert(gray.channels()==1);
+  if (gray.depth()==CV_8U){ cv::Canny(gray, edges, low, high, aperture, L2); return; }
+  CV_Assert(aperture==3);
+  // |Sobel| <= 4 * full scale, i.e. <= 4*255*8 = 8160 in 1/8 levels
+  constexpr double kSub = 8.0;
+  const double g = kSub / levelScale(gray.depth(), bits);
+  cv::Mat fx, fy, dx, dy;
+  cv::Sobel(gray, fx, CV_32F, 1, 0, 3, g, 0, cv::BORDER_REPLICATE);
+  cv::Sobel(gray, fy, CV_32F, 0, 1, 3, g, 0, cv::BORDER_REPLICATE);
+  fx.convertTo(dx, CV_16S); fy.convertTo(dy, CV_16S);
+  cv::Canny(dx, dy, edges, low*kSub, high*kSub, L2);
+}
+
+double otsuLevel(const cv::Mat& gray){
+  CV_Assert(gray.type()==CV_8UC1 || gray.type()==CV_16UC1);
+  if (gray.depth()==CV_8U){ cv::Mat tmp; return cv::threshold(gray, tmp, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU); }
+  std::vector<double> hist(65536, 0.0);
+  for (int y=0; y<gray.rows; ++y){
+    const ushort* p = gray.ptr<ushort>(y);
+    for (int x=0; x<gray.cols; ++x) ++hist[p[x]];
+  }
+  double total = double(gray.rows)*gray.cols, sum = 0;
+  for (int i=0; i<65536; ++i) sum += i*hist[i];
+  // maximise the between-class variance
+  double wB = 0, sumB = 0, best = -1, level = 0;
+  for (int t=0; t<65536; ++t){
+    wB += hist[t];
+    if (wB == 0) continue;
+    const double wF = total - wB;
+    if (wF <= 0) break;
+    sumB += t*hist[t];
+    const double d = sumB/wB - (sum - sumB)/wF, v = wB*wF*d*d;
+    if (v > best){ best = v; level = t; }
+  }
+  return level;
+}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <opencv2/core.hpp>
+namespace mp {
+// Grey levels of 8-bit and 16-bit mono data. 10/12-bit cameras deliver
+// LSB-aligned 16-bit pixels; `bits` is the number of significant bits
+// (0 = the whole depth). Thresholds across ops and edge detectors are given
+// on the 8-bit scale and multiplied by levelScale(), so one spec serves
+// 8-bit and high-bit-depth cameras alike.
+double fullScale(int depth, int bits = 0);
+inline double levelScale(int depth, int bits = 0){ return fullScale(depth, bits) / 255.0; }
+
+// cv::Canny for 8U and 16U single-channel images, thresholds on the 8-bit
+// scale. 16-bit gradients are taken at full precision and scaled into the
+// 16S range cv::Canny expects (1/8 of an 8-bit level), instead of
+// converting the image to 8 bits first. 16-bit input needs aperture 3.
+void cannyEdges(const cv::Mat& gray, cv::Mat& edges, double low, double high,
+                int aperture = 3, bool L2 = true, int bits = 0);
+
+// Otsu level of an 8U or 16U single-channel image (pixels > level are foreground).
+double otsuLevel(const cv::Mat& gray);
+}
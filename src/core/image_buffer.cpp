@@ -0,0 +1,55 @@
+#include "core/image_buffer.h"
+namespace mp {
+
+QImage::Format qimageFormatFor(int cvType){
+  switch (cvType){
+  case CV_8UC1:  return QImage::Format_Grayscale8;
+  case CV_16UC1: return QImage::Format_Grayscale16;
+  case CV_8UC3:  return QImage::Format_BGR888;
+  case CV_8UC4:  return QImage::Format_ARGB32;   // B,G,R,A bytes on little-endian
+  default:       return QImage::Format_Invalid;
+  }
+}
+
+ImageBuffer::ImageBuffer(const cv::Mat& m): mat_(m) {}
+
+ImageBuffer ImageBuffer::fromQImage(const QImage& img){
+  ImageBuffer b;
+  if (img.isNull()) return b;
+  int type = -1;
+  switch (img.format()){
+  case QImage::Format_Grayscale8:  type = CV_8UC1; break;
+  case QImage::Format_Grayscale16: type = CV_16UC1; break;
+  case QImage::Format_BGR888:      type = CV_8UC3; break;
+  case QImage::Format_ARGB32:
+  case QImage::Format_RGB32:       type = CV_8UC4; break;
+  default: break;
+  }
+  if (type < 0){
+    // one conversion to the native 3-channel order; the buffer owns the result
+    b.owner_ = img.convertToFormat(QImage::Format_BGR888);
+    type = CV_8UC3;
+  } else {
+    b.owner_ = img;
+  }
+  // constBits() never detaches, so the Mat aliases the QImage's pixels
+  b.mat_ = cv::Mat(b.owner_.height(), b.owner_.width(), type,
+                   const_cast<uchar*>(b.owner_.constBits()), (size_t)b.owner_.bytesPerLine());
+  return b;
+}
+
+ImageBuffer ImageBuffer::read(const std::string& path, int flags){
+  return ImageBuffer(cv::imread(path, flags));
+}
+
+QImage ImageBuffer::qimage() const{
+  if (mat_.empty()) return QImage();
+  if (!owner_.isNull()) return owner_;
+  const QImage::Format fmt = qimageFormatFor(mat_.type());
+  CV_Assert(fmt != QImage::Format_Invalid);
+  // the QImage keeps a Mat header (and with it the refcount) until it is destroyed
+  auto* hold = new cv::Mat(mat_);
+  return QImage(static_cast<const uchar*>(hold->data), hold->cols, hold->rows, (qsizetype)hold->step, fmt,
+                [](void* p){ delete static_cast<cv::Mat*>(p); }, hold);
+}
+}
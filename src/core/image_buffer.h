@@ -0,0 +1,37 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <QImage>
+#include <string>
+
+namespace mp {
+// Ref-counted pixels viewable as cv::Mat and as QImage without copying.
+// Channel order stays native: 8UC3 is BGR (QImage::Format_BGR888), 8UC4
+// is BGRA (Format_ARGB32), 8UC1/16UC1 are Grayscale8/16. Views are
+// read-only by contract; a QImage view detaches (copies) if painted on.
+class ImageBuffer {
+public:
+  ImageBuffer() = default;
+  explicit ImageBuffer(const cv::Mat& m);            // shares m's data
+  // Shares img's pixels when its format maps onto a Mat type, converts once otherwise.
+  static ImageBuffer fromQImage(const QImage& img);
+  // Decodes at the file's own depth and channel count: 16-bit mono stays 16UC1.
+  static ImageBuffer read(const std::string& path, int flags = cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
+
+  bool empty() const { return mat_.empty(); }
+  int width() const { return mat_.cols; }
+  int height() const { return mat_.rows; }
+
+  // Valid while this buffer, a copy of it, or a view taken from it is alive.
+  const cv::Mat& mat() const { return mat_; }
+  // Holds its own reference, so it may outlive the buffer.
+  QImage qimage() const;
+
+private:
+  cv::Mat mat_;
+  QImage owner_;   // set when the pixels belong to a QImage
+};
+
+// QImage format for a Mat type, or QImage::Format_Invalid if there is none.
+QImage::Format qimageFormatFor(int cvType);
+}
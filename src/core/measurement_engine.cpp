@@ -0,0 +1,588 @@
+#include "core/measurement_engine.h"
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QString>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include "measure/gauges.h"
+#include "measure/perspective.h"
+#include "ops/canny.h"
+#include "ops/morph.h"
+#include "ops/threshold.h"
+
+namespace mp {
+namespace {
+void toGray(const cv::Mat& m, cv::Mat& out){
+  if (m.channels()==3) cv::cvtColor(m, out, cv::COLOR_BGR2GRAY); else out = m;
+}
+
+// "diameter" selects diameter_A, "line_gap" selects line_gap
+bool gaugeSelected(const std::vector<std::string>& gauges, const std::string& item){
+  if (gauges.empty()) return true;
+  for (auto& g : gauges)
+    if (item.compare(0, g.size(), g)==0 && (item.size()==g.size() || item[g.size()]=='_')) return true;
+  return false;
+}
+
+// Optional robust fitting: "robust_fit": {"enabled": true, "threshold_px": 1.0, ...}
+bool robustFitParams(const QJsonObject& specs, RobustFitParams& prm){
+  auto o = specs.value("robust_fit").toObject();
+  if (!o.value("enabled").toBool(false)) return false;
+  prm.inlierThresholdPx = o.value("threshold_px").toDouble(prm.inlierThresholdPx);
+  prm.confidence = o.value("confidence").toDouble(prm.confidence);
+  prm.maxIterations = o.value("max_iterations").toInt(prm.maxIterations);
+  prm.irlsIterations = o.value("irls_iterations").toInt(prm.irlsIterations);
+  prm.lossScalePx = o.value("loss_scale_px").toDouble(prm.lossScalePx);
+  prm.loss = o.value("loss").toString("tukey")=="huber"? RobustFitParams::Loss::Huber : RobustFitParams::Loss::Tukey;
+  return true;
+}
+
+// Optional coarse-to-fine mode: "pyramid": {"enabled": true, "levels": 2, "band_px": 0}
+bool pyramidParams(const QJsonObject& specs, PyramidParams& prm){
+  auto o = specs.value("pyramid").toObject();
+  if (!o.value("enabled").toBool(false)) return false;
+  prm.levels = std::clamp(o.value("levels").toInt(prm.levels), 1, 4);
+  prm.bandPx = (float)o.value("band_px").toDouble(prm.bandPx);
+  return true;
+}
+
+// Optional sub-pixel edge chains: "subpixel": {"enabled": true, "sigma": 1.0, "low": 8, "high": 20}
+bool subpixelParams(const QJsonObject& specs, SubpixelEdgeParams& prm){
+  auto o = specs.value("subpixel").toObject();
+  if (!o.value("enabled").toBool(false)) return false;
+  prm.sigma = o.value("sigma").toDouble(prm.sigma);
+  prm.low = (float)o.value("low").toDouble(prm.low);
+  prm.high = (float)o.value("high").toDouble(prm.high);
+  prm.minLength = o.value("min_length").toInt(prm.minLength);
+  return true;
+}
+
+// Optional sparse edge points: "edge_points": {"enabled": true, "threshold": 100}
+bool edgePointParams(const QJsonObject& specs, EdgePointParams& prm){
+  auto o = specs.value("edge_points").toObject();
+  if (!o.value("enabled").toBool(false)) return false;
+  prm.threshold = (float)o.value("threshold").toDouble(prm.threshold);
+  return true;
+}
+
+// Optional polar ring search for ring ROIs:
+// "polar_ring": {"enabled": true, "angles": 720, "step": 0.5, "threshold": 20, "max_jump_px": 1.5}
+bool polarRingParams(const QJsonObject& specs, PolarRingParams& prm){
+  auto o = specs.value("polar_ring").toObject();
+  if (!o.value("enabled").toBool(false)) return false;
+  prm.angles = std::clamp(o.value("angles").toInt(prm.angles), 8, 8192);
+  prm.step = (float)std::clamp(o.value("step").toDouble(prm.step), 0.1, 2.0);
+  prm.threshold = (float)o.value("threshold").toDouble(prm.threshold);
+  prm.maxJumpPx = (float)o.value("max_jump_px").toDouble(prm.maxJumpPx);
+  return true;
+}
+
+// Optional part locator:
+// "locator": {"enabled": true, "reference_image": "...", "region": [x,y,w,h], "angle_range_deg": 15, "min_score": 0.6}.
+// The model is trained once per locator block and reused.
+std::shared_ptr<const ShapeLocator> partLocator(const QJsonObject& specs){
+  auto o = specs.value("locator").toObject();
+  if (!o.value("enabled").toBool(false)) return nullptr;
+  static std::mutex mtx;
+  static QHash<QByteArray, std::shared_ptr<const ShapeLocator>> cache;
+  QByteArray key = QJsonDocument(o).toJson(QJsonDocument::Compact);
+  std::lock_guard<std::mutex> lk(mtx);
+  if (auto it = cache.constFind(key); it != cache.constEnd()) return it.value();
+
+  cv::Mat ref = cv::imread(o.value("reference_image").toString().toStdString(), cv::IMREAD_GRAYSCALE);
+  QJsonArray r = o.value("region").toArray();
+  if (ref.empty() || r.size() != 4) return nullptr;
+  LocatorParams prm;
+  prm.angleRangeDeg = o.value("angle_range_deg").toDouble(prm.angleRangeDeg);
+  prm.minScore = o.value("min_score").toDouble(prm.minScore);
+  auto loc = std::make_shared<ShapeLocator>();
+  if (!loc->train(ref, cv::Rect(r.at(0).toInt(), r.at(1).toInt(), r.at(2).toInt(), r.at(3).toInt()), prm)) return nullptr;
+  if (cache.size() >= 16) cache.clear();
+  cache.insert(key, loc);
+  return loc;
+}
+}
+
+// ---- MeasureRoi --------------------------------------------------------------
+
+MeasureRoi MeasureRoi::fromJson(const QJsonObject& roi){
+  MeasureRoi r;
+  const QString type = roi.value("type").toString();
+  if (type == "rect"){
+    r.kind = Kind::Rect;
+    r.rect = cv::Rect(roi.value("x").toInt(), roi.value("y").toInt(), roi.value("w").toInt(), roi.value("h").toInt());
+  } else if (type == "polygon"){
+    r.kind = Kind::Polygon;
+    for (auto v : roi.value("points").toArray()){
+      auto a = v.toArray();
+      r.polygon.emplace_back(a.at(0).toInt(), a.at(1).toInt());
+    }
+  } else if (type == "ring"){
+    r.kind = Kind::Ring;
+    r.center = cv::Point(roi.value("cx").toInt(), roi.value("cy").toInt());
+    r.rInner = roi.value("r_in").toInt();
+    r.rOuter = roi.value("r_out").toInt();
+  }
+  return r;
+}
+
+MeasureRoi MeasureRoi::transformed(const cv::Matx23d& T) const{
+  auto map = [&](double x, double y){
+    return cv::Point(cvRound(T(0,0)*x + T(0,1)*y + T(0,2)), cvRound(T(1,0)*x + T(1,1)*y + T(1,2)));
+  };
+  MeasureRoi out = *this;
+  if (kind == Kind::Rect){
+    const cv::Rect& b = rect;
+    if (std::abs(T(0,1)) < 1e-4){
+      out.rect = cv::Rect(map(b.x, b.y), b.size());
+    } else {
+      out.kind = Kind::Polygon;
+      out.polygon = {map(b.x, b.y), map(b.x+b.width, b.y), map(b.x+b.width, b.y+b.height), map(b.x, b.y+b.height)};
+    }
+  } else if (kind == Kind::Polygon){
+    for (auto& p : out.polygon) p = map(p.x, p.y);
+  } else if (kind == Kind::Ring){
+    out.center = map(center.x, center.y);
+  } else if (kind == Kind::Mask){
+    out.rect = cv::Rect(map(rect.x, rect.y), rect.size());   // follows the part's position only
+  }
+  return out;
+}
+
+cv::Rect MeasureRoi::bounds(cv::Size image) const{
+  const cv::Rect full(cv::Point(), image);
+  switch (kind){
+    case Kind::Full: return full;
+    case Kind::Rect: case Kind::Mask: return rect & full;
+    case Kind::Polygon: return polygon.size() >= 3 ? cv::boundingRect(polygon) & full : cv::Rect();
+    case Kind::Ring: return cv::Rect(center.x - rOuter, center.y - rOuter, 2*rOuter + 1, 2*rOuter + 1) & full;
+  }
+  return cv::Rect();
+}
+
+void MeasureRoi::render(cv::Mat& m, const cv::Rect& area) const{
+  m.create(area.size(), CV_8UC1);
+  if (kind == Kind::Full){ m.setTo(255); return; }
+  m.setTo(0);
+  const cv::Point o = -area.tl();
+  if (kind == Kind::Rect){
+    cv::rectangle(m, rect + o, cv::Scalar(255), cv::FILLED);
+  } else if (kind == Kind::Polygon){
+    if (polygon.size() >= 3){
+      std::vector<std::vector<cv::Point>> polys{polygon};
+      cv::fillPoly(m, polys, cv::Scalar(255), cv::LINE_8, 0, o);
+    }
+  } else if (kind == Kind::Ring){
+    cv::circle(m, center + o, rOuter, 255, cv::FILLED);
+    cv::circle(m, center + o, rInner, 0, cv::FILLED);
+  } else if (kind == Kind::Mask && !mask.empty()){
+    const cv::Rect r = (rect + o) & cv::Rect(cv::Point(), area.size());
+    if (!r.empty()) mask(r - (rect.tl() + o)).copyTo(m(r));
+  }
+}
+
+// ---- MeasureSpec -------------------------------------------------------------
+
+MeasureSpec MeasureSpec::fromJson(const QJsonObject& specs){
+  MeasureSpec s;
+  s.mmPerPx = specs.value("mm_per_px").toDouble(s.mmPerPx);
+  s.gapTarget = specs.value("line_gap").toObject().value("target").toDouble(0);
+  s.gapTol = specs.value("line_gap").toObject().value("tol").toDouble(0);
+  s.parallelMaxDeg = specs.value("parallelism").toObject().value("max_deg").toDouble(1.0);
+  s.diameterTarget = specs.value("diameter").toObject().value("target").toDouble(0);
+  s.diameterTol = specs.value("diameter").toObject().value("tol").toDouble(0);
+  s.roundnessMaxMM = specs.value("roundness").toObject().value("max_mm").toDouble(0.05);
+  s.concentricityMaxMM = specs.value("concentricity").toObject().value("max_mm").toDouble(0.1);
+
+  s.robust = robustFitParams(specs, s.robustPrm);
+  s.pyramid = pyramidParams(specs, s.pyramidPrm);
+  s.subpixel = !s.pyramid && subpixelParams(specs, s.subpixelPrm);
+  s.edgePoints = !s.pyramid && !s.subpixel && edgePointParams(specs, s.edgePointPrm);
+  s.polarRing = polarRingParams(specs, s.polarRingPrm);
+  // "bit_depth": significant bits of 16-bit mono images (10, 12, ...; 0 = 16)
+  s.setBitDepth(specs.value("bit_depth").toInt(0));
+  // "bayer_reduce": "green" | "luma", for frames delivered as raw Bayer mosaics
+  if (specs.value("bayer_reduce").toString() == "luma") s.bayerReduce = BayerReduce::Luma;
+
+  // Fixture rectification: "perspective": {"H": [9 values, image -> output], "width", "height"}.
+  // ROIs are then given in rectified coordinates.
+  auto persp = specs.value("perspective").toObject();
+  QJsonArray hArr = persp.value("H").toArray();
+  if (hArr.size() == 9){
+    s.rectify = true;
+    for (int i=0;i<9;++i) s.H.val[i] = hArr.at(i).toDouble();
+    s.rectifiedSize = cv::Size(persp.value("width").toInt(0), persp.value("height").toInt(0));
+  }
+  // Locators work on raw images, so they are off for rectified frames
+  if (!s.rectify) s.locator = partLocator(specs);
+  if (specs.value("lens").toObject().value("enabled").toBool(false)) s.lens = specs.value("lens").toObject();
+  return s;
+}
+
+void MeasureSpec::setBitDepth(int bits){
+  bitDepth = pyramidPrm.bits = subpixelPrm.bits = edgePointPrm.bits = polarRingPrm.bits = std::clamp(bits, 0, 16);
+}
+
+// Point-space lens model:
+// "lens": {"enabled": true, "fx","fy","cx","cy","k1","k2","k3","p1","p2", "H": [9], "grid_step": 8}.
+// Correction grids are built once per (model, image size) and reused.
+std::shared_ptr<const LensModel> MeasureSpec::lensFor(cv::Size imageSize) const{
+  if (lens.isEmpty()) return nullptr;
+  static std::mutex mtx;
+  static QHash<QByteArray, std::shared_ptr<const LensModel>> cache;
+  QByteArray key = QJsonDocument(lens).toJson(QJsonDocument::Compact)
+                 + '@' + QByteArray::number(imageSize.width) + 'x' + QByteArray::number(imageSize.height);
+  std::lock_guard<std::mutex> lk(mtx);
+  if (auto it = cache.constFind(key); it != cache.constEnd()) return it.value();
+
+  const QJsonObject& o = lens;
+  auto L = std::make_shared<LensModel>();
+  L->fx = o.value("fx").toDouble(1.0); L->fy = o.value("fy").toDouble(L->fx);
+  L->cx = o.value("cx").toDouble(imageSize.width*0.5); L->cy = o.value("cy").toDouble(imageSize.height*0.5);
+  L->k1 = o.value("k1").toDouble(); L->k2 = o.value("k2").toDouble(); L->k3 = o.value("k3").toDouble();
+  L->p1 = o.value("p1").toDouble(); L->p2 = o.value("p2").toDouble();
+  QJsonArray h = o.value("H").toArray();
+  if (h.size() == 9) for (int i=0;i<9;++i) L->H.val[i] = h.at(i).toDouble();
+  if (L->identity()) return nullptr;
+  L->buildGrid(imageSize, std::max(1, o.value("grid_step").toInt(8)));
+  if (cache.size() >= 16) cache.clear();
+  cache.insert(key, L);
+  return L;
+}
+
+// ---- MeasurementEngine ---------------------------------------------------------
+
+void MeasurementEngine::putSpec(const std::string& id, const QJsonObject& specs){
+  auto s = std::make_shared<const MeasureSpec>(MeasureSpec::fromJson(specs));
+  std::lock_guard<std::mutex> lk(mtx_);
+  specs_[id] = std::move(s);
+}
+
+std::shared_ptr<const MeasureSpec> MeasurementEngine::spec(const std::string& id) const{
+  std::lock_guard<std::mutex> lk(mtx_);
+  auto it = specs_.find(id);
+  return it != specs_.end() ? it->second : nullptr;
+}
+
+MeasurementEngine::Session& MeasurementEngine::threadSession(){
+  thread_local Session s;
+  return s;
+}
+
+void MeasurementEngine::measureRois(const cv::Mat& img, const std::vector<RoiJob>& jobs,
+                                    std::vector<Item>& items, std::vector<SpecLimits>& limits,
+                                    std::vector<int>* jobOf, std::vector<Pose>* jobPoses){
+  items.clear(); limits.clear();
+  if (jobOf) jobOf->clear();
+  if (jobPoses) jobPoses->assign(jobs.size(), Pose{});
+  if (jobs.empty()) return;
+  // Ids with the top bit set are reserved for these per-call images
+  static std::atomic<uint64_t> nextId{uint64_t(1) << 63};
+  const uint64_t imageId = nextId++;
+
+  // Per-image work shared by all jobs: the raw-frame edge map (contour
+  // recipe only) and one pose per distinct locator.
+  cv::Mat edges;
+  int edgeBits = 0;
+  std::vector<std::pair<const ShapeLocator*, Pose>> poses;
+  for (auto& j : jobs){
+    CV_Assert(j.spec);
+    const MeasureSpec& s = *j.spec;
+    const bool polar = s.polarRing && j.roi.kind == MeasureRoi::Kind::Ring;
+    if (edges.empty() && !s.rectify && !s.pyramid && !s.subpixel && !s.edgePoints && !polar){
+      edges = threadSession().frameEdges(img, imageId, s.bitDepth);
+      edgeBits = s.bitDepth;
+    }
+    if (s.locator && std::none_of(poses.begin(), poses.end(), [&](auto& p){ return p.first == s.locator.get(); }))
+      poses.emplace_back(s.locator.get(), s.locator->locate(img));
+  }
+
+  std::vector<std::vector<Item>> jobItems(jobs.size());
+  std::vector<std::vector<SpecLimits>> jobLimits(jobs.size());
+  cv::parallel_for_(cv::Range(0, (int)jobs.size()), [&](const cv::Range& r){
+    Session& s = threadSession();
+    if (!edges.empty()) s.shareFrameEdges(edges, imageId, edgeBits);
+    MeasureFeatures f;
+    for (int i=r.start; i<r.end; ++i){
+      const RoiJob& j = jobs[i];
+      const Pose* pose = nullptr;
+      for (auto& p : poses) if (p.first == j.spec->locator.get()) pose = &p.second;
+      s.extract(img, *j.spec, j.roi, f, imageId, pose);
+      Session::evaluate(*j.spec, f, jobItems[i], jobLimits[i]);
+      if (jobPoses) (*jobPoses)[i] = f.pose;
+    }
+  });
+
+  for (size_t i=0; i<jobs.size(); ++i){
+    for (size_t k=0; k<jobItems[i].size(); ++k){
+      Item& it = jobItems[i][k];
+      if (!gaugeSelected(jobs[i].gauges, it.name)) continue;
+      it.name = jobs[i].name + "." + it.name;
+      items.push_back(std::move(it));
+      limits.push_back(jobLimits[i][k]);
+      if (jobOf) jobOf->push_back((int)i);
+    }
+  }
+}
+
+MeasurementEngine::Session::Session(){
+  pipe_.add(std::make_shared<op::Canny>(50,150,3,true));
+  pipe_.add(std::make_shared<op::Morph>(cv::MORPH_CLOSE, 3, 1));
+  pipe_.add(std::make_shared<op::Threshold>(128.0, cv::THRESH_BINARY));
+}
+
+const cv::Mat& MeasurementEngine::Session::frameEdges(const cv::Mat& img, uint64_t imageId, int bits){
+  if (imageId == 0 || imageId != imageId_ || bits != frameBits_ || frameEdges_.size() != img.size()){
+    imageId_ = 0;
+    frameEdges_.release();   // other sessions may still share the old map
+    toGray(pipe_.run(Frame{img, "engine", bits}).mat, frameEdges_);
+    imageId_ = imageId; frameBits_ = bits;
+  }
+  return frameEdges_;
+}
+
+void MeasurementEngine::Session::shareFrameEdges(const cv::Mat& edges, uint64_t imageId, int bits){
+  frameEdges_ = edges;
+  imageId_ = imageId; frameBits_ = bits;
+}
+
+// Edge map (8U) for the band. With an image id the whole frame is processed
+// once and later calls crop it; otherwise only the band is processed.
+const cv::Mat& MeasurementEngine::Session::edgesFor(const cv::Mat& img, const cv::Mat& band, const cv::Rect& bandRect, uint64_t imageId, int bits){
+  if (imageId != 0){
+    edges_ = frameEdges(img, imageId, bits)(bandRect);
+  } else {
+    edges_.release();   // may still view frameEdges_
+    toGray(pipe_.run(Frame{band, "engine", bits}).mat, edges_);
+  }
+  return edges_;
+}
+
+void MeasurementEngine::Session::measure(const cv::Mat& img, const MeasureSpec& spec, const MeasureRoi& roi,
+                                         std::vector<Item>& items, std::vector<SpecLimits>& limits, uint64_t imageId, Pose* pose){
+  MeasureFeatures f;
+  extract(img, spec, roi, f, imageId);
+  items.clear(); limits.clear();
+  evaluate(spec, f, items, limits);
+  if (pose) *pose = f.pose;
+}
+
+void MeasurementEngine::Session::extract(const cv::Mat& src, const MeasureSpec& spec, const MeasureRoi& roiIn,
+                                         MeasureFeatures& f, uint64_t imageId, const Pose* pose){
+  f = MeasureFeatures{};
+  std::shared_ptr<const PerspectiveRemap> remap;
+  cv::Size size = src.size();
+  if (spec.rectify){
+    size = cv::Size(spec.rectifiedSize.width > 0 ? spec.rectifiedSize.width : src.cols,
+                    spec.rectifiedSize.height > 0 ? spec.rectifiedSize.height : src.rows);
+    remap = PerspectiveRemap::cached(cv::Mat(spec.H), size);
+  }
+
+  // Optional part locator: ROIs are taught on the reference image and follow the part
+  MeasureRoi moved;
+  const MeasureRoi* roi = &roiIn;
+  if (spec.locator && !remap){
+    f.located = true;
+    f.pose = pose? *pose : spec.locator->locate(src);
+    if (!f.pose.found) return;
+    if (roiIn.kind != MeasureRoi::Kind::Full){ moved = roiIn.transformed(spec.locator->transform(f.pose)); roi = &moved; }
+  }
+
+  const cv::Rect full(cv::Point(), size);
+  const cv::Rect roiRect = roi->bounds(size);
+  if (roiRect.empty()) return;
+  f.valid = true;
+  f.roi = roiRect;
+
+  // Only the ROI box plus the filters' support is rectified and processed;
+  // the mask is rendered for that band alone.
+  const int margin = 4;
+  const cv::Rect band = cv::Rect(roiRect.x-margin, roiRect.y-margin, roiRect.width+2*margin, roiRect.height+2*margin) & full;
+  cv::Mat img = remap? remap->warpRoi(src, band) : src(band);
+  // ring ROIs searched in polar form need no mask
+  const bool polar = spec.polarRing && roi->kind == MeasureRoi::Kind::Ring;
+  if (!polar) roi->render(mask_, band);
+  const cv::Rect box = roiRect - band.tl();
+
+  // Lens correction works on raw image coordinates, so it is skipped for rectified frames
+  Calibration cal; cal.scale_mm_per_px = spec.mmPerPx;
+  if (!remap) cal.lens = spec.lensFor(src.size());
+  auto toPlane = [&](cv::Point2f q){ return cal.lens? cal.lens->map(q) : q; };
+  const bool robust = spec.robust;
+
+  // Edge points: circles A/B from the two largest contours, lines from the
+  // top/bottom halves of the ROI. Line moments are streamed; point vectors
+  // for lines are only materialised where a fitter needs them.
+  const cv::Point2f org = toPlane(cv::Point2f((float)(roiRect.x + roiRect.width*0.5), (float)(roiRect.y + roiRect.height*0.5)));
+  LineMoments momTop(org), momBot(org);
+  ptsA_.clear(); ptsB_.clear(); topPts_.clear(); botPts_.clear();
+  if (polar){
+    // Annulus unwrapped into a strip: one sub-pixel radius per ray and polarity,
+    // the outer edge as circle A and the other polarity (the bore) as B
+    const cv::Point2f bo((float)band.x, (float)band.y);
+    ringProfile(img, roi->center - band.tl(), roi->rInner, roi->rOuter, ring_, spec.polarRingPrm);
+    scratch_.clear(); ring_.points(ring_.outer, scratch_, bo);
+    for (auto& q : scratch_) ptsA_.push_back(toPlane(q));
+    scratch_.clear(); ring_.points(ring_.inner, scratch_, bo);
+    for (auto& q : scratch_) ptsB_.push_back(toPlane(q));
+  } else if (spec.pyramid){
+    // Coarse contours and first fits on the coarse level; full-res edges only in bands around them
+    MeasurePyramid pyr(img, spec.pyramidPrm);
+    const cv::Point2f bo((float)band.x, (float)band.y);
+    auto cc = pyr.coarseContours(mask_);
+    auto take = [&](std::vector<cv::Point2f>& dst){ for (auto& q : scratch_) dst.push_back(toPlane(q + bo)); scratch_.clear(); };
+    scratch_.clear();
+    // circles keep the band's edges of the contour's polarity, not both sides of a stroke
+    for (int k=0; k<2 && k<(int)cc.size(); ++k){
+      if (cc[k].size() < 6) continue;
+      const Circle c = fitCircleKasa(cc[k]);
+      pyr.bandEdges(c, scratch_, pyr.polarity(cc[k], c)); take(k == 0? ptsA_ : ptsB_);
+    }
+    std::vector<cv::Point2f> coarseTop, coarseBot;
+    for (auto& c : cc) for (auto& q : c) (q.y < box.y + box.height*0.5f ? coarseTop : coarseBot).push_back(q);
+    if (coarseTop.size() >= 5){ pyr.bandEdges(fitLineLSQ(coarseTop), box, scratch_); take(topPts_); }
+    if (coarseBot.size() >= 5){ pyr.bandEdges(fitLineLSQ(coarseBot), box, scratch_); take(botPts_); }
+    for (auto& q : topPts_) momTop.add(q);
+    for (auto& q : botPts_) momBot.add(q);
+  } else if (spec.subpixel){
+    // Sub-pixel edge chains on the band, restricted to the ROI box and mask
+    masked_ = cv::Mat::zeros(band.size(), CV_8UC1);
+    mask_(box).copyTo(masked_(box));
+    chains_.clear();
+    subpixelEdges(img, chains_, spec.subpixelPrm, masked_);
+    keepOuterChains(chains_);
+
+    const cv::Point2f bo((float)band.x, (float)band.y);
+    const float midY = roiRect.y + roiRect.height*0.5f;
+    if (chains_.size() >= 1) for (auto& q : chains_[0]) ptsA_.push_back(toPlane(q + bo));
+    if (chains_.size() >= 2) for (auto& q : chains_[1]) ptsB_.push_back(toPlane(q + bo));
+    for (auto& c : chains_){
+      for (auto& q : c){
+        bool top = q.y + bo.y < midY;
+        cv::Point2f pt = toPlane(q + bo);
+        (top? momTop : momBot).add(pt);
+        if (robust) (top? topPts_ : botPts_).push_back(pt);
+      }
+    }
+  } else if (spec.edgePoints){
+    // Gradient maxima straight into point lists: no edge image, no contour scan
+    masked_ = cv::Mat::zeros(band.size(), CV_8UC1);
+    mask_(box).copyTo(masked_(box));
+    edgePoints(img, points_, spec.edgePointPrm, masked_);
+    outerEdgeGroups(points_, groups_);
+
+    const cv::Point2f bo((float)band.x, (float)band.y);
+    const float midY = roiRect.y + roiRect.height*0.5f;
+    if (groups_.size() >= 1) for (int i : groups_[0]) ptsA_.push_back(toPlane(points_.pt[i] + bo));
+    if (groups_.size() >= 2) for (int i : groups_[1]) ptsB_.push_back(toPlane(points_.pt[i] + bo));
+    for (auto& g : groups_){
+      for (int i : g){
+        const cv::Point2f q = points_.pt[i] + bo;
+        bool top = q.y < midY;
+        cv::Point2f pt = toPlane(q);
+        (top? momTop : momBot).add(pt);
+        if (robust) (top? topPts_ : botPts_).push_back(pt);
+      }
+    }
+  } else {
+    // Canny / close / threshold, then contours inside the ROI box (points relative to roiRect)
+    const cv::Mat& edges = edgesFor(remap? img : src, img, band, remap? 0 : imageId, spec.bitDepth);
+    gray_.create(box.size(), CV_8UC1); gray_.setTo(0);
+    edges(box).copyTo(gray_, mask_(box));
+    contours_.clear();
+    cv::findContours(gray_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    std::sort(contours_.begin(), contours_.end(), [](auto& a, auto& b){ return cv::contourArea(a) > cv::contourArea(b); });
+
+    const cv::Point2f off((float)roiRect.x, (float)roiRect.y);
+    if (contours_.size() >= 1) for (auto& p: contours_[0]) ptsA_.push_back(toPlane(cv::Point2f(p) + off));
+    if (contours_.size() >= 2) for (auto& p: contours_[1]) ptsB_.push_back(toPlane(cv::Point2f(p) + off));
+    for (auto& c : contours_){
+      for (auto& p : c){
+        bool top = p.y < roiRect.height*0.5;
+        cv::Point2f pt = toPlane(cv::Point2f(p) + off);
+        (top? momTop : momBot).add(pt);
+        if (robust) (top? topPts_ : botPts_).push_back(pt);
+      }
+    }
+  }
+
+  // Circles A/B: diameter, roundness and centre from one fused pass per set
+  if (robust){
+    // roundness is judged on the consensus set so burrs/dust do not count as form error
+    if (ptsA_.size() >= 12){
+      auto rc = fitCircleRobust(ptsA_, spec.robustPrm);
+      f.gA = CircleGauge{rc.circle, 2.0*rc.circle.r, 2.0*rc.quality.maxAbsPx, (int)ptsA_.size(), true};
+    }
+    if (ptsB_.size() >= 12){
+      auto rc = fitCircleRobust(ptsB_, spec.robustPrm);
+      f.gB = CircleGauge{rc.circle, 2.0*rc.circle.r, 2.0*rc.quality.maxAbsPx, (int)ptsB_.size(), true};
+    }
+  } else {
+    sets_.clear(); sets_.add(ptsA_); sets_.add(ptsB_);
+    fitCirclesBatch(sets_, circles_, 12);
+    f.gA = circles_[0]; f.gB = circles_[1];
+  }
+
+  // gap span: the ROI box carried into the corrected frame
+  f.gapRect = roiRect;
+  if (cal.lens){
+    std::vector<cv::Point2f> corners{toPlane(roiRect.tl()), toPlane(cv::Point2f((float)roiRect.br().x, (float)roiRect.y)),
+                                     toPlane(roiRect.br()), toPlane(cv::Point2f((float)roiRect.x, (float)roiRect.br().y))};
+    f.gapRect = cv::boundingRect(corners);
+  }
+  if (momTop.n >= 20) f.hasTop = robust? (f.top = fitLineRobust(topPts_, spec.robustPrm).line, true) : momTop.fit(f.top);
+  if (momBot.n >= 20) f.hasBot = robust? (f.bot = fitLineRobust(botPts_, spec.robustPrm).line, true) : momBot.fit(f.bot);
+}
+
+void MeasurementEngine::Session::evaluate(const MeasureSpec& spec, const MeasureFeatures& f,
+                                          std::vector<Item>& items, std::vector<SpecLimits>& limits){
+  const double none = std::numeric_limits<double>::quiet_NaN();
+  auto push = [&](const char* name, double val, const char* unit, bool ok, const QString& note, double lsl, double usl){
+    items.push_back(Item{name, val, unit, ok, note.toStdString()});
+    limits.push_back({lsl, usl});
+  };
+  // The pose travels beside the items (MeasureFeatures::pose, measure()'s
+  // `pose`); only a part that was not found shows up here, as a failure.
+  if (f.located && !f.pose.found){
+    push("locate_score", f.pose.score, "", false, QString("part not found"), none, none);
+    return;
+  }
+  if (!f.valid) return;
+  Calibration cal; cal.scale_mm_per_px = spec.mmPerPx;
+
+  // Line gap & parallelism
+  if (f.hasTop && f.hasBot){
+    auto mGap = gauge::metricLineGapMM(f.top, f.bot, f.gapRect, cal);
+    const double target = spec.gapTarget, tol = spec.gapTol;
+    bool okGap = (std::abs(mGap.value_mm - target) <= tol + 1e-9);
+    push("line_gap", mGap.value_mm, "mm", okGap, QString("%1±%2").arg(target).arg(tol), target-tol, target+tol);
+
+    auto mPar = gauge::metricParallelismDeg(f.top, f.bot);
+    bool okPar = (std::abs(mPar.value_mm) <= spec.parallelMaxDeg + 1e-9);
+    push("parallelism", mPar.value_mm, "deg", okPar, QString("≤%1").arg(spec.parallelMaxDeg), none, spec.parallelMaxDeg);
+  }
+
+  // Circle metrics
+  if (f.gA.valid){
+    auto mDia = gauge::metricDiameterMM(f.gA.circle, cal);
+    const double target = spec.diameterTarget, tol = spec.diameterTol;
+    bool okDia = (std::abs(mDia.value_mm - target) <= tol + 1e-9);
+    push("diameter_A", mDia.value_mm, "mm", okDia, QString("%1±%2").arg(target).arg(tol), target-tol, target+tol);
+
+    auto mRnd = gauge::metricRoundnessMM(f.gA, cal);
+    bool okRnd = (mRnd.value_mm <= spec.roundnessMaxMM + 1e-9);
+    push("roundness_A", mRnd.value_mm, "mm", okRnd, QString("≤%1").arg(spec.roundnessMaxMM), none, spec.roundnessMaxMM);
+  }
+
+  if (f.gA.valid && f.gB.valid){
+    auto mCon = gauge::metricConcentricityMM(f.gA.circle, f.gB.circle, cal);
+    bool okCon = (mCon.value_mm <= spec.concentricityMaxMM + 1e-9);
+    push("concentricity_AB", mCon.value_mm, "mm", okCon, QString("≤%1").arg(spec.concentricityMaxMM), none, spec.concentricityMaxMM);
+  }
+}
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <QJsonObject>
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/bayer.h"
+#include "core/pipeline.h"
+#include "measure/calibration.h"
+#include "measure/edge_points.h"
+#include "measure/geometry.h"
+#include "measure/geometry_batch.h"
+#include "measure/locator.h"
+#include "measure/polar_ring.h"
+#include "measure/pyramid.h"
+#include "measure/report.h"
+#include "measure/subpixel.h"
+
+namespace mp {
+// A measurement region in image pixels (rectified pixels when the spec
+// rectifies). Mask regions carry their own 8U mask over `rect`, for shapes
+// the front end rasterises itself.
+struct MeasureRoi {
+  enum class Kind { Full, Rect, Polygon, Ring, Mask };
+  Kind kind = Kind::Full;
+  cv::Rect rect;
+  std::vector<cv::Point> polygon;
+  cv::Point center;
+  int rInner = 0, rOuter = 0;
+  cv::Mat mask;
+
+  // {"type": "rect"|"polygon"|"ring", ...} as accepted by POST /measure; empty = full frame.
+  static MeasureRoi fromJson(const QJsonObject& roi);
+  MeasureRoi transformed(const cv::Matx23d& T) const;  // a turned rect becomes a polygon
+  cv::Rect bounds(cv::Size image) const;
+  // 255 inside the region, 0 outside, for the pixels of `area` only.
+  void render(cv::Mat& mask, const cv::Rect& area) const;
+};
+
+// Everything a measurement needs from a spec, parsed once. Locators are
+// trained and lens grids built when first needed, then shared by every
+// session measuring with this spec.
+struct MeasureSpec {
+  double mmPerPx = 0.02;
+  int bitDepth = 0;       // significant bits of 16-bit mono images (0 = 16); thresholds stay on the 8-bit scale
+  BayerReduce bayerReduce = BayerReduce::Green;   // how raw Bayer input becomes the half-size grey image
+  double gapTarget = 0, gapTol = 0, parallelMaxDeg = 1.0;
+  double diameterTarget = 0, diameterTol = 0, roundnessMaxMM = 0.05, concentricityMaxMM = 0.1;
+
+  bool robust = false;    RobustFitParams robustPrm;
+  bool pyramid = false;   PyramidParams pyramidPrm;
+  bool subpixel = false;  SubpixelEdgeParams subpixelPrm;
+  bool edgePoints = false; EdgePointParams edgePointPrm;
+  bool polarRing = false; PolarRingParams polarRingPrm;   // ring ROIs only; other kinds use the recipe above
+
+  bool rectify = false;   // fixture rectification: image -> outSize through H
+  cv::Matx33d H = cv::Matx33d::eye();
+  cv::Size rectifiedSize;
+
+  std::shared_ptr<const ShapeLocator> locator;
+  QJsonObject lens;       // "lens" block; the grid depends on the image size
+
+  // Same keys as config/specs.json; missing keys keep the defaults above.
+  static MeasureSpec fromJson(const QJsonObject& specs);
+  void setBitDepth(int bits);   // bitDepth and the edge detectors' copies of it
+  std::shared_ptr<const LensModel> lensFor(cv::Size imageSize) const;
+};
+
+// Fitted features of one ROI, before any spec limits are applied.
+struct MeasureFeatures {
+  bool valid = false;      // false: empty ROI or part not located
+  bool located = false;    // a locator ran; `pose` is set
+  Pose pose;
+  cv::Rect roi, gapRect;   // ROI box; gap span in the corrected frame
+  CircleGauge gA, gB;
+  Line2D top{{0,0},{1,0}}, bot{{0,0},{1,0}};
+  bool hasTop = false, hasBot = false;
+};
+
+// One named region of a multi-ROI measurement, with its own spec and gauge
+// selection. A gauge name selects the items equal to it or starting with it
+// plus '_' ("diameter" -> diameter_A); no gauges selects every item.
+struct RoiJob {
+  std::string name;
+  std::shared_ptr<const MeasureSpec> spec;
+  MeasureRoi roi;
+  std::vector<std::string> gauges;
+};
+
+// In-process entry point shared by the REST backend, the GUI and the C ABI
+// (core/engine_c.h). Specs are prepared once and shared; each thread
+// measures through its own Session, which keeps scratch buffers, the edge
+// pipeline and (given an image id) the full-frame edge map between calls.
+class MeasurementEngine {
+public:
+  class Session {
+  public:
+    Session();
+    // extract() then evaluate(). `imageId` != 0 promises that equal ids are
+    // equal pixels, so repeated calls on one image share its edge map.
+    // `pose` (optional) receives the locator result; it is not a gauge item.
+    void measure(const cv::Mat& img, const MeasureSpec& spec, const MeasureRoi& roi,
+                 std::vector<Item>& items, std::vector<SpecLimits>& limits, uint64_t imageId = 0,
+                 Pose* pose = nullptr);
+    // Contours / edge chains and fits for one ROI. `pose` (optional) is the
+    // spec's locator result on this image, when it has already been run.
+    void extract(const cv::Mat& img, const MeasureSpec& spec, const MeasureRoi& roi,
+                 MeasureFeatures& f, uint64_t imageId = 0, const Pose* pose = nullptr);
+    // Gauges and pass/fail for extracted features; appends to items/limits.
+    static void evaluate(const MeasureSpec& spec, const MeasureFeatures& f,
+                         std::vector<Item>& items, std::vector<SpecLimits>& limits);
+    // Full-frame edge map of `img`, computed once per image id and bit depth.
+    const cv::Mat& frameEdges(const cv::Mat& img, uint64_t imageId, int bits = 0);
+    // Adopts another session's frame edges (read only) for image `imageId`.
+    void shareFrameEdges(const cv::Mat& edges, uint64_t imageId, int bits = 0);
+  private:
+    const cv::Mat& edgesFor(const cv::Mat& img, const cv::Mat& band, const cv::Rect& bandRect, uint64_t imageId, int bits);
+    Pipeline pipe_;
+    uint64_t imageId_ = 0;
+    cv::Mat frameEdges_;     // full-frame edge map of image imageId_
+    int frameBits_ = 0;      // bit depth frameEdges_ was computed at
+    cv::Mat mask_, edges_, gray_, masked_;
+    std::vector<std::vector<cv::Point>> contours_;
+    std::vector<EdgeChain> chains_;
+    EdgePoints points_;
+    RingProfile ring_;
+    std::vector<std::vector<int>> groups_;
+    std::vector<cv::Point2f> ptsA_, ptsB_, topPts_, botPts_, scratch_;
+    PointSetsSoA sets_;
+    std::vector<CircleGauge> circles_;
+  };
+
+  // Prepared specs by id; putSpec() replaces an existing one.
+  void putSpec(const std::string& id, const QJsonObject& specs);
+  std::shared_ptr<const MeasureSpec> spec(const std::string& id) const;
+
+  // The calling thread's session, created on first use. Sessions hold no
+  // engine state, so every engine on a thread shares it.
+  static Session& threadSession();
+
+  // Every job on one image: the frame's edge map and each distinct locator
+  // run once, then the jobs are extracted and evaluated in parallel. Items
+  // are appended in job order as "<name>.<item>"; `jobOf` (optional) gets
+  // the job index of each item and `jobPoses` (optional) each job's pose.
+  static void measureRois(const cv::Mat& img, const std::vector<RoiJob>& jobs,
+                          std::vector<Item>& items, std::vector<SpecLimits>& limits,
+                          std::vector<int>* jobOf = nullptr, std::vector<Pose>* jobPoses = nullptr);
+
+private:
+  mutable std::mutex mtx_;
+  std::map<std::string, std::shared_ptr<const MeasureSpec>> specs_;
+};
+}
@@ -5,7 +5,8 @@
 #include <vector>
 
 namespace mp {
-struct Frame { cv::Mat mat; std::string tag; };
+// `bits`: significant bits of 16-bit mono data (0 = all 16); see core/gray_levels.h
+struct Frame { cv::Mat mat; std::string tag; int bits = 0; };
 class IModule {
 public: virtual ~IModule() = default;
   virtual std::string name() const = 0;
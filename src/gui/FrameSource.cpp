@@ -0,0 +1,135 @@
+#include "FrameSource.h"
+#include <QDir>
+#include <QSharedMemory>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "core/frame_ring.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Sleeps until the next tick of a fixed-rate schedule; resyncs after stalls.
+class Pacer {
+public:
+  explicit Pacer(double fps): period_(fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0/fps)) : Clock::duration::zero()) {}
+  void wait(){
+    if (period_ == Clock::duration::zero()) return;
+    next_ += period_;
+    auto now = Clock::now();
+    if (next_ < now) next_ = now; else std::this_thread::sleep_until(next_);
+  }
+private:
+  Clock::duration period_;
+  Clock::time_point next_ = Clock::now();
+};
+
+class FolderSource : public FrameSource {
+public:
+  FolderSource(const QString& dir, double fps): dir_(dir), pacer_(fps){
+    files_ = QDir(dir).entryList({"*.png","*.jpg","*.jpeg","*.bmp","*.tif","*.tiff"}, QDir::Files, QDir::Name);
+  }
+  bool isOpen() const override { return !files_.isEmpty(); }
+  bool read(cv::Mat& frame) override {
+    if (files_.isEmpty()) return false;
+    pacer_.wait();
+    frame = cv::imread(QDir(dir_).filePath(files_[next_]).toStdString(), cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
+    next_ = (next_ + 1) % files_.size();
+    return true;   // an unreadable file just shows up as a skipped frame
+  }
+  QString describe() const override { return QString("folder %1 (%2 images)").arg(dir_).arg(files_.size()); }
+private:
+  QString dir_;
+  QStringList files_;
+  int next_ = 0;
+  Pacer pacer_;
+};
+
+class VideoSource : public FrameSource {
+public:
+  explicit VideoSource(const QString& path): path_(path), cap_(path.toStdString()),
+    pacer_(cap_.isOpened() ? cap_.get(cv::CAP_PROP_FPS) : 0.0) {}
+  bool isOpen() const override { return cap_.isOpened(); }
+  bool read(cv::Mat& bgr) override {
+    if (!cap_.isOpened()) return false;
+    pacer_.wait();
+    if (cap_.read(bgr)) return true;
+    cap_.set(cv::CAP_PROP_POS_FRAMES, 0);   // loop
+    return cap_.read(bgr);
+  }
+  QString describe() const override { return QString("video %1").arg(path_); }
+private:
+  QString path_;
+  cv::VideoCapture cap_;
+  Pacer pacer_;
+};
+
+class SyntheticSource : public FrameSource {
+public:
+  SyntheticSource(cv::Size size, double fps): size_(size), pacer_(fps) {}
+  bool isOpen() const override { return true; }
+  bool read(cv::Mat& bgr) override {
+    pacer_.wait();
+    const double t = 0.05*n_++;
+    const cv::Point2f c(size_.width*(0.5f + 0.1f*(float)std::sin(t)), size_.height*(0.5f + 0.05f*(float)std::cos(0.7*t)));
+    const float R = 0.25f*std::min(size_.width, size_.height);
+    bgr.create(size_, CV_8UC3);
+    bgr.setTo(cv::Scalar::all(40));
+    cv::rectangle(bgr, cv::Point2f(c.x - 1.6f*R, c.y - 1.4f*R), cv::Point2f(c.x + 1.6f*R, c.y - 1.1f*R), cv::Scalar::all(200), cv::FILLED, cv::LINE_AA);
+    cv::rectangle(bgr, cv::Point2f(c.x - 1.6f*R, c.y + 1.1f*R), cv::Point2f(c.x + 1.6f*R, c.y + 1.4f*R), cv::Scalar::all(200), cv::FILLED, cv::LINE_AA);
+    cv::circle(bgr, c, (int)R, cv::Scalar::all(200), cv::FILLED, cv::LINE_AA);
+    cv::circle(bgr, c, (int)(0.45f*R), cv::Scalar::all(40), cv::FILLED, cv::LINE_AA);
+    noise_.create(size_, CV_8UC3);
+    cv::randn(noise_, cv::Scalar::all(0), cv::Scalar::all(4));
+    cv::add(bgr, noise_, bgr);
+    return true;
+  }
+  QString describe() const override { return QString("synthetic %1x%2").arg(size_.width).arg(size_.height); }
+private:
+  cv::Size size_;
+  Pacer pacer_;
+  cv::Mat noise_;
+  long n_ = 0;
+};
+
+class ShmSource : public FrameSource {
+public:
+  ShmSource(const QString& key, mp::BayerReduce reduce): shm_(key), reduce_(reduce){
+    if (shm_.attach(QSharedMemory::ReadOnly)) ring_ = mp::frameRingAttach(shm_.constData(), (size_t)shm_.size());
+  }
+  bool isOpen() const override { return ring_ != nullptr; }
+  bool read(cv::Mat& frame) override {
+    if (!ring_) return false;
+    // poll for a newer frame for up to ~100 ms; raw Bayer frames become
+    // half-size grey in one pass instead of being demosaiced
+    for (int i=0; i<100; ++i){
+      if (mp::frameRingLatest(ring_, frame_, seq_)){
+        frame.release();   // every frame gets a buffer of its own
+        if (ring_->bayer) mp::bayerToHalfGray(frame_, frame, mp::BayerPattern(ring_->bayer), reduce_);
+        else frame = frame_.clone();
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    frame.release();
+    return true;
+  }
+  QString describe() const override {
+    return QString("shared memory %1%2").arg(shm_.key(), ring_ && ring_->bayer ? " (Bayer, half size)" : "");
+  }
+private:
+  QSharedMemory shm_;
+  const mp::FrameRingHeader* ring_ = nullptr;
+  cv::Mat frame_;
+  uint64_t seq_ = 0;
+  mp::BayerReduce reduce_;
+};
+}
+
+std::unique_ptr<FrameSource> openFolderSource(const QString& dir, double fps){ return std::make_unique<FolderSource>(dir, fps); }
+std::unique_ptr<FrameSource> openVideoSource(const QString& path){ return std::make_unique<VideoSource>(path); }
+std::unique_ptr<FrameSource> openSyntheticSource(cv::Size size, double fps){ return std::make_unique<SyntheticSource>(size, fps); }
+std::unique_ptr<FrameSource> openShmSource(const QString& key, mp::BayerReduce reduce){ return std::make_unique<ShmSource>(key, reduce); }
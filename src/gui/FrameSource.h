@@ -0,0 +1,27 @@
+#pragma once
+#include <QString>
+#include <opencv2/core.hpp>
+#include <memory>
+#include "core/bayer.h"
+
+// Where live frames come from. read() paces itself to the source's rate and
+// returns true with an empty frame when nothing new arrived in time, so the
+// caller can poll its stop flag; false means the source has ended.
+class FrameSource {
+public:
+  virtual ~FrameSource() = default;
+  virtual bool isOpen() const = 0;
+  virtual bool read(cv::Mat& frame) = 0;   // 8-bit BGR or mono 8/16-bit
+  virtual QString describe() const = 0;
+};
+
+// Images of a folder in name order, looped, at `fps` (0 = as fast as possible).
+std::unique_ptr<FrameSource> openFolderSource(const QString& dir, double fps = 10.0);
+// Video file at its own frame rate, looped.
+std::unique_ptr<FrameSource> openVideoSource(const QString& path);
+// Moving ring-and-bars test part with a little noise.
+std::unique_ptr<FrameSource> openSyntheticSource(cv::Size size = cv::Size(1280, 960), double fps = 30.0);
+// Frames published by another process into a core/frame_ring.h ring under `key`.
+// Raw Bayer rings arrive as half-size grey reduced by `reduce`; the GUI has
+// no spec to read "bayer_reduce" from, so it keeps the green default.
+std::unique_ptr<FrameSource> openShmSource(const QString& key, mp::BayerReduce reduce = mp::BayerReduce::Green);
@@ -0,0 +1,110 @@
+#include "LiveRunner.h"
+#include <utility>
+#include "core/image_buffer.h"
+
+LiveRunner::LiveRunner(QObject* parent): QObject(parent) {}
+
+LiveRunner::~LiveRunner(){ stop(); }
+
+void LiveRunner::start(std::unique_ptr<FrameSource> src){
+  stop();
+  src_ = std::move(src);
+  stop_ = false; posted_ = false;
+  cancel_ = std::make_shared<std::atomic_bool>(false);
+  { std::lock_guard<std::mutex> lk(frameMtx_); frame_.release(); fresh_ = ended_ = false; captured_ = dropped_ = 0; }
+  { std::lock_guard<std::mutex> lk(resultMtx_); back_ = LiveResult{}; hasBack_ = false; }
+  running_ = true;
+  capture_ = std::thread(&LiveRunner::captureLoop, this);
+  measure_ = std::thread(&LiveRunner::measureLoop, this);
+}
+
+void LiveRunner::stop(){
+  if (!running_) return;
+  { std::lock_guard<std::mutex> lk(frameMtx_); stop_ = true; }
+  cancel_->store(true);
+  frameCv_.notify_all();
+  capture_.join(); measure_.join();
+  src_.reset();
+  running_ = false;
+}
+
+void LiveRunner::setRecipe(const MeasureRequest& r){
+  std::lock_guard<std::mutex> lk(recipeMtx_);
+  recipe_ = r;
+  recipe_.image.release();
+}
+
+bool LiveRunner::takeResult(LiveResult& out){
+  std::lock_guard<std::mutex> lk(resultMtx_);
+  posted_ = false;
+  if (!hasBack_) return false;
+  std::swap(out, back_);
+  hasBack_ = false;
+  return true;
+}
+
+void LiveRunner::captureLoop(){
+  cv::Mat f;
+  while (!stop_){
+    if (!src_->read(f)){ break; }
+    if (f.empty()) continue;   // nothing new yet; poll the stop flag again
+    const auto t = Clock::now();
+    {
+      std::lock_guard<std::mutex> lk(frameMtx_);
+      if (fresh_) ++dropped_;  // latest frame wins
+      cv::swap(frame_, f);
+      frameT_ = t; fresh_ = true; ++captured_;
+    }
+    frameCv_.notify_one();
+  }
+  { std::lock_guard<std::mutex> lk(frameMtx_); ended_ = true; }
+  frameCv_.notify_one();
+}
+
+void LiveRunner::measureLoop(){
+  double fps = 0, latency = 0;
+  long long measured = 0;
+  Clock::time_point last{};
+  while (true){
+    MeasureRequest req;
+    Clock::time_point t0;
+    long long captured, dropped;
+    {
+      std::unique_lock<std::mutex> lk(frameMtx_);
+      frameCv_.wait(lk, [&]{ return fresh_ || ended_ || stop_; });
+      if (stop_ || (!fresh_ && ended_)) break;
+      req.image = frame_; frame_ = cv::Mat();   // take ownership; capture writes a new buffer
+      t0 = frameT_; fresh_ = false;
+      captured = captured_; dropped = dropped_;
+    }
+    {
+      std::lock_guard<std::mutex> lk(recipeMtx_);
+      cv::Mat frame = req.image;
+      req = recipe_; req.image = frame;
+    }
+    LiveResult r;
+    r.measure = runMeasurement(req, cancel_);
+    if (r.measure.cancelled) break;
+    r.frame = mp::ImageBuffer(req.image).qimage();   // frames are never reused, so no copy
+
+    const auto now = Clock::now();
+    const double lat = std::chrono::duration<double, std::milli>(now - t0).count();
+    latency = measured ? 0.9*latency + 0.1*lat : lat;
+    if (measured){
+      const double dt = std::chrono::duration<double>(now - last).count();
+      if (dt > 0) fps = fps > 0 ? 0.9*fps + 0.1/dt : 1.0/dt;
+    }
+    last = now; ++measured;
+    r.fps = fps; r.latencyMs = latency;
+    r.captured = captured; r.measured = measured; r.dropped = dropped;
+
+    {
+      std::lock_guard<std::mutex> lk(resultMtx_);
+      back_ = std::move(r); hasBack_ = true;
+    }
+    if (!posted_.exchange(true)) emit resultReady();
+  }
+  bool ended;
+  { std::lock_guard<std::mutex> lk(frameMtx_); ended = ended_ && !stop_; }
+  if (ended) emit sourceEnded();
+}
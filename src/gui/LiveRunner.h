@@ -0,0 +1,72 @@
+#pragma once
+#include <QObject>
+#include <QImage>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "FrameSource.h"
+#include "MeasureJob.h"
+
+struct LiveResult {
+  MeasureResult measure;     // empty rows when no ROI is drawn yet
+  QImage frame;              // the frame that was measured, for the ROI view
+  double fps = 0;            // measurements per second (smoothed)
+  double latencyMs = 0;      // frame captured -> result ready (smoothed)
+  long long captured = 0, measured = 0, dropped = 0;
+};
+
+// Continuous measurement over a FrameSource. A capture thread keeps only the
+// newest frame (older unmeasured ones are dropped), a measure thread always
+// works on the newest frame, and the GUI picks up the newest result when it
+// gets around to painting. Neither the display nor the measurement waits
+// for the other.
+class LiveRunner : public QObject {
+  Q_OBJECT
+public:
+  explicit LiveRunner(QObject* parent=nullptr);
+  ~LiveRunner();
+
+  void start(std::unique_ptr<FrameSource> src);
+  void stop();
+  bool running() const { return running_; }
+
+  // Recipe (ROI and specs) used from the next frame on; image/frame are ignored.
+  void setRecipe(const MeasureRequest& r);
+  // Swaps the newest result into `out`; false if none arrived since the last call.
+  bool takeResult(LiveResult& out);
+
+signals:
+  void resultReady();          // at most one pending at a time
+  void sourceEnded();
+
+private:
+  using Clock = std::chrono::steady_clock;
+  void captureLoop();
+  void measureLoop();
+
+  std::unique_ptr<FrameSource> src_;
+  std::thread capture_, measure_;
+  std::atomic_bool stop_{false};
+  bool running_ = false;
+  CancelFlag cancel_;
+
+  // newest captured frame (single slot, overwritten)
+  std::mutex frameMtx_;
+  std::condition_variable frameCv_;
+  cv::Mat frame_;
+  Clock::time_point frameT_;
+  bool fresh_ = false, ended_ = false;
+  long long captured_ = 0, dropped_ = 0;
+
+  std::mutex recipeMtx_;
+  MeasureRequest recipe_;
+
+  // back buffer of the display double buffer; the GUI owns the front one
+  std::mutex resultMtx_;
+  LiveResult back_;
+  bool hasBack_ = false;
+  std::atomic_bool posted_{false};
+};
@@ -9,25 +9,12 @@
 #include <QTableWidgetItem>
 #include <QBrush>
 #include <QColor>
-#include <opencv2/imgcodecs.hpp>
-#include <opencv2/imgproc.hpp>
-
-#include "core/pipeline.h"
-#include "ops/canny.h"
-#include "ops/morph.h"
-#include "ops/threshold.h"
-#include "measure/caliper.h"
-#include "measure/calibration.h"
-#include "measure/report.h"
-#include "measure/gauges.h"
-#include "measure/geometry.h"
-
-using namespace mp;
-
-static QImage matToQ(const cv::Mat& bgr){
-  cv::Mat rgb; cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
-  return QImage(rgb.data, rgb.cols, rgb.rows, rgb.step, QImage::Format_RGB888).copy();
-}
+#include <QStatusBar>
+#include <QInputDialog>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QScreen>
+#include <QtConcurrent/QtConcurrentRun>
 
 MainWindow::MainWindow(QWidget* parent): QMainWindow(parent), ui(new Ui::MainWindow){
   ui->setupUi(this);
@@ -37,24 +24,61 @@ MainWindow::MainWindow(QWidget* parent): QMainWindow(parent), ui(new Ui::MainWin
   connect(ui->btnRing, &QPushButton::clicked, this, &MainWindow::onModeRing);
   connect(ui->btnPoly, &QPushButton::clicked, this, &MainWindow::onModePoly);
   connect(ui->btnClear, &QPushButton::clicked, this, &MainWindow::onClearRoi);
+  connect(&watcher_, &QFutureWatcher<MeasureResult>::finished, this, &MainWindow::onMeasured);
+  connect(ui->actionLiveFolder, &QAction::triggered, this, &MainWindow::onLiveFolder);
+  connect(ui->actionLiveVideo, &QAction::triggered, this, &MainWindow::onLiveVideo);
+  connect(ui->actionLiveSynthetic, &QAction::triggered, this, &MainWindow::onLiveSynthetic);
+  connect(ui->actionLiveShm, &QAction::triggered, this, &MainWindow::onLiveShm);
+  connect(ui->actionLiveStop, &QAction::triggered, this, &MainWindow::onLiveStop);
 
   // Replace placeholder labelInput with RoiView
   roiView_ = new RoiView(this);
   ui->layoutInput->addWidget(roiView_);
 
+  // Live mode: results arrive from the runner; ROI/spec edits re-target it
+  live_ = new LiveRunner(this);
+  liveStats_ = new QLabel(this);
+  statusBar()->addPermanentWidget(liveStats_);
+  connect(live_, &LiveRunner::resultReady, this, &MainWindow::onLiveResult);
+  connect(live_, &LiveRunner::sourceEnded, this, &MainWindow::onLiveStop);
+
+  // ROI/spec edits: re-target live mode, or re-measure the still image from cached stages
+  session_ = std::make_shared<MeasureSession>();
+  remeasure_.setSingleShot(true);
+  const double hz = screen() ? screen()->refreshRate() : 60.0;
+  remeasure_.setInterval(int(1000.0 / (hz > 0 ? hz : 60.0)));
+  connect(&remeasure_, &QTimer::timeout, this, [this]{
+    if (watcher_.isRunning()) remeasurePending_ = true;   // picked up when the current job lands
+    else startMeasure();
+  });
+  connect(roiView_, &RoiView::roiChanged, this, &MainWindow::onRecipeChanged);
+  for (auto* sp : {ui->spinScale, ui->spinSpecLineGap, ui->spinTolLineGap, ui->spinSpecDiameter, ui->spinTolDiameter,
+                   ui->spinTolRoundness, ui->spinTolParallelDeg, ui->spinTolConcentric})
+    connect(sp, &QDoubleSpinBox::valueChanged, this, &MainWindow::onRecipeChanged);
+  connect(ui->comboBitDepth, &QComboBox::currentIndexChanged, this, &MainWindow::onRecipeChanged);
+
   ui->tableResults->setColumnCount(4);
   ui->tableResults->setHorizontalHeaderLabels({"Metric","Value","Spec","OK"});
   ui->tableResults->horizontalHeader()->setStretchLastSection(true);
 }
 
-MainWindow::~MainWindow(){ delete ui; }
+MainWindow::~MainWindow(){
+  live_->stop();
+  if (cancel_) cancel_->store(true);
+  watcher_.waitForFinished();
+  delete ui;
+}
 
 void MainWindow::onOpen(){
-  auto fn = QFileDialog::getOpenFileName(this, "Open", {}, "Images (*.png *.jpg *.jpeg *.bmp)");
+  auto fn = QFileDialog::getOpenFileName(this, "Open", {}, "Images (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)");
   if (fn.isEmpty()) return;
-  cv::Mat img = cv::imread(fn.toStdString());
+  mp::ImageBuffer img = mp::ImageBuffer::read(fn.toStdString());
   if (img.empty()){ QMessageBox::warning(this, "Error", "Failed to open image."); return; }
-  roiView_->setImage(matToQ(img));
+  if (cancel_) cancel_->store(true);  // results for the old image are no longer wanted
+  onLiveStop();
+  image_ = img;
+  ++imageSerial_;
+  roiView_->setImage(image_.qimage());   // view of the same pixels (BGR, Grayscale8 or Grayscale16)
   ui->labelOutput->setPixmap(QPixmap()); // clear out
   ui->labelOutput->setText("Output");
 }
@@ -73,131 +97,100 @@ void MainWindow::appendResultRow(const QString& name, const QString& value, cons
 }
 
 void MainWindow::onRun(){
-  if (roiView_->image().isNull()){ QMessageBox::information(this, "Info", "Open an image first."); return; }
-  // Convert QImage back to cv::Mat (BGR)
-  QImage imgQ = roiView_->image().convertToFormat(QImage::Format_RGB888);
-  cv::Mat img(imgQ.height(), imgQ.width(), CV_8UC3, const_cast<uchar*>(imgQ.bits()), imgQ.bytesPerLine());
-  cv::cvtColor(img, img, cv::COLOR_RGB2BGR);
-
-  // Pipeline
-  Pipeline p;
-  p.add(std::make_shared<op::Canny>(50,150,3,true));
-  p.add(std::make_shared<op::Morph>(cv::MORPH_CLOSE, 3, 1));
-  p.add(std::make_shared<op::Threshold>(128.0, cv::THRESH_BINARY));
-  auto proc = p.run(Frame{img,"ui"});
-
-  // ROI from interactive widget
-  QImage maskQ = roiView_->maskImage();
-  if (maskQ.isNull()){ QMessageBox::information(this, "Info", "Please draw an ROI."); return; }
-  cv::Mat mask(maskQ.height(), maskQ.width(), CV_8UC1, const_cast<uchar*>(maskQ.bits()), maskQ.bytesPerLine());
-  cv::Mat masked; proc.mat.copyTo(masked, mask);
-
-  // Determine roi rect
-  QRect qr = roiView_->roiRect();
-  cv::Rect roi(qr.x(), qr.y(), qr.width(), qr.height());
-  cv::Mat roiImg = masked(roi).clone();
-  cv::Mat gray; if (roiImg.channels()==3) cv::cvtColor(roiImg, gray, cv::COLOR_BGR2GRAY); else gray=roiImg;
-
-  // Extract contours
-  std::vector<std::vector<cv::Point>> contours;
-  cv::findContours(gray, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-  std::sort(contours.begin(), contours.end(), [](auto& a, auto& b){ return cv::contourArea(a) > cv::contourArea(b); });
-
-  // Prepare points in full image coords
-  std::vector<cv::Point2f> ptsA, ptsB;
-  if (contours.size() >= 1) for (auto& p: contours[0]) ptsA.push_back(cv::Point2f(p) + cv::Point2f((float)roi.x,(float)roi.y));
-  if (contours.size() >= 2) for (auto& p: contours[1]) ptsB.push_back(cv::Point2f(p) + cv::Point2f((float)roi.x,(float)roi.y));
-
-  Circle circA{{0,0},0}, circB{{0,0},0};
-  bool hasA=false, hasB=false;
-  if (ptsA.size() >= 12){ auto c = fitCircleKasa(ptsA); circA=c; hasA=true; }
-  if (ptsB.size() >= 12){ auto c = fitCircleKasa(ptsB); circB=c; hasB=true; }
-
-  // Lines: use top/bottom separation within roi
-  std::vector<cv::Point2f> topPts, botPts;
-  for (auto& c : contours){
-    for (auto& p : c){
-      cv::Point pt = p + cv::Point(roi.x, roi.y);
-      if (pt.y < roi.y + roi.height*0.5) topPts.push_back(pt);
-      else botPts.push_back(pt);
-    }
-  }
-  Line2D Ltop{{0,0},{1,0}}, Lbot{{0,0},{1,0}}; bool hasTop=false, hasBot=false;
-  if (topPts.size() >= 20){ Ltop = fitLineLSQ(topPts); hasTop=true; }
-  if (botPts.size() >= 20){ Lbot = fitLineLSQ(botPts); hasBot=true; }
+  if (live_->running()){ onRecipeChanged(); return; }   // live mode measures every frame anyway
+  if (image_.empty()){ QMessageBox::information(this, "Info", "Open an image first."); return; }
+  if (roiView_->roiRect().isEmpty()){ QMessageBox::information(this, "Info", "Please draw an ROI."); return; }
+
+  // A new run supersedes whatever is still in flight
+  remeasure_.stop(); remeasurePending_ = false;
+  statusBar()->showMessage("Measuring...");
+  startMeasure();
+}
 
-  // Calibration
-  Calibration cal; cal.scale_mm_per_px = ui->spinScale->value();
+void MainWindow::startMeasure(){
+  if (cancel_) cancel_->store(true);
+  cancel_ = std::make_shared<std::atomic_bool>(false);
+  MeasureRequest req = currentRequest();
+  req.image = image_.mat();
+  req.imageId = imageSerial_;
+  auto session = session_; auto cancel = cancel_;
+  watcher_.setFuture(QtConcurrent::run([session, req, cancel]{ return session->run(req, cancel); }));
+}
+
+MeasureRequest MainWindow::currentRequest() const{
+  MeasureRequest req;
+  req.roi = roiView_->shape();
+  req.roiRect = roiView_->roiRect();
+  req.scaleMmPerPx = ui->spinScale->value();
+  const int bits = ui->comboBitDepth->currentText().toInt();
+  req.bitDepth = bits < 16 ? bits : 0;
+  req.specGap = ui->spinSpecLineGap->value();  req.tolGap = ui->spinTolLineGap->value();
+  req.specDia = ui->spinSpecDiameter->value(); req.tolDia = ui->spinTolDiameter->value();
+  req.tolRoundness = ui->spinTolRoundness->value();
+  req.tolParallelDeg = ui->spinTolParallelDeg->value();
+  req.tolConcentric = ui->spinTolConcentric->value();
+  req.outputSize = ui->labelOutput->size();
+  return req;
+}
 
-  // Clear table
+void MainWindow::onMeasured(){
+  MeasureResult r = watcher_.result();
+  if (r.cancelled) return;
   clearResults();
+  for (auto& row : r.rows) appendResultRow(row.name, row.value, row.spec, row.ok);
+  ui->labelOutput->setPixmap(QPixmap::fromImage(r.overlay));
+  statusBar()->clearMessage();
+  if (remeasurePending_){ remeasurePending_ = false; startMeasure(); }
+}
 
-  // Gauges
-  if (hasTop && hasBot){
-    auto mGap = gauge::metricLineGapMM(Ltop, Lbot, roi, cal);
-    auto mPar = gauge::metricParallelismDeg(Ltop, Lbot);
-    double specGap = ui->spinSpecLineGap->value();
-    double tolGap  = ui->spinTolLineGap->value();
-    bool okGap = std::abs(mGap.value_mm - specGap) <= tolGap + 1e-9;
-    appendResultRow("Line gap (mm)", QString::number(mGap.value_mm,'f',3),
-                    QString("%1±%2").arg(specGap,0,'f',3).arg(tolGap,0,'f',3), okGap);
-    double tolPar = ui->spinTolParallelDeg->value();
-    bool okPar = std::abs(mPar.value_mm) <= tolPar + 1e-9;
-    appendResultRow("Parallelism (deg)", QString::number(mPar.value_mm,'f',3),
-                    QString("≤%1").arg(tolPar,0,'f',3), okPar);
-  } else {
-    appendResultRow("Line gap (mm)", "N/A", "-", false);
-    appendResultRow("Parallelism (deg)", "N/A", "-", false);
-  }
+void MainWindow::startLive(std::unique_ptr<FrameSource> src){
+  if (!src->isOpen()){ QMessageBox::warning(this, "Error", "Cannot open " + src->describe() + "."); return; }
+  if (cancel_) cancel_->store(true);
+  const QString what = src->describe();
+  live_->start(std::move(src));
+  onRecipeChanged();
+  statusBar()->showMessage("Live: " + what);
+}
 
-  if (hasA){
-    auto mDia = gauge::metricDiameterMM(circA, cal);
-    double specDia = ui->spinSpecDiameter->value();
-    double tolDia  = ui->spinTolDiameter->value();
-    bool okDia = std::abs(mDia.value_mm - specDia) <= tolDia + 1e-9;
-    appendResultRow("Diameter A (mm)", QString::number(mDia.value_mm,'f',3),
-                    QString("%1±%2").arg(specDia,0,'f',3).arg(tolDia,0,'f',3), okDia);
-
-    auto mRnd = gauge::metricRoundnessMM(ptsA, cal);
-    double tolRnd = ui->spinTolRoundness->value();
-    bool okRnd = (mRnd.value_mm <= tolRnd + 1e-9);
-    appendResultRow("Roundness A (mm)", QString::number(mRnd.value_mm,'f',3),
-                    QString("≤%1").arg(tolRnd,0,'f',3), okRnd);
-  } else {
-    appendResultRow("Diameter A (mm)", "N/A", "-", false);
-    appendResultRow("Roundness A (mm)", "N/A", "-", false);
-  }
+void MainWindow::onLiveFolder(){
+  auto dir = QFileDialog::getExistingDirectory(this, "Image Folder");
+  if (!dir.isEmpty()) startLive(openFolderSource(dir));
+}
+void MainWindow::onLiveVideo(){
+  auto fn = QFileDialog::getOpenFileName(this, "Video", {}, "Videos (*.avi *.mp4 *.mkv *.mov)");
+  if (!fn.isEmpty()) startLive(openVideoSource(fn));
+}
+void MainWindow::onLiveSynthetic(){ startLive(openSyntheticSource()); }
+void MainWindow::onLiveShm(){
+  bool ok = false;
+  auto key = QInputDialog::getText(this, "Shared Memory Ring", "Key:", QLineEdit::Normal, "myproject_frames", &ok);
+  if (ok && !key.isEmpty()) startLive(openShmSource(key));
+}
+void MainWindow::onLiveStop(){
+  if (!live_->running()) return;
+  live_->stop();
+  liveStats_->clear();
+  statusBar()->showMessage("Live stopped", 3000);
+}
 
-  if (hasA && hasB){
-    auto mCon = gauge::metricConcentricityMM(circA, circB, cal);
-    double tolCon = ui->spinTolConcentric->value();
-    bool okCon = (mCon.value_mm <= tolCon + 1e-9);
-    appendResultRow("Concentricity A-B (mm)", QString::number(mCon.value_mm,'f',3),
-                    QString("≤%1").arg(tolCon,0,'f',3), okCon);
-  } else {
-    appendResultRow("Concentricity A-B (mm)", "N/A", "-", false);
-  }
+void MainWindow::onRecipeChanged(){
+  if (live_->running()){ live_->setRecipe(currentRequest()); return; }
+  if (image_.empty() || roiView_->roiRect().isEmpty()) return;
+  if (!remeasure_.isActive()) remeasure_.start();
+}
 
-  // Visualization
-  cv::Mat vis = img.clone();
-  // ROI overlay from mask
-  cv::Mat maskColor; cv::cvtColor(mask, maskColor, cv::COLOR_GRAY2BGR);
-  cv::Mat overlay = vis.clone();
-  overlay.setTo(cv::Scalar(0,255,255), mask);
-  cv::addWeighted(overlay, 0.3, vis, 0.7, 0.0, vis);
-
-  // Draw circles
-  if (hasA) cv::circle(vis, circA.c, (int)std::round(circA.r), {0,255,0}, 2, cv::LINE_AA);
-  if (hasB) cv::circle(vis, circB.c, (int)std::round(circB.r), {255,0,0}, 2, cv::LINE_AA);
-  // Draw lines
-  auto drawLine = [&](const Line2D& L, const cv::Scalar& col){
-    cv::Point2f p0 = L.p - L.v*1000.f, p1 = L.p + L.v*1000.f;
-    cv::line(vis, p0, p1, col, 1, cv::LINE_AA);
-  };
-  if (hasTop) drawLine(Ltop, {0,255,255});
-  if (hasBot) drawLine(Lbot, {0,128,255});
-
-  ui->labelOutput->setPixmap(QPixmap::fromImage(matToQ(vis)).scaled(ui->labelOutput->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+void MainWindow::onLiveResult(){
+  // Only the newest result is shown; anything older was overwritten in the back buffer
+  if (!live_->takeResult(liveFront_)) return;
+  if (!liveFront_.frame.isNull()) roiView_->setFrame(liveFront_.frame);
+  if (!liveFront_.measure.overlay.isNull()){
+    clearResults();
+    for (auto& row : liveFront_.measure.rows) appendResultRow(row.name, row.value, row.spec, row.ok);
+    ui->labelOutput->setPixmap(QPixmap::fromImage(liveFront_.measure.overlay));
+  }
+  liveStats_->setText(QString("%1 fps | latency %2 ms | dropped %3 of %4")
+                      .arg(liveFront_.fps, 0, 'f', 1).arg(liveFront_.latencyMs, 0, 'f', 1)
+                      .arg(liveFront_.dropped).arg(liveFront_.captured));
 }
 
 void MainWindow::onModeRect(){ roiView_->setMode(RoiView::Mode::Rect); }
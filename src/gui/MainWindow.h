@@ -1,6 +1,12 @@
 #pragma once
 #include <QMainWindow>
 #include <QTableWidget>
+#include <QFutureWatcher>
+#include <QTimer>
+#include "LiveRunner.h"
+#include "MeasureJob.h"
+#include "core/image_buffer.h"
+class QLabel;
 class RoiView;
 
 namespace Ui { class MainWindow; }
@@ -17,9 +23,30 @@ private slots:
   void onModeRing();
   void onModePoly();
   void onClearRoi();
+  void onMeasured();
+  void onLiveFolder();
+  void onLiveVideo();
+  void onLiveSynthetic();
+  void onLiveShm();
+  void onLiveStop();
+  void onLiveResult();
+  void onRecipeChanged();
 private:
+  MeasureRequest currentRequest() const;
+  void startMeasure();
+  void startLive(std::unique_ptr<FrameSource> src);
   void appendResultRow(const QString& name, const QString& value, const QString& spec, bool ok);
   void clearResults();
   Ui::MainWindow* ui;
   RoiView* roiView_;
+  mp::ImageBuffer image_;                    // the opened image, as loaded
+  quint64 imageSerial_ = 0;                  // bumped per opened image; keys the session caches
+  QFutureWatcher<MeasureResult> watcher_;   // tracks only the latest run
+  CancelFlag cancel_;
+  std::shared_ptr<MeasureSession> session_;  // cached stages for interactive re-measurement
+  QTimer remeasure_;                         // coalesces ROI/spec edits to the display rate
+  bool remeasurePending_ = false;
+  LiveRunner* live_;
+  LiveResult liveFront_;                     // front buffer of the live display
+  QLabel* liveStats_;
 };
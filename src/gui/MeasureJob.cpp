@@ -0,0 +1,132 @@
+#include "MeasureJob.h"
+#include <opencv2/imgproc.hpp>
+
+#include "core/image_buffer.h"
+
+using namespace mp;
+
+namespace {
+// The overlay is drawn in colour on 8 bits; 16-bit images are scaled down from `bits` (0 = 16)
+void toDisplay(const cv::Mat& src, int bits, cv::Mat& dst){
+  cv::Mat m8 = src;
+  if (src.depth() != CV_8U) src.convertTo(m8, CV_8U, 255.0/((1 << (bits ? bits : 16)) - 1));
+  if (m8.channels() == 1) cv::cvtColor(m8, dst, cv::COLOR_GRAY2BGR);
+  else dst = m8;
+}
+}
+
+MeasureResult runMeasurement(const MeasureRequest& req, const CancelFlag& cancel){
+  MeasureSession s;
+  MeasureRequest r = req; r.imageId = 0;
+  return s.run(r, cancel);
+}
+
+MeasureResult MeasureSession::run(const MeasureRequest& req, const CancelFlag& cancel){
+  std::lock_guard<std::mutex> lk(mtx_);
+  MeasureResult out;
+  auto cancelled = [&]{ return out.cancelled = cancel && cancel->load(std::memory_order_relaxed); };
+  auto row = [&](const QString& name, const QString& value, const QString& spec, bool ok){
+    out.rows.push_back(MeasureRow{name, value, spec, ok});
+  };
+
+  const cv::Mat& img = req.image;
+  const QRect& qr = req.roiRect;
+  cv::Rect roi = cv::Rect(qr.x(), qr.y(), qr.width(), qr.height()) & cv::Rect(0, 0, img.cols, img.rows);
+  if (roi.empty() || cancelled()) return out;
+
+  // The GUI measures with the contour recipe; only the gauge limits come from the form
+  MeasureSpec spec;
+  spec.mmPerPx = req.scaleMmPerPx;
+  spec.gapTarget = req.specGap; spec.gapTol = req.tolGap;
+  spec.parallelMaxDeg = req.tolParallelDeg;
+  spec.diameterTarget = req.specDia; spec.diameterTol = req.tolDia;
+  spec.roundnessMaxMM = req.tolRoundness;
+  spec.concentricityMaxMM = req.tolConcentric;
+
+  // ---- stage 1: display-sized preview, per image; the engine session keeps
+  // the full-frame edge map for as long as the image id stays the same ----
+  const bool sameImage = req.imageId != 0 && req.imageId == imageId_;
+  // 16-bit files and frames carry no bit count, so it comes from the form;
+  // the session's edge map is keyed on it as well as on the image id
+  spec.setBitDepth(req.bitDepth);
+  if (!sameImage){ imageId_ = req.imageId; haveFeatures_ = false; preview_.release(); }
+  if (req.bitDepth != bits_){ bits_ = req.bitDepth; haveFeatures_ = false; preview_.release(); }
+  if (previewFor_ != req.outputSize || preview_.empty()){
+    // the overlay is drawn at output size, so its cost does not grow with the image
+    const QSize o = req.outputSize;
+    previewScale_ = o.isValid() ? std::min(1.0, std::min(double(o.width())/img.cols, double(o.height())/img.rows)) : 1.0;
+    cv::Mat scaled = img;
+    if (previewScale_ < 1.0) cv::resize(img, scaled, cv::Size(), previewScale_, previewScale_, cv::INTER_AREA);
+    toDisplay(scaled, bits_, preview_);
+    previewFor_ = o;
+    haveFeatures_ = false;   // the preview mask is in preview pixels
+  }
+  if (cancelled()) return out;
+
+  // ---- stage 2: mask, contours and fits, per ROI ---------------------------
+  if (!haveFeatures_ || req.roi != roi_ || req.roiRect != roiRect_){
+    haveFeatures_ = false;
+    Features f;
+    // ROI mask rendered for the ROI box only, rather than on the GUI thread
+    const ImageBuffer maskBuf = ImageBuffer::fromQImage(req.roi.mask(QRect(roi.x, roi.y, roi.width, roi.height)));
+    MeasureRoi region;
+    region.kind = MeasureRoi::Kind::Mask;
+    region.rect = roi;
+    region.mask = maskBuf.mat();
+    session_.extract(img, spec, region, f.features, req.imageId);
+    if (cancelled()) return out;
+
+    // mask in preview pixels for the overlay
+    const double s = previewScale_;
+    f.maskAt = cv::Rect(cv::Point(cvFloor(roi.x*s), cvFloor(roi.y*s)), cv::Point(cvCeil(roi.br().x*s), cvCeil(roi.br().y*s)))
+               & cv::Rect(0, 0, preview_.cols, preview_.rows);
+    if (!f.maskAt.empty()) cv::resize(region.mask, f.maskPreview, f.maskAt.size(), 0, 0, cv::INTER_NEAREST);
+    if (cancelled()) return out;
+    f_ = std::move(f); roi_ = req.roi; roiRect_ = req.roiRect; haveFeatures_ = true;
+  }
+
+  // ---- stage 3: gauges and overlay, per spec --------------------------------
+  const Features& f = f_;
+  const MeasureFeatures& m = f.features;
+  items_.clear(); limits_.clear();
+  MeasurementEngine::Session::evaluate(spec, m, items_, limits_);
+  auto item = [&](const char* name) -> const Item* {
+    for (auto& it : items_) if (it.name == name) return &it;
+    return nullptr;
+  };
+  auto tolText = [](double target, double tol){ return QString("%1±%2").arg(target,0,'f',3).arg(tol,0,'f',3); };
+  auto maxText = [](double max){ return QString("≤%1").arg(max,0,'f',3); };
+  auto metricRow = [&](const char* name, const QString& label, const QString& specText){
+    if (const Item* it = item(name)) row(label, QString::number(it->value,'f',3), specText, it->ok);
+    else row(label, "N/A", "-", false);
+  };
+  metricRow("line_gap", "Line gap (mm)", tolText(req.specGap, req.tolGap));
+  metricRow("parallelism", "Parallelism (deg)", maxText(req.tolParallelDeg));
+  metricRow("diameter_A", "Diameter A (mm)", tolText(req.specDia, req.tolDia));
+  metricRow("roundness_A", "Roundness A (mm)", maxText(req.tolRoundness));
+  metricRow("concentricity_AB", "Concentricity A-B (mm)", maxText(req.tolConcentric));
+  const Circle circA = m.gA.circle, circB = m.gB.circle;
+  const bool hasA = m.gA.valid, hasB = m.gB.valid;
+
+  // Visualization, in preview pixels
+  const float s = (float)previewScale_;
+  cv::Mat vis = preview_.clone();
+  if (!f.maskPreview.empty()){
+    cv::Mat box = vis(f.maskAt), overlay = box.clone();
+    overlay.setTo(cv::Scalar(0,255,255), f.maskPreview);
+    cv::addWeighted(overlay, 0.3, box, 0.7, 0.0, box);
+  }
+  // Draw circles
+  if (hasA) cv::circle(vis, circA.c*s, (int)std::round(circA.r*s), {0,255,0}, 2, cv::LINE_AA);
+  if (hasB) cv::circle(vis, circB.c*s, (int)std::round(circB.r*s), {255,0,0}, 2, cv::LINE_AA);
+  // Draw lines
+  auto drawLine = [&](const Line2D& L, const cv::Scalar& col){
+    cv::Point2f p0 = (L.p - L.v*1000.f)*s, p1 = (L.p + L.v*1000.f)*s;
+    cv::line(vis, p0, p1, col, 1, cv::LINE_AA);
+  };
+  if (m.hasTop) drawLine(m.top, {0,255,255});
+  if (m.hasBot) drawLine(m.bot, {0,128,255});
+
+  out.overlay = ImageBuffer(vis).qimage();
+  return out;
+}
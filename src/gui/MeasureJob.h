@@ -0,0 +1,70 @@
+#pragma once
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "RoiView.h"
+#include "core/measurement_engine.h"
+
+// Snapshot of everything one GUI measurement reads, taken on the GUI thread
+// so the job itself never touches a widget.
+struct MeasureRequest {
+  cv::Mat image;             // BGR or mono 8/16-bit, shared with the caller, never written
+  quint64 imageId = 0;       // same id = same pixels (lets a session reuse stages); 0 = unknown
+  RoiShape roi;
+  QRect roiRect;
+  double scaleMmPerPx = 0.02;
+  int bitDepth = 0;          // significant bits of 16-bit images, set by the user (0 = 16)
+  double specGap = 0, tolGap = 0, specDia = 0, tolDia = 0;
+  double tolRoundness = 0, tolParallelDeg = 0, tolConcentric = 0;
+  QSize outputSize;          // overlay is scaled to this on the worker
+};
+
+struct MeasureRow { QString name, value, spec; bool ok = false; };
+
+struct MeasureResult {
+  bool cancelled = false;
+  std::vector<MeasureRow> rows;
+  QImage overlay;
+};
+
+// Set by the GUI when a newer run supersedes this one; checked between stages.
+using CancelFlag = std::shared_ptr<std::atomic_bool>;
+
+// Runs the engine's recipe in three stages and keeps each stage's output
+// for the next call: a new image redoes everything, an ROI edit redoes the
+// mask, contours and fits on the engine session's cached edge map, and a
+// spec edit redoes only the gauges and the overlay. Calls are serialised.
+class MeasureSession {
+public:
+  MeasureResult run(const MeasureRequest& req, const CancelFlag& cancel);
+private:
+  struct Features {
+    mp::MeasureFeatures features;
+    cv::Mat maskPreview;     // ROI mask in preview pixels
+    cv::Rect maskAt;         // where maskPreview sits in the preview
+  };
+  std::mutex mtx_;
+  mp::MeasurementEngine::Session session_;   // keeps the edge map of imageId_
+  std::vector<mp::Item> items_;
+  std::vector<mp::SpecLimits> limits_;
+  // stage 1: per image
+  quint64 imageId_ = 0;
+  cv::Mat preview_;          // image scaled to the output size, for the overlay
+  QSize previewFor_;
+  double previewScale_ = 1.0;
+  int bits_ = 0;             // bit depth the preview was scaled with
+  // stage 2: per ROI
+  bool haveFeatures_ = false;
+  RoiShape roi_;
+  QRect roiRect_;
+  Features f_;
+};
+
+// One-shot run without caching.
+MeasureResult runMeasurement(const MeasureRequest& req, const CancelFlag& cancel);
@@ -1,6 +1,7 @@
 #include "RoiView.h"
 #include <QPainter>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <QCursor>
 #include <QtMath>
 #include <QPainterPath>
@@ -8,6 +9,8 @@
 RoiView::RoiView(QWidget* parent): QWidget(parent){
     setMouseTracking(true);
     setMinimumSize(320,240);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    tiles_.setMaxCost(256*1024);   // KiB of cached tile pixmaps
 }
 
 void RoiView::setImage(const QImage& img){
@@ -15,6 +18,14 @@ void RoiView::setImage(const QImage& img){
     rectImg_ = QRectF();
     centerImg_ = QPointF(-1,-1);
     polyImg_.clear();
+    resetPyramid();
+    fitView();
+}
+
+void RoiView::setFrame(const QImage& img){
+    if (img.size() != img_.size()) { setImage(img); return; }
+    img_ = img;
+    resetPyramid();
     update();
 }
 
@@ -26,38 +37,86 @@ void RoiView::clearRoi(){
     emit roiChanged();
 }
 
+void RoiView::fitView(){
+    fit_ = true;
+    if (!img_.isNull()){
+        // Fit image into widget preserving aspect (letterbox)
+        double sx = double(width()) / img_.width();
+        double sy = double(height()) / img_.height();
+        scale_ = qMin(sx, sy);
+        offset_ = QPointF((width() - img_.width()*scale_)/2.0, (height() - img_.height()*scale_)/2.0);
+    }
+    update();
+}
+
 QPointF RoiView::toImage(const QPointF& v) const{
     if (img_.isNull()) return v;
-    // Fit image into widget preserving aspect; compute letterbox transform
-    double sx = double(width()) / img_.width();
-    double sy = double(height()) / img_.height();
-    double s = qMin(sx, sy);
-    double w = img_.width()*s, h = img_.height()*s;
-    double ox = (width()-w)/2.0, oy = (height()-h)/2.0;
-    return QPointF( (v.x()-ox)/s, (v.y()-oy)/s );
+    return (v - offset_) / scale_;
 }
 QPointF RoiView::toView(const QPointF& p) const{
     if (img_.isNull()) return p;
-    double sx = double(width()) / img_.width();
-    double sy = double(height()) / img_.height();
-    double s = qMin(sx, sy);
-    double w = img_.width()*s, h = img_.height()*s;
-    double ox = (width()-w)/2.0, oy = (height()-h)/2.0;
-    return QPointF( p.x()*s + ox, p.y()*s + oy );
+    return p*scale_ + offset_;
 }
 
-void RoiView::paintEvent(QPaintEvent*){
-    QPainter g(this);
-    g.fillRect(rect(), Qt::black);
-    if (!img_.isNull()){
-        // draw image
-        double sx = double(width()) / img_.width();
-        double sy = double(height()) / img_.height();
-        double s = qMin(sx, sy);
-        double w = img_.width()*s, h = img_.height()*s;
-        double ox = (width()-w)/2.0, oy = (height()-h)/2.0;
-        g.drawImage(QRectF(ox,oy,w,h), img_);
+void RoiView::resetPyramid(){
+    levels_.clear();
+    tiles_.clear();
+    if (img_.isNull()) return;
+    levels_.push_back(img_);
+    // coarsest level still covers about one tile
+    for (int w = img_.width(), h = img_.height(); w > kTile || h > kTile; w = (w+1)/2, h = (h+1)/2)
+        levels_.emplace_back();
+}
+
+const QImage& RoiView::level(int l){
+    if (levels_[l].isNull()){
+        const QImage& up = level(l-1);
+        levels_[l] = up.scaled((up.width()+1)/2, (up.height()+1)/2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
     }
+    return levels_[l];
+}
+
+const QPixmap* RoiView::tile(int l, int tx, int ty){
+    const quint64 key = (quint64(l) << 48) | (quint64(ty) << 24) | quint64(tx);
+    if (const QPixmap* p = tiles_.object(key)) return p;
+    const QImage& src = level(l);
+    QRect r = QRect(tx*kTile, ty*kTile, kTile, kTile).intersected(src.rect());
+    if (r.isEmpty()) return nullptr;
+    auto* p = new QPixmap(QPixmap::fromImage(src.copy(r)));
+    const int costKiB = qMax(1, r.width()*r.height()*4/1024);
+    return tiles_.insert(key, p, costKiB) ? tiles_.object(key) : nullptr;
+}
+
+void RoiView::drawImageTiles(QPainter& g, const QRect& dirty){
+    // pick the coarsest level that still has at least one texel per screen pixel
+    int l = 0;
+    while (l+1 < (int)levels_.size() && scale_*(1 << (l+1)) <= 1.0) ++l;
+    const double f = double(1 << l);            // level texel -> image pixels
+    const QImage& src = level(l);
+
+    // visible part of the image, in level texels
+    QRectF vis = QRectF(toImage(dirty.topLeft()), toImage(dirty.bottomRight() + QPoint(1,1)));
+    vis = QRectF(vis.topLeft()/f, vis.bottomRight()/f).intersected(QRectF(src.rect()));
+    if (vis.isEmpty()) return;
+    const int tx0 = int(vis.left())/kTile, ty0 = int(vis.top())/kTile;
+    const int tx1 = int(std::ceil(vis.right()))/kTile, ty1 = int(std::ceil(vis.bottom()))/kTile;
+
+    g.setRenderHint(QPainter::SmoothPixmapTransform, scale_*f < 1.0);
+    for (int ty = ty0; ty <= ty1; ++ty){
+        for (int tx = tx0; tx <= tx1; ++tx){
+            const QPixmap* p = tile(l, tx, ty);
+            if (!p) continue;
+            QRectF imgRect(tx*kTile*f, ty*kTile*f, p->width()*f, p->height()*f);
+            g.drawPixmap(QRectF(toView(imgRect.topLeft()), toView(imgRect.bottomRight())), *p, QRectF(p->rect()));
+        }
+    }
+}
+
+void RoiView::paintEvent(QPaintEvent* e){
+    QPainter g(this);
+    g.fillRect(e->rect(), Qt::black);
+    // draw only the tiles under the repainted region, at the matching mip level
+    if (!img_.isNull()) drawImageTiles(g, e->rect());
     // overlay ROI
     g.setRenderHint(QPainter::Antialiasing, true);
     QPen pen(QColor(0,255,0)); pen.setWidth(2); g.setPen(pen);
@@ -67,10 +126,7 @@ void RoiView::paintEvent(QPaintEvent*){
         g.fillRect(vr, brush); g.drawRect(vr);
     } else if (mode_==Mode::Ring && centerImg_.x()>=0){
         QPointF c = toView(centerImg_);
-        double sx = double(width()) / img_.width();
-        double sy = double(height()) / img_.height();
-        double s = qMin(sx, sy);
-        double rIn = rInner_*s, rOut = rOuter_*s;
+        double rIn = rInner_*scale_, rOut = rOuter_*scale_;
         g.setBrush(Qt::NoBrush);
         g.drawEllipse(c, rOut, rOut);
         QPen pin(QColor(0,200,255)); pin.setWidth(2); g.setPen(pin);
@@ -90,7 +146,12 @@ void RoiView::paintEvent(QPaintEvent*){
 
 void RoiView::mousePressEvent(QMouseEvent* e){
     if (img_.isNull()) return;
-    QPointF ip = toImage(e->pos());
+    if (e->button()==Qt::MiddleButton || e->button()==Qt::RightButton){
+        panning_ = true; panLast_ = e->position();
+        setCursor(Qt::ClosedHandCursor);
+        return;
+    }
+    QPointF ip = toImage(e->position());
     if (mode_==Mode::Rect){
         dragging_ = true;
         dragStartImg_ = dragCurImg_ = ip;
@@ -100,12 +161,9 @@ void RoiView::mousePressEvent(QMouseEvent* e){
             centerImg_ = ip; rInner_=20; rOuter_=60;
         } else {
             // choose drag mode based on distance
-            double d = QLineF(toView(centerImg_), e->pos()).length();
-            double sx = double(width()) / img_.width();
-            double sy = double(height()) / img_.height();
-            double s = qMin(sx, sy);
-            if (std::abs(d - rOuter_*s) < 8) ringDrag_ = RingDrag::ResizeOuter;
-            else if (std::abs(d - rInner_*s) < 8) ringDrag_ = RingDrag::ResizeInner;
+            double d = QLineF(toView(centerImg_), e->position()).length();
+            if (std::abs(d - rOuter_*scale_) < 8) ringDrag_ = RingDrag::ResizeOuter;
+            else if (std::abs(d - rInner_*scale_) < 8) ringDrag_ = RingDrag::ResizeInner;
             else ringDrag_ = RingDrag::MoveCenter;
         }
     } else if (mode_==Mode::Polygon){
@@ -113,7 +171,7 @@ void RoiView::mousePressEvent(QMouseEvent* e){
         int nearest=-1; double best=1e9;
         for (int i=0;i<(int)polyImg_.size();++i){
             QPointF v = toView(polyImg_[i]);
-            double d = QLineF(v, e->pos()).length();
+            double d = QLineF(v, e->position()).length();
             if (d<best){ best=d; nearest=i; }
         }
         if (best < 10) { polyDragIdx_ = nearest; }
@@ -124,7 +182,14 @@ void RoiView::mousePressEvent(QMouseEvent* e){
 
 void RoiView::mouseMoveEvent(QMouseEvent* e){
     if (img_.isNull()) return;
-    QPointF ip = toImage(e->pos());
+    if (panning_){
+        offset_ += e->position() - panLast_;
+        panLast_ = e->position();
+        fit_ = false;
+        update();
+        return;
+    }
+    QPointF ip = toImage(e->position());
     if (mode_==Mode::Rect){
         if (dragging_){
             dragCurImg_ = ip;
@@ -153,15 +218,33 @@ void RoiView::mouseMoveEvent(QMouseEvent* e){
 }
 
 void RoiView::mouseReleaseEvent(QMouseEvent*){
+    if (panning_) unsetCursor();
+    panning_ = false;
     dragging_ = false;
     ringDrag_ = RingDrag::None;
     polyDragIdx_ = -1;
 }
 
-void RoiView::resizeEvent(QResizeEvent*){
+void RoiView::mouseDoubleClickEvent(QMouseEvent* e){
+    if (e->button()==Qt::MiddleButton || e->button()==Qt::RightButton) fitView();
+    else mousePressEvent(e);
+}
+
+void RoiView::wheelEvent(QWheelEvent* e){
+    if (img_.isNull()) return;
+    // zoom about the cursor, between 1/4 of fit and 32x
+    const QPointF v = e->position(), anchor = toImage(v);
+    const double fitScale = qMin(double(width()) / img_.width(), double(height()) / img_.height());
+    scale_ = qBound(fitScale/4, scale_*std::pow(1.25, e->angleDelta().y()/120.0), 32.0);
+    offset_ = v - anchor*scale_;
+    fit_ = false;
     update();
 }
 
+void RoiView::resizeEvent(QResizeEvent*){
+    if (fit_) fitView(); else update();
+}
+
 QRect RoiView::roiRect() const{
     if (img_.isNull()) return QRect();
     if (mode_==Mode::Rect && rectImg_.isValid()) return rectImg_.toAlignedRect().intersected(img_.rect());
@@ -176,25 +259,46 @@ QRect RoiView::roiRect() const{
     return QRect();
 }
 
+RoiShape RoiView::shape() const{
+    RoiShape r;
+    if (mode_==Mode::Rect && rectImg_.isValid()){
+        r.kind = RoiShape::Kind::Rect; r.rect = rectImg_;
+    } else if (mode_==Mode::Ring && centerImg_.x()>=0){
+        r.kind = RoiShape::Kind::Ring; r.center = centerImg_; r.rInner = rInner_; r.rOuter = rOuter_;
+    } else if (mode_==Mode::Polygon && polyImg_.size()>=3){
+        r.kind = RoiShape::Kind::Polygon; r.poly = polyImg_;
+    }
+    return r;
+}
+
 QImage RoiView::maskImage() const{
     if (img_.isNull()) return QImage();
-    QImage m(img_.size(), QImage::Format_Grayscale8);
+    return shape().mask(img_.size());
+}
+
+QImage RoiShape::mask(const QSize& size) const{
+    return mask(QRect(QPoint(0,0), size));
+}
+
+QImage RoiShape::mask(const QRect& area) const{
+    QImage m(area.size(), QImage::Format_Grayscale8);
     m.fill(0);
     QPainter g(&m);
+    g.translate(-area.topLeft());
     g.setRenderHint(QPainter::Antialiasing, true);
     g.setPen(Qt::NoPen);
     g.setBrush(Qt::white);
-    if (mode_==Mode::Rect && rectImg_.isValid()){
-        g.drawRect(rectImg_);
-    } else if (mode_==Mode::Ring && centerImg_.x()>=0){
+    if (kind==Kind::Rect){
+        g.drawRect(rect);
+    } else if (kind==Kind::Ring){
         QPainterPath path;
-        path.addEllipse(centerImg_, rOuter_, rOuter_);
+        path.addEllipse(center, rOuter, rOuter);
         QPainterPath hole;
-        hole.addEllipse(centerImg_, rInner_, rInner_);
+        hole.addEllipse(center, rInner, rInner);
         g.drawPath(path.subtracted(hole));
-    } else if (mode_==Mode::Polygon && polyImg_.size()>=3){
-        QPolygonF poly; for (auto&p: polyImg_) poly << p;
-        g.drawPolygon(poly);
+    } else if (kind==Kind::Polygon){
+        QPolygonF p; for (auto& q: poly) p << q;
+        g.drawPolygon(p);
     }
     g.end();
     return m;
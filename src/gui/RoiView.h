@@ -1,9 +1,25 @@
 #pragma once
 #include <QWidget>
 #include <QImage>
+#include <QPixmap>
 #include <QPointF>
+#include <QCache>
 #include <vector>
 
+// Plain copy of the ROI geometry; the mask can be rendered from it on any thread.
+struct RoiShape {
+    enum class Kind { None, Rect, Ring, Polygon } kind = Kind::None;
+    QRectF rect;
+    QPointF center; double rInner = 0, rOuter = 0;
+    std::vector<QPointF> poly;
+    QImage mask(const QSize& size) const;   // 8-bit, white in ROI
+    QImage mask(const QRect& area) const;   // just `area` of the full-image mask
+    bool operator==(const RoiShape& o) const {
+        return kind==o.kind && rect==o.rect && center==o.center && rInner==o.rInner && rOuter==o.rOuter && poly==o.poly;
+    }
+    bool operator!=(const RoiShape& o) const { return !(*this == o); }
+};
+
 class RoiView : public QWidget {
     Q_OBJECT
 public:
@@ -11,8 +27,13 @@ public:
 
     explicit RoiView(QWidget* parent=nullptr);
     void setImage(const QImage& img);
+    void setFrame(const QImage& img);     // like setImage, but keeps the ROI if the size is unchanged
     QImage image() const { return img_; }
 
+    // View: fits the widget until the user zooms (wheel) or pans (middle/right drag);
+    // a middle/right double-click returns to fit.
+    void fitView();
+
     void setMode(Mode m){ mode_ = m; update(); }
     Mode mode() const { return mode_; }
     void clearRoi();
@@ -20,6 +41,7 @@ public:
     // ROI outputs
     QRect roiRect() const;                // bounding rect of the ROI
     QImage maskImage() const;             // 8-bit mask same size as image (white in ROI)
+    RoiShape shape() const;               // current ROI geometry in image coordinates
 signals:
     void roiChanged();
 protected:
@@ -27,12 +49,30 @@ protected:
     void mousePressEvent(QMouseEvent*) override;
     void mouseMoveEvent(QMouseEvent*) override;
     void mouseReleaseEvent(QMouseEvent*) override;
+    void mouseDoubleClickEvent(QMouseEvent*) override;
+    void wheelEvent(QWheelEvent*) override;
     void resizeEvent(QResizeEvent*) override;
 private:
     QPointF toImage(const QPointF& v) const;
     QPointF toView(const QPointF& imgPt) const;
+    void resetPyramid();
+    const QImage& level(int l);
+    const QPixmap* tile(int l, int tx, int ty);
+    void drawImageTiles(QPainter& g, const QRect& dirty);
 
     QImage img_;
+
+    // view transform: view = image*scale_ + offset_
+    double scale_ = 1.0;
+    QPointF offset_;
+    bool fit_ = true;
+    bool panning_ = false;
+    QPointF panLast_;
+
+    // mip pyramid (level l is 1/2^l size), built lazily and drawn in tiles
+    static constexpr int kTile = 256;
+    std::vector<QImage> levels_;
+    QCache<quint64, QPixmap> tiles_;
     Mode mode_ = Mode::Rect;
 
     // Rect
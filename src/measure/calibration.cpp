@@ -1 +1,60 @@
-#include "measure/calibration.h" 
\ No newline at end of file
+#include "measure/calibration.h"
+#include <cmath>
+namespace mp {
+bool LensModel::identity() const{
+  if (k1!=0 || k2!=0 || k3!=0 || p1!=0 || p2!=0) return false;
+  const cv::Matx33d I = cv::Matx33d::eye();
+  for (int i=0;i<9;++i) if (H.val[i]!=I.val[i]) return false;
+  return true;
+}
+
+cv::Point2d LensModel::distort(cv::Point2d px) const{
+  const double x = (px.x-cx)/fx, y = (px.y-cy)/fy;
+  const double r2 = x*x + y*y, rad = 1 + ((k3*r2 + k2)*r2 + k1)*r2;
+  const double xd = x*rad + 2*p1*x*y + p2*(r2 + 2*x*x);
+  const double yd = y*rad + p1*(r2 + 2*y*y) + 2*p2*x*y;
+  return {xd*fx + cx, yd*fy + cy};
+}
+
+cv::Point2d LensModel::undistort(cv::Point2d px) const{
+  const double x0 = (px.x-cx)/fx, y0 = (px.y-cy)/fy;
+  double x = x0, y = y0;
+  for (int it=0; it<10; ++it){
+    const double r2 = x*x + y*y;
+    const double icd = 1.0 / (1 + ((k3*r2 + k2)*r2 + k1)*r2);
+    const double dx = 2*p1*x*y + p2*(r2 + 2*x*x), dy = p1*(r2 + 2*y*y) + 2*p2*x*y;
+    x = (x0 - dx)*icd; y = (y0 - dy)*icd;
+  }
+  return {x*fx + cx, y*fy + cy};
+}
+
+cv::Point2f LensModel::exact(cv::Point2f px) const{
+  const cv::Point2d u = undistort(px);
+  const double w = H(2,0)*u.x + H(2,1)*u.y + H(2,2), iw = w!=0? 1.0/w : 0.0;
+  return {float((H(0,0)*u.x + H(0,1)*u.y + H(0,2))*iw), float((H(1,0)*u.x + H(1,1)*u.y + H(1,2))*iw)};
+}
+
+void LensModel::buildGrid(cv::Size imageSize, int step){
+  CV_Assert(step > 0 && imageSize.width > 0 && imageSize.height > 0);
+  step_ = step;
+  gw_ = (imageSize.width + step-1)/step + 1; gh_ = (imageSize.height + step-1)/step + 1;
+  grid_.resize(size_t(gw_)*gh_);
+  for (int j=0;j<gh_;++j)
+    for (int i=0;i<gw_;++i) grid_[size_t(j)*gw_ + i] = exact({float(i*step), float(j*step)});
+}
+
+cv::Point2f LensModel::map(cv::Point2f px) const{
+  if (grid_.empty()) return exact(px);
+  const float gx = px.x / step_, gy = px.y / step_;
+  const int ix = (int)std::floor(gx), iy = (int)std::floor(gy);
+  if (ix < 0 || iy < 0 || ix >= gw_-1 || iy >= gh_-1) return exact(px);
+  const float ax = gx - ix, ay = gy - iy;
+  const cv::Point2f* g = &grid_[size_t(iy)*gw_ + ix];
+  const cv::Point2f top = g[0]*(1-ax) + g[1]*ax, bot = g[gw_]*(1-ax) + g[gw_+1]*ax;
+  return top*(1-ay) + bot*ay;
+}
+
+void LensModel::map(std::vector<cv::Point2f>& pts) const{
+  for (auto& p : pts) p = map(p);
+}
+}
@@ -1,8 +1,38 @@
 #pragma once
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
 namespace mp {
+// Point-space lens model: Brown-Conrady distortion (k1..k3 radial, p1/p2
+// tangential) about the principal point, then a plane homography H into the
+// rectified pixel frame that scale_mm_per_px refers to. It corrects feature
+// points before fitting instead of undistorting the image. buildGrid()
+// samples the exact inverse on a sparse grid so map() is a bilinear lookup.
+class LensModel {
+public:
+  double fx=1, fy=1, cx=0, cy=0;
+  double k1=0, k2=0, k3=0, p1=0, p2=0;
+  cv::Matx33d H = cv::Matx33d::eye();
+
+  bool identity() const;
+  cv::Point2d distort(cv::Point2d px) const;    // ideal -> observed pixel
+  cv::Point2d undistort(cv::Point2d px) const;  // observed -> ideal pixel (fixed-point iteration)
+  cv::Point2f exact(cv::Point2f px) const;      // undistort, then H
+
+  void buildGrid(cv::Size imageSize, int step=8);
+  bool hasGrid() const { return !grid_.empty(); }
+  cv::Point2f map(cv::Point2f px) const;        // grid lookup; exact() off-grid
+  void map(std::vector<cv::Point2f>& pts) const;
+
+private:
+  std::vector<cv::Point2f> grid_;  // (gw_ x gh_) nodes, row-major
+  int gw_=0, gh_=0, step_=0;
+};
+
 struct Calibration {
   double scale_mm_per_px = 0.02;
   double offset_mm = 0.0;
+  std::shared_ptr<const LensModel> lens;  // optional; corrects points before fitting
   double toMM(double px) const { return scale_mm_per_px * px + offset_mm; }
   double toPX(double mm) const { return (mm - offset_mm) / scale_mm_per_px; }
 };
@@ -3,16 +3,30 @@
 #include <vector>
 #include <algorithm>
 namespace mp {
-CaliperResult caliper1D(const cv::Mat& grayIn, cv::Point2f a, cv::Point2f b, int samples){
-  CV_Assert(!grayIn.empty());
-  cv::Mat gray = grayIn.channels()==1? grayIn : ([&]{cv::Mat g; cv::cvtColor(grayIn,g,cv::COLOR_BGR2GRAY); return g;})();
-  std::vector<float> prof(samples);
+namespace {
+// nearest-pixel profile, read at the image's own depth
+template<class T>
+void sampleProfile(const cv::Mat& gray, cv::Point2f a, cv::Point2f b, std::vector<float>& prof){
+  const int samples = (int)prof.size();
   for (int i=0;i<samples;++i){
     float t=float(i)/(samples-1);
     cv::Point2f p=a*(1.f-t)+b*t;
     int x=std::clamp((int)std::round(p.x),0,gray.cols-1);
     int y=std::clamp((int)std::round(p.y),0,gray.rows-1);
-    prof[i]=gray.at<uchar>(y,x);
+    prof[i]=(float)gray.ptr<T>(y)[x];
+  }
+}
+}
+
+CaliperResult caliper1D(const cv::Mat& grayIn, cv::Point2f a, cv::Point2f b, int samples){
+  CV_Assert(!grayIn.empty());
+  cv::Mat gray = grayIn.channels()==1? grayIn : ([&]{cv::Mat g; cv::cvtColor(grayIn,g,cv::COLOR_BGR2GRAY); return g;})();
+  CV_Assert(gray.depth()==CV_8U || gray.depth()==CV_16U || gray.depth()==CV_32F);
+  std::vector<float> prof(samples);
+  switch (gray.depth()){
+  case CV_8U:  sampleProfile<uchar>(gray, a, b, prof); break;
+  case CV_16U: sampleProfile<ushort>(gray, a, b, prof); break;
+  default:     sampleProfile<float>(gray, a, b, prof); break;
   }
   float best=-1e9f; int bi=-1;
   for (int i=1;i<samples;++i){ float g = prof[i]-prof[i-1]; if (g>best){ best=g; bi=i; } }
@@ -2,5 +2,7 @@
 #include <opencv2/core.hpp>
 namespace mp {
 struct CaliperResult { int index=-1; cv::Point2f position; float response=0.f; };
+// Strongest rising step along a→b. 8U, 16U and 32F images are read at
+// their own depth; `response` is in the image's grey levels.
 CaliperResult caliper1D(const cv::Mat& gray, cv::Point2f a, cv::Point2f b, int samples=256);
 }
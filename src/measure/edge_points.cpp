@@ -0,0 +1,202 @@
+#include "measure/edge_points.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include "core/gray_levels.h"
+namespace mp {
+namespace {
+// Gradient (G) and squared-magnitude (M) types per pixel depth:
+// 8-bit |g| <= 1020 so g^2 fits an int; 16-bit |g| <= 262140 needs float squares
+template<class T> struct Grad;
+template<> struct Grad<uchar>  { using G = short; using M = int; };
+template<> struct Grad<ushort> { using G = int;   using M = float; };
+
+// Sobel gx, gy and squared magnitude of the row between s0 and s2, columns 1..W-2
+template<class T>
+int gradientRowSimd(const T*, const T*, const T*, int, typename Grad<T>::G*, typename Grad<T>::G*, typename Grad<T>::M*){ return 1; }
+
+#if CV_SIMD
+template<>
+int gradientRowSimd<uchar>(const uchar* s0, const uchar* s1, const uchar* s2, int W, short* gx, short* gy, int* m2){
+  int x = 1;
+  const int VL = cv::v_int16::nlanes;
+  auto ld = [](const uchar* p){ return cv::v_reinterpret_as_s16(cv::vx_load_expand(p)); };
+  for (; x <= W-1-VL; x += VL){
+    const cv::v_int16 a0 = ld(s0+x-1), b0 = ld(s0+x), c0 = ld(s0+x+1);
+    const cv::v_int16 a1 = ld(s1+x-1),                 c1 = ld(s1+x+1);
+    const cv::v_int16 a2 = ld(s2+x-1), b2 = ld(s2+x), c2 = ld(s2+x+1);
+    const cv::v_int16 dx = (c0 - a0) + (c1 - a1) + (c1 - a1) + (c2 - a2);
+    const cv::v_int16 dy = (a2 + b2 + b2 + c2) - (a0 + b0 + b0 + c0);
+    cv::v_store(gx+x, dx); cv::v_store(gy+x, dy);
+    cv::v_int32 xl, xh, yl, yh;
+    cv::v_mul_expand(dx, dx, xl, xh); cv::v_mul_expand(dy, dy, yl, yh);
+    cv::v_store(m2+x, xl + yl); cv::v_store(m2+x+VL/2, xh + yh);
+  }
+  return x;
+}
+
+template<>
+int gradientRowSimd<ushort>(const ushort* s0, const ushort* s1, const ushort* s2, int W, int* gx, int* gy, float* m2){
+  int x = 1;
+  const int VL = cv::v_int32::nlanes;
+  auto ld = [](const ushort* p){ return cv::v_reinterpret_as_s32(cv::vx_load_expand(p)); };
+  for (; x <= W-1-VL; x += VL){
+    const cv::v_int32 a0 = ld(s0+x-1), b0 = ld(s0+x), c0 = ld(s0+x+1);
+    const cv::v_int32 a1 = ld(s1+x-1),                 c1 = ld(s1+x+1);
+    const cv::v_int32 a2 = ld(s2+x-1), b2 = ld(s2+x), c2 = ld(s2+x+1);
+    const cv::v_int32 dx = (c0 - a0) + (c1 - a1) + (c1 - a1) + (c2 - a2);
+    const cv::v_int32 dy = (a2 + b2 + b2 + c2) - (a0 + b0 + b0 + c0);
+    cv::v_store(gx+x, dx); cv::v_store(gy+x, dy);
+    const cv::v_float32 fx = cv::v_cvt_f32(dx), fy = cv::v_cvt_f32(dy);
+    cv::v_store(m2+x, fx*fx + fy*fy);
+  }
+  return x;
+}
+#endif
+
+template<class T>
+void gradientRow(const T* s0, const T* s1, const T* s2, int W,
+                 typename Grad<T>::G* gx, typename Grad<T>::G* gy, typename Grad<T>::M* m2){
+  using M = typename Grad<T>::M;
+  for (int x = gradientRowSimd<T>(s0, s1, s2, W, gx, gy, m2); x < W-1; ++x){
+    const int dx = (s0[x+1]-s0[x-1]) + 2*(s1[x+1]-s1[x-1]) + (s2[x+1]-s2[x-1]);
+    const int dy = (s2[x-1] + 2*s2[x] + s2[x+1]) - (s0[x-1] + 2*s0[x] + s0[x+1]);
+    gx[x] = dx; gy[x] = dy; m2[x] = M(dx)*dx + M(dy)*dy;
+  }
+}
+
+// first x in [x, end) where a vector of squared magnitudes may reach thr2
+inline int skipBelow(const int* m, int x, int end, int thr2){
+#if CV_SIMD
+  const int VL = cv::v_int32::nlanes;
+  const cv::v_int32 t = cv::vx_setall_s32(thr2);
+  for (; x <= end-VL && !cv::v_check_any(cv::vx_load(m+x) >= t); x += VL) {}
+#endif
+  return x;
+}
+inline int skipBelow(const float* m, int x, int end, float thr2){
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float32 t = cv::vx_setall_f32(thr2);
+  for (; x <= end-VL && !cv::v_check_any(cv::vx_load(m+x) >= t); x += VL) {}
+#endif
+  return x;
+}
+
+template<class T>
+void edgePointsT(const cv::Mat& gray, EdgePoints& out, double level, const cv::Mat& mask){
+  using G = typename Grad<T>::G;
+  using M = typename Grad<T>::M;
+  const int W = gray.cols, H = gray.rows;
+  // Three rolling gradient rows; image row r lives in slot r % 3
+  std::vector<G> gxb(size_t(3)*W, 0), gyb(size_t(3)*W, 0);
+  std::vector<M> m2b(size_t(3)*W, 0);
+  auto slot = [W](int r){ return (r % 3) * W; };
+  const M thr2 = std::max(M(1), M(std::ceil(level*level)));
+
+  for (int r=1; r<H-1; ++r){
+    gradientRow<T>(gray.ptr<T>(r-1), gray.ptr<T>(r), gray.ptr<T>(r+1), W,
+                   &gxb[slot(r)], &gyb[slot(r)], &m2b[slot(r)]);
+    const int y = r-1;   // suppression needs gradient rows y-1..y+1
+    if (y < 2) continue;
+    const M *m0 = &m2b[slot(y-1)], *m1 = &m2b[slot(y)], *mb = &m2b[slot(y+1)];
+    const G *px = &gxb[slot(y)], *py = &gyb[slot(y)];
+    const uchar* mk = mask.empty()? nullptr : mask.ptr<uchar>(y);
+
+    auto candidate = [&](int x){
+      const M c2 = m1[x];
+      if (c2 < thr2 || (mk && !mk[x])) return;
+      // neighbours across the edge, direction quantised as in cv::Canny (tan 22.5 deg = 13573/2^15)
+      const int gx = px[x], gy = py[x];
+      const int64_t ax = std::abs(gx), ay = std::abs(gy);
+      int dx = 1, dy = 0;
+      if (ay*32768 > ax*13573){
+        if (ax*32768 <= ay*13573){ dx = 0; dy = 1; }
+        else { dx = (gx ^ gy) < 0 ? -1 : 1; dy = 1; }
+      }
+      const M a2 = (dy? m0 : m1)[x-dx], b2 = (dy? mb : m1)[x+dx];
+      if (!(c2 > a2 && c2 >= b2)) return;
+      const float a = std::sqrt((float)a2), c = std::sqrt((float)c2), b = std::sqrt((float)b2);
+      const float d = a - 2*c + b, off = d < 0? 0.5f*(a - b)/d : 0.f;
+      out.pt.emplace_back(x + off*dx, y + off*dy);
+      out.grad.emplace_back((float)gx, (float)gy);
+      out.mag.push_back(c);
+    };
+    // most of a row is below threshold: whole vectors of it are skipped at once
+    for (int x = 2; x < W-2; ){
+      x = skipBelow(m1, x, W-2, thr2);
+      for (const int stop = std::min(W-2, x + 16); x < stop; ++x) candidate(x);
+    }
+  }
+}
+}
+
+void edgePoints(const cv::Mat& grayIn, EdgePoints& out, const EdgePointParams& prm, const cv::Mat& mask){
+  out.clear();
+  CV_Assert(!grayIn.empty() && (grayIn.depth()==CV_8U || grayIn.depth()==CV_16U));
+  CV_Assert(mask.empty() || (mask.type()==CV_8UC1 && mask.size()==grayIn.size()));
+  cv::Mat gray; if (grayIn.channels()==3) cv::cvtColor(grayIn, gray, cv::COLOR_BGR2GRAY); else gray = grayIn;
+  if (gray.cols < 5 || gray.rows < 5) return;
+  // 3x3 Sobel spans 4x full scale; the threshold is on the 8-bit scale
+  const double k = levelScale(gray.depth(), prm.bits);
+  const double level = std::clamp((double)prm.threshold, 0.0, 1500.0) * k;
+  if (gray.depth()==CV_8U) edgePointsT<uchar>(gray, out, level, mask);
+  else edgePointsT<ushort>(gray, out, level, mask);
+}
+
+void outerEdgeGroups(const EdgePoints& pts, std::vector<std::vector<int>>& groups){
+  groups.clear();
+  const int n = (int)pts.size();
+  if (n == 0) return;
+
+  // Union-find over neighbours; points come in raster order, so only a short
+  // window of earlier points can lie within 2 px
+  std::vector<int> parent(n);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](int i){ while (parent[i] != i) i = parent[i] = parent[parent[i]]; return i; };
+  for (int i=0, lo=0; i<n; ++i){
+    const cv::Point2f p = pts.pt[i], g = pts.grad[i];
+    while (pts.pt[lo].y < p.y - 3.f) ++lo;
+    for (int j=lo; j<i; ++j){
+      const cv::Point2f q = pts.pt[j] - p;
+      if (q.x*q.x + q.y*q.y > 4.f || g.dot(pts.grad[j]) <= 0) continue;
+      const int a = find(i), b = find(j);
+      if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+  }
+  std::vector<int> root(n, -1);
+  for (int i=0; i<n; ++i){
+    const int r = find(i);
+    if (root[r] < 0){ root[r] = (int)groups.size(); groups.emplace_back(); }
+    groups[root[r]].push_back(i);
+  }
+
+  std::vector<cv::Rect2f> box(groups.size());
+  for (size_t k=0; k<groups.size(); ++k){
+    float x0 = 1e30f, y0 = 1e30f, x1 = -1e30f, y1 = -1e30f;
+    for (int i : groups[k]){
+      const cv::Point2f& p = pts.pt[i];
+      x0 = std::min(x0, p.x); y0 = std::min(y0, p.y); x1 = std::max(x1, p.x); y1 = std::max(y1, p.y);
+    }
+    box[k] = cv::Rect2f(x0, y0, x1-x0, y1-y0);
+  }
+  std::vector<int> order(groups.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return box[a].area() > box[b].area(); });
+
+  std::vector<std::vector<int>> kept;
+  std::vector<cv::Rect2f> keptBox;
+  for (int k : order){
+    const cv::Rect2f& b = box[k];
+    const bool nested = std::any_of(keptBox.begin(), keptBox.end(), [&](const cv::Rect2f& o){
+      return b.x >= o.x && b.y >= o.y && b.x + b.width <= o.x + o.width && b.y + b.height <= o.y + o.height; });
+    if (nested) continue;
+    kept.push_back(std::move(groups[k]));
+    keptBox.push_back(b);
+  }
+  groups.swap(kept);
+}
+}
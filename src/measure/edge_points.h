@@ -0,0 +1,35 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+namespace mp {
+// Edge points as parallel arrays, in raster order of their pixels. `pt`
+// is an ordinary point set, so fitters and gauges take it directly.
+struct EdgePoints {
+  std::vector<cv::Point2f> pt;    // sub-pixel position
+  std::vector<cv::Point2f> grad;  // Sobel gradient; direction = atan2(gy, gx)
+  std::vector<float> mag;         // |grad|
+  size_t size() const { return pt.size(); }
+  bool empty() const { return pt.empty(); }
+  void clear(){ pt.clear(); grad.clear(); mag.clear(); }
+};
+
+struct EdgePointParams {
+  float threshold = 100.f;   // minimum 3x3 Sobel magnitude on the 8-bit scale (as cv::Canny's)
+  int bits = 0;              // significant bits of 16-bit input, 0 = 16 (core/gray_levels.h)
+};
+
+// 3x3 Sobel gradients and Canny-style non-maximum suppression in one pass
+// over three rolling rows; each maximum is refined by a parabola along its
+// gradient direction. No edge image is produced. 8U and 16U input have
+// their own vector kernels, so deep images are not converted. `mask` (8U,
+// optional) limits where edge points may lie; the two outermost rows and
+// columns never hold points.
+void edgePoints(const cv::Mat& gray, EdgePoints& out, const EdgePointParams& prm = {},
+                const cv::Mat& mask = cv::Mat());
+
+// Groups points closer than 2 px with the same gradient polarity, drops
+// groups whose box lies inside a larger group's box (the analogue of
+// cv::RETR_EXTERNAL) and sorts the rest by box area, largest first.
+// Groups are index lists into `pts`.
+void outerEdgeGroups(const EdgePoints& pts, std::vector<std::vector<int>>& groups);
+}
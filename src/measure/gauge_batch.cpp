@@ -0,0 +1,138 @@
+#include "measure/gauge_batch.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace mp::gauge {
+
+void GaugeBatch::addLinePair(int l1, int l2, const cv::Rect& roiPx, double gapTarget, double gapTol, double maxParallelDeg){
+  CV_Assert(l1>=0 && l1<lines.size() && l2>=0 && l2<lines.size());
+  la_.push_back(l1); lb_.push_back(l2);
+  rx0_.push_back((float)roiPx.x); ry0_.push_back((float)roiPx.y);
+  rx1_.push_back((float)(roiPx.x+roiPx.width)); ry1_.push_back((float)(roiPx.y+roiPx.height));
+  gapTarget_.push_back(gapTarget); gapTol_.push_back(gapTol); parMax_.push_back(maxParallelDeg);
+}
+
+void GaugeBatch::addCirclePair(int c1, int c2, double maxConcentricityMM){
+  CV_Assert(c1>=0 && c1<circles.size() && c2>=0 && c2<circles.size());
+  ca_.push_back(c1); cb_.push_back(c2); concMax_.push_back(maxConcentricityMM);
+}
+
+void GaugeBatch::clear(){
+  lines.clear(); circles.clear();
+  la_.clear(); lb_.clear(); rx0_.clear(); ry0_.clear(); rx1_.clear(); ry1_.clear();
+  gapTarget_.clear(); gapTol_.clear(); parMax_.clear();
+  ca_.clear(); cb_.clear(); concMax_.clear();
+}
+
+void GaugeBatch::evaluate(const mp::Calibration& cal, Result& out) const{
+  constexpr double kRadToDeg = 180.0 / 3.14159265358979323846;
+  const double scale = cal.scale_mm_per_px, offset = cal.offset_mm;
+
+  // ---- line pairs: gather, then straight-line math over columns ----------
+  const int n = (int)la_.size();
+  std::vector<double> ux(n), uy(n), wx(n), wy(n), p1x(n), p1y(n), p2x(n), p2y(n), x0(n), y0(n), x1(n), y1(n);
+  for (int i=0;i<n;++i){
+    const int a=la_[i], b=lb_[i];
+    ux[i]=lines.vx[a]; uy[i]=lines.vy[a]; wx[i]=lines.vx[b]; wy[i]=lines.vy[b];
+    p1x[i]=lines.px[a]; p1y[i]=lines.py[a]; p2x[i]=lines.px[b]; p2y[i]=lines.py[b];
+    x0[i]=rx0_[i]; y0[i]=ry0_[i]; x1[i]=rx1_[i]; y1[i]=ry1_[i];
+  }
+  out.gapMM.resize(n); out.parallelDeg.resize(n); out.gapOk.resize(n); out.parallelOk.resize(n);
+  std::vector<double> cr(n), dt(n);
+  int i=0;
+#if CV_SIMD_64F
+  {
+    const int VL = cv::v_float64::nlanes;
+    const cv::v_float64 zero=cv::vx_setzero_f64(), one=cv::vx_setall_f64(1.0), half=cv::vx_setall_f64(0.5);
+    const cv::v_float64 vs=cv::vx_setall_f64(scale), vo=cv::vx_setall_f64(offset);
+    // slab test along one axis; a zero direction component leaves the slab open
+    auto slab = [&](const cv::v_float64& c, const cv::v_float64& u, const cv::v_float64& lo, const cv::v_float64& hi,
+                    cv::v_float64& t0, cv::v_float64& t1){
+      const cv::v_float64 a = (lo - c)/u, b = (hi - c)/u, open = u == zero;
+      t0 = cv::v_select(open, t0, cv::v_max(t0, cv::v_min(a, b)));
+      t1 = cv::v_select(open, t1, cv::v_min(t1, cv::v_max(a, b)));
+    };
+    for (; i<=n-VL; i+=VL){
+      cv::v_float64 u_x=cv::vx_load(&ux[i]), u_y=cv::vx_load(&uy[i]), w_x=cv::vx_load(&wx[i]), w_y=cv::vx_load(&wy[i]);
+      const cv::v_float64 m1 = cv::v_sqrt(u_x*u_x + u_y*u_y), m2 = cv::v_sqrt(w_x*w_x + w_y*w_y);
+      const cv::v_float64 i1 = cv::v_select(m1 > zero, one/m1, zero), i2 = cv::v_select(m2 > zero, one/m2, zero);
+      u_x = u_x*i1; u_y = u_y*i1; w_x = w_x*i2; w_y = w_y*i2;
+      // L2's normal (-w_y, w_x), oriented like L1's (-u_y, u_x)
+      const cv::v_float64 sg = cv::v_select(w_x*u_x + w_y*u_y < zero, zero - one, one);
+      const cv::v_float64 nx = (zero - w_y)*sg, ny = w_x*sg;
+      const cv::v_float64 c_x = half*(cv::vx_load(&x0[i]) + cv::vx_load(&x1[i]));
+      const cv::v_float64 c_y = half*(cv::vx_load(&y0[i]) + cv::vx_load(&y1[i]));
+      const cv::v_float64 d1 = u_x*(c_y - cv::vx_load(&p1y[i])) - u_y*(c_x - cv::vx_load(&p1x[i]));
+      const cv::v_float64 d2 = nx*(c_x - cv::vx_load(&p2x[i])) + ny*(c_y - cv::vx_load(&p2y[i]));
+      const cv::v_float64 al = d2 - d1, be = nx*u_x + ny*u_y;
+      const cv::v_float64 span = half*cv::v_max(cv::vx_load(&x1[i]) - cv::vx_load(&x0[i]), cv::vx_load(&y1[i]) - cv::vx_load(&y0[i]));
+      cv::v_float64 t0 = zero - span, t1 = span;
+      slab(c_x, u_x, cv::vx_load(&x0[i]), cv::vx_load(&x1[i]), t0, t1);
+      slab(c_y, u_y, cv::vx_load(&y0[i]), cv::vx_load(&y1[i]), t0, t1);
+      // meanAbsLinear over the clipped span
+      const cv::v_float64 g0 = al + be*t0, g1 = al + be*t1, a0 = cv::v_abs(g0), a1 = cv::v_abs(g1);
+      const cv::v_float64 mean = cv::v_select(g0*g1 >= zero, half*(a0 + a1), half*(g0*g0 + g1*g1)/(a0 + a1));
+      cv::v_store(&out.gapMM[i], vs*cv::v_select(t1 > t0, mean, cv::v_abs(al)) + vo);
+      cv::v_store(&cr[i], cv::v_abs(u_x*w_y - u_y*w_x));
+      cv::v_store(&dt[i], cv::v_abs(u_x*w_x + u_y*w_y));
+    }
+  }
+#endif
+  for (; i<n; ++i){
+    double m1 = std::sqrt(ux[i]*ux[i] + uy[i]*uy[i]), m2 = std::sqrt(wx[i]*wx[i] + wy[i]*wy[i]);
+    double i1 = m1>0? 1.0/m1 : 0.0, i2 = m2>0? 1.0/m2 : 0.0;
+    double u_x = ux[i]*i1, u_y = uy[i]*i1, w_x = wx[i]*i2, w_y = wy[i]*i2;
+    // orient L2's normal like L1's (n1 = (-uy, ux))
+    double sg = (w_x*u_x + w_y*u_y) < 0 ? -1.0 : 1.0, nx = -w_y*sg, ny = w_x*sg;
+    double c_x = 0.5*(x0[i]+x1[i]), c_y = 0.5*(y0[i]+y1[i]);
+    double d1 = -u_y*(c_x-p1x[i]) + u_x*(c_y-p1y[i]);
+    double d2 = nx*(c_x-p2x[i]) + ny*(c_y-p2y[i]);
+    double al = d2 - d1, be = nx*u_x + ny*u_y;
+    double span = 0.5*std::max(x1[i]-x0[i], y1[i]-y0[i]), t0 = -span, t1 = span;
+    clipToRect(c_x, c_y, u_x, u_y, x0[i], y0[i], x1[i], y1[i], t0, t1);
+    double px = t1 > t0 ? meanAbsLinear(al + be*t0, al + be*t1) : std::abs(al);
+    out.gapMM[i] = scale*px + offset;
+    cr[i] = std::abs(u_x*w_y - u_y*w_x); dt[i] = std::abs(u_x*w_x + u_y*w_y);
+  }
+  // atan2 has no universal intrinsic; it stays a scalar pass with the tolerance flags
+  for (int k=0;k<n;++k){
+    out.parallelDeg[k] = std::atan2(cr[k], dt[k]) * kRadToDeg;
+    out.gapOk[k] = std::abs(out.gapMM[k] - gapTarget_[k]) <= gapTol_[k] + 1e-9;
+    out.parallelOk[k] = out.parallelDeg[k] <= parMax_[k] + 1e-9;
+  }
+
+  // ---- circle pairs -------------------------------------------------------
+  const int m = (int)ca_.size();
+  std::vector<double> dx(m), dy(m);
+  for (int k=0;k<m;++k){
+    dx[k] = double(circles.cx[ca_[k]]) - circles.cx[cb_[k]];
+    dy[k] = double(circles.cy[ca_[k]]) - circles.cy[cb_[k]];
+  }
+  out.concentricityMM.resize(m); out.concentricityOk.resize(m);
+  i = 0;
+#if CV_SIMD_64F
+  {
+    const int VL = cv::v_float64::nlanes;
+    const cv::v_float64 vs=cv::vx_setall_f64(scale), vo=cv::vx_setall_f64(offset);
+    for (; i<=m-VL; i+=VL){
+      const cv::v_float64 x = cv::vx_load(&dx[i]), y = cv::vx_load(&dy[i]);
+      cv::v_store(&out.concentricityMM[i], vs*cv::v_sqrt(x*x + y*y) + vo);
+    }
+  }
+#endif
+  for (; i<m; ++i) out.concentricityMM[i] = scale*std::sqrt(dx[i]*dx[i] + dy[i]*dy[i]) + offset;
+  for (int k=0;k<m;++k) out.concentricityOk[k] = out.concentricityMM[k] <= concMax_[k] + 1e-9;
+}
+
+std::vector<Metric> GaugeBatch::Result::metrics() const{
+  std::vector<Metric> ms; ms.reserve(2*gapMM.size() + concentricityMM.size());
+  for (size_t i=0;i<gapMM.size();++i){
+    ms.push_back({"line_gap", gapMM[i], ""});
+    ms.push_back({"parallelism", parallelDeg[i], "deg"});
+  }
+  for (double c : concentricityMM) ms.push_back({"concentricity", c, "mm"});
+  return ms;
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+#include "measure/gauges.h"
+
+namespace mp::gauge {
+
+// Features in structure-of-arrays form, referenced by index from the pair lists.
+struct LinesSoA {
+  std::vector<float> px, py, vx, vy;
+  int size() const { return (int)px.size(); }
+  int add(const mp::Line2D& L){ px.push_back(L.p.x); py.push_back(L.p.y); vx.push_back(L.v.x); vy.push_back(L.v.y); return size()-1; }
+  void clear(){ px.clear(); py.clear(); vx.clear(); vy.clear(); }
+};
+struct CirclesSoA {
+  std::vector<float> cx, cy, r;
+  int size() const { return (int)cx.size(); }
+  int add(const mp::Circle& C){ cx.push_back(C.c.x); cy.push_back(C.c.y); r.push_back(C.r); return size()-1; }
+  void clear(){ cx.clear(); cy.clear(); r.clear(); }
+};
+
+// Evaluates many gap / parallelism / concentricity checks in one call. Each
+// stage gathers its pairs into contiguous columns and then runs branch-free
+// loops over them on SIMD double lanes; results match the scalar lineLineDistancePx,
+// lineLineParallelismDeg and circleCenterDistancePx.
+class GaugeBatch {
+public:
+  LinesSoA lines;
+  CirclesSoA circles;
+
+  // Gap is averaged over L1's span inside roiPx; tolerances in mm and deg.
+  void addLinePair(int l1, int l2, const cv::Rect& roiPx, double gapTarget, double gapTol, double maxParallelDeg);
+  void addCirclePair(int c1, int c2, double maxConcentricityMM);
+  int linePairs() const { return (int)la_.size(); }
+  int circlePairs() const { return (int)ca_.size(); }
+  void clear();
+
+  struct Result {
+    std::vector<double> gapMM, parallelDeg, concentricityMM;
+    std::vector<uchar> gapOk, parallelOk, concentricityOk;
+    // Flattened in pair order: line_gap, parallelism per line pair, then concentricity.
+    std::vector<Metric> metrics() const;
+  };
+  void evaluate(const mp::Calibration& cal, Result& out) const;
+
+private:
+  std::vector<int> la_, lb_;
+  std::vector<float> rx0_, ry0_, rx1_, ry1_;
+  std::vector<double> gapTarget_, gapTol_, parMax_;
+  std::vector<int> ca_, cb_;
+  std::vector<double> concMax_;
+};
+
+}
@@ -28,26 +28,25 @@ static double signedDistance(const cv::Point2f& x, const mp::Line2D& L){
 }
 
 double lineLineDistancePx(const mp::Line2D& L1, const mp::Line2D& L2, const cv::Rect& roiPx){
-  // sample K points along the projection of ROI center line onto L1
-  const int K=50;
-  double sum=0; int cnt=0;
-  cv::Point2f center = (roiPx.tl() + roiPx.br())*0.5f;
-  // span along L1 direction within roi width
-  cv::Point2f dir = L1.v; double norm = std::sqrt(dir.x*dir.x + dir.y*dir.y);
-  if (norm==0) return std::abs(signedDistance(center, L2) - signedDistance(center, L1));
-  dir *= (float)(1.0 / norm);
-  float span = std::max(roiPx.width, roiPx.height) * 0.5f;
-  for (int i=0;i<K;++i){
-    float t = (i/(float)(K-1) - 0.5f) * 2.f * span;
-    cv::Point2f p = center + dir * t;
-    if (roiPx.contains(p)){
-      double d1 = signedDistance(p, L1);
-      double d2 = signedDistance(p, L2);
-      sum += std::abs(d2 - d1);
-      ++cnt;
-    }
-  }
-  return cnt>0? sum/cnt : std::abs(signedDistance(center, L2) - signedDistance(center, L1));
+  // mean |d2 - d1| along the segment through the ROI center in L1's direction,
+  // clipped to the ROI; d1 is constant along it and d2 linear, so the average
+  // has a closed form instead of K point samples
+  cv::Point2f center(roiPx.x + roiPx.width*0.5f, roiPx.y + roiPx.height*0.5f);
+  double ux = L1.v.x, uy = L1.v.y, norm = std::sqrt(ux*ux + uy*uy);
+  double m2 = std::sqrt(double(L2.v.x)*L2.v.x + double(L2.v.y)*L2.v.y);
+  if (norm==0 || m2==0) return std::abs(signedDistance(center, L2) - signedDistance(center, L1));
+  ux/=norm; uy/=norm;
+  // L2's normal oriented like L1's so antiparallel fits do not flip the sign
+  double n2x = -L2.v.y/m2, n2y = L2.v.x/m2;
+  if (n2x*(-uy) + n2y*ux < 0){ n2x=-n2x; n2y=-n2y; }
+  double alpha = n2x*(center.x-L2.p.x) + n2y*(center.y-L2.p.y)
+               - (-uy*(center.x-L1.p.x) + ux*(center.y-L1.p.y));
+  double beta = n2x*ux + n2y*uy;
+  double span = std::max(roiPx.width, roiPx.height) * 0.5;
+  double t0 = -span, t1 = span;
+  clipToRect(center.x, center.y, ux, uy, roiPx.x, roiPx.y, roiPx.x+roiPx.width, roiPx.y+roiPx.height, t0, t1);
+  if (!(t1 > t0)) return std::abs(alpha);
+  return meanAbsLinear(alpha + beta*t0, alpha + beta*t1);
 }
 
 double circleCenterDistancePx(const mp::Circle& A, const mp::Circle& B){
@@ -57,15 +56,9 @@ double circleCenterDistancePx(const mp::Circle& A, const mp::Circle& B){
 double diameterPx(const mp::Circle& C){ return C.r * 2.0; }
 
 double roundnessPx(const std::vector<cv::Point2f>& contourPts){
-  // Fit circle, compute max |ri - r_fit|
+  // Fit circle, compute max |ri - r_fit| (fused in one kernel)
   if (contourPts.size() < 6) return 0.0;
-  auto fit = mp::fitCircleKasa(contourPts);
-  double maxdev = 0.0;
-  for (auto& p : contourPts){
-    double ri = std::hypot(double(p.x - fit.c.x), double(p.y - fit.c.y));
-    maxdev = std::max(maxdev, std::abs(ri - fit.r));
-  }
-  return maxdev * 2.0; // roundness often reported as 2*max radial deviation
+  return mp::fitCircleGauge(contourPts).roundnessPx; // roundness often reported as 2*max radial deviation
 }
 
 Metric metricLineGapMM(const mp::Line2D& L1, const mp::Line2D& L2, const cv::Rect& roiPx, const mp::Calibration& cal){
@@ -84,6 +77,9 @@ Metric metricDiameterMM(const mp::Circle& C, const mp::Calibration& cal){
 Metric metricRoundnessMM(const std::vector<cv::Point2f>& contourPts, const mp::Calibration& cal){
   return {"roundness", cal.toMM(roundnessPx(contourPts)), "mm"};
 }
+Metric metricRoundnessMM(const mp::CircleGauge& g, const mp::Calibration& cal){
+  return {"roundness", cal.toMM(g.roundnessPx), "mm"};
+}
 Metric metricConcentricityMM(const mp::Circle& A, const mp::Circle& B, const mp::Calibration& cal){
   return {"concentricity", cal.toMM(circleCenterDistancePx(A,B)), "mm"};
 }
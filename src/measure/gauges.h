@@ -1,7 +1,10 @@
 #pragma once
 #include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "measure/geometry.h"
+#include "measure/geometry_batch.h"
 #include "measure/calibration.h"
 
 
@@ -13,6 +16,18 @@ struct Metric {
   std::string note;    // optional details
 };
 
+// Mean of |g| over a segment on which g varies linearly from g0 to g1.
+inline double meanAbsLinear(double g0, double g1){
+  double a0 = std::abs(g0), a1 = std::abs(g1);
+  return g0*g1 >= 0 ? 0.5*(a0 + a1) : 0.5*(g0*g0 + g1*g1)/(a0 + a1);
+}
+// Clips the parameter range [t0,t1] of c + t*u to the box [x0,x1]x[y0,y1] (slab test).
+inline void clipToRect(double cx, double cy, double ux, double uy,
+                       double x0, double y0, double x1, double y1, double& t0, double& t1){
+  if (ux != 0){ double a=(x0-cx)/ux, b=(x1-cx)/ux; t0=std::max(t0, std::min(a,b)); t1=std::min(t1, std::max(a,b)); }
+  if (uy != 0){ double a=(y0-cy)/uy, b=(y1-cy)/uy; t0=std::max(t0, std::min(a,b)); t1=std::min(t1, std::max(a,b)); }
+}
+
 // compute distance between two lines as average perpendicular distance between
 // projections within a bounding box region (px), then to mm via Calibration.
 double lineLineDistancePx(const mp::Line2D& L1, const mp::Line2D& L2, const cv::Rect& roiPx);
@@ -29,6 +44,7 @@ Metric metricParallelismDeg(const mp::Line2D& L1, const mp::Line2D& L2);
 Metric metricCirclesGapMM(const mp::Circle& A, const mp::Circle& B, const mp::Calibration& cal);
 Metric metricDiameterMM(const mp::Circle& C, const mp::Calibration& cal);
 Metric metricRoundnessMM(const std::vector<cv::Point2f>& contourPts, const mp::Calibration& cal);
+Metric metricRoundnessMM(const mp::CircleGauge& g, const mp::Calibration& cal); // reuses a fused fit
 Metric metricConcentricityMM(const mp::Circle& A, const mp::Circle& B, const mp::Calibration& cal);
 
 } // namespace mp::gauge
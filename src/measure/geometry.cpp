@@ -1,5 +1,9 @@
 #include "measure/geometry.h"
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
 namespace mp {
 Line2D fitLineLSQ(const std::vector<cv::Point2f>& pts){
   CV_Assert(!pts.empty());
@@ -8,15 +12,288 @@ Line2D fitLineLSQ(const std::vector<cv::Point2f>& pts){
 }
 Circle fitCircleKasa(const std::vector<cv::Point2f>& pts){
   CV_Assert(pts.size()>=3);
-  double Sx=0,Sy=0,Sxx=0,Syy=0,Sxy=0,Sx3=0,Sy3=0,Sx2y=0,Sxy2=0;
-  for (auto&p:pts){ double x=p.x,y=p.y,x2=x*x,y2=y*y;
-    Sx+=x;Sy+=y;Sxx+=x2;Syy+=y2;Sxy+=x*y;Sx3+=x2*x;Sy3+=y2*y;Sx2y+=x2*y;Sxy2+=x*y2;}
-  double N=pts.size();
-  double C=N*Sxx - Sx*Sx, D=N*Sxy - Sx*Sy, E=N*Syy - Sy*Sy;
-  double G=.5*(N*(Sx3+Sxy2) - Sx*(Sxx+Syy)), H=.5*(N*(Sy3+Sx2y) - Sy*(Sxx+Syy));
+  CircleMoments m; for (auto&p:pts) m.add(p);
+  Circle c{{0.f,0.f},0.f}; m.fit(c);
+  return c;
+}
+
+LineMoments& LineMoments::operator+=(const LineMoments& o){
+  CV_Assert(origin == o.origin);
+  n+=o.n; sx+=o.sx; sy+=o.sy; sxx+=o.sxx; syy+=o.syy; sxy+=o.sxy;
+  return *this;
+}
+LineMoments& LineMoments::operator-=(const LineMoments& o){
+  CV_Assert(origin == o.origin);
+  n-=o.n; sx-=o.sx; sy-=o.sy; sxx-=o.sxx; syy-=o.syy; sxy-=o.sxy;
+  return *this;
+}
+bool LineMoments::fit(Line2D& L) const{
+  if (n <= 0) return false;
+  double mx=sx/n, my=sy/n;
+  double cxx=sxx/n - mx*mx, cyy=syy/n - my*my, cxy=sxy/n - mx*my;
+  if (cxx + cyy <= 0) return false;
+  double a = 0.5*std::atan2(2*cxy, cxx-cyy);
+  L = Line2D{{float(origin.x+mx), float(origin.y+my)}, {float(std::cos(a)), float(std::sin(a))}};
+  return true;
+}
+
+CircleMoments& CircleMoments::operator+=(const CircleMoments& o){
+  CV_Assert(origin == o.origin);
+  n+=o.n; sx+=o.sx; sy+=o.sy; sxx+=o.sxx; syy+=o.syy; sxy+=o.sxy;
+  sx3+=o.sx3; sy3+=o.sy3; sx2y+=o.sx2y; sxy2+=o.sxy2;
+  return *this;
+}
+CircleMoments& CircleMoments::operator-=(const CircleMoments& o){
+  CV_Assert(origin == o.origin);
+  n-=o.n; sx-=o.sx; sy-=o.sy; sxx-=o.sxx; syy-=o.syy; sxy-=o.sxy;
+  sx3-=o.sx3; sy3-=o.sy3; sx2y-=o.sx2y; sxy2-=o.sxy2;
+  return *this;
+}
+bool CircleMoments::fit(Circle& c) const{
+  if (n <= 0) return false;
+  double N=n;
+  double C=N*sxx - sx*sx, D=N*sxy - sx*sy, E=N*syy - sy*sy;
+  double G=.5*(N*(sx3+sxy2) - sx*(sxx+syy)), H=.5*(N*(sy3+sx2y) - sy*(sxx+syy));
   double denom=C*E - D*D;
-  cv::Point2f c((E*G-D*H)/denom, (C*H-D*G)/denom);
-  float r = std::sqrt((Sxx+Syy + N*(c.x*c.x + c.y*c.y) - 2*(c.x*Sx + c.y*Sy))/N);
-  return Circle{c,r};
+  if (!(std::abs(denom) > 1e-12*(C*C + E*E))) return false;
+  double uc=(E*G-D*H)/denom, vc=(C*H-D*G)/denom;
+  double r2=(sxx+syy + N*(uc*uc + vc*vc) - 2*(uc*sx + vc*sy))/N;
+  c = Circle{{float(origin.x+uc), float(origin.y+vc)}, float(std::sqrt(std::max(0.0, r2)))};
+  return true;
+}
+
+namespace {
+
+// ---- residual kernels ----------------------------------------------------
+// Lines are evaluated against a unit normal, circles against squared radius
+// bounds during consensus so the RANSAC loop needs no sqrt.
+
+int countLineInliers(const cv::Point2f* pts, int n, cv::Point2f p, cv::Point2f nrm, float thr){
+  const float* xy = &pts[0].x;
+  int i=0, cnt=0;
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float32 vpx=cv::vx_setall_f32(p.x), vpy=cv::vx_setall_f32(p.y);
+  const cv::v_float32 vnx=cv::vx_setall_f32(nrm.x), vny=cv::vx_setall_f32(nrm.y);
+  const cv::v_float32 vthr=cv::vx_setall_f32(thr), one=cv::vx_setall_f32(1.f), zero=cv::vx_setzero_f32();
+  cv::v_float32 acc=zero;
+  for (; i<=n-VL; i+=VL){
+    cv::v_float32 x, y; cv::v_load_deinterleave(xy+2*i, x, y);
+    cv::v_float32 r = (x-vpx)*vnx + (y-vpy)*vny;
+    acc += cv::v_select(cv::v_abs(r) <= vthr, one, zero);
+  }
+  cnt = (int)cv::v_reduce_sum(acc);
+#endif
+  for (; i<n; ++i){
+    float r = (xy[2*i]-p.x)*nrm.x + (xy[2*i+1]-p.y)*nrm.y;
+    cnt += std::abs(r) <= thr;
+  }
+  return cnt;
+}
+
+int countCircleInliers(const cv::Point2f* pts, int n, cv::Point2f c, float lo2, float hi2){
+  const float* xy = &pts[0].x;
+  int i=0, cnt=0;
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float32 vcx=cv::vx_setall_f32(c.x), vcy=cv::vx_setall_f32(c.y);
+  const cv::v_float32 vlo=cv::vx_setall_f32(lo2), vhi=cv::vx_setall_f32(hi2);
+  const cv::v_float32 one=cv::vx_setall_f32(1.f), zero=cv::vx_setzero_f32();
+  cv::v_float32 acc=zero;
+  for (; i<=n-VL; i+=VL){
+    cv::v_float32 x, y; cv::v_load_deinterleave(xy+2*i, x, y);
+    cv::v_float32 dx = x-vcx, dy = y-vcy, d2 = dx*dx + dy*dy;
+    acc += cv::v_select((d2 >= vlo) & (d2 <= vhi), one, zero);
+  }
+  cnt = (int)cv::v_reduce_sum(acc);
+#endif
+  for (; i<n; ++i){
+    float dx = xy[2*i]-c.x, dy = xy[2*i+1]-c.y, d2 = dx*dx + dy*dy;
+    cnt += (d2 >= lo2 && d2 <= hi2);
+  }
+  return cnt;
+}
+
+cv::Point2f unitNormal(const Line2D& L){
+  float n = std::sqrt(L.v.x*L.v.x + L.v.y*L.v.y);
+  return n>0? cv::Point2f(-L.v.y/n, L.v.x/n) : cv::Point2f(0.f, 1.f);
+}
+
+// ---- minimal and weighted models -----------------------------------------
+
+bool lineFrom2(const cv::Point2f& a, const cv::Point2f& b, Line2D& L){
+  cv::Point2f v = b-a; float n = std::sqrt(v.x*v.x + v.y*v.y);
+  if (n < 1e-6f) return false;
+  L = Line2D{a, v*(1.f/n)};
+  return true;
+}
+
+bool circleFrom3(const cv::Point2f& a, const cv::Point2f& b, const cv::Point2f& c, Circle& C){
+  double bx=b.x-a.x, by=b.y-a.y, cx=c.x-a.x, cy=c.y-a.y;
+  double d = 2.0*(bx*cy - by*cx);
+  if (std::abs(d) < 1e-9) return false;
+  double b2=bx*bx+by*by, c2=cx*cx+cy*cy;
+  double ux=(cy*b2 - by*c2)/d, uy=(bx*c2 - cx*b2)/d;
+  C = Circle{{float(a.x+ux), float(a.y+uy)}, float(std::sqrt(ux*ux+uy*uy))};
+  return true;
+}
+
+// Weighted refits, centred on the weighted mean to keep the sums small;
+// false when all weights vanish.
+cv::Point2f weightedMean(const std::vector<cv::Point2f>& pts, const std::vector<float>& w){
+  double Sw=0, mx=0, my=0;
+  for (size_t i=0;i<pts.size();++i){ Sw+=w[i]; mx+=w[i]*pts[i].x; my+=w[i]*pts[i].y; }
+  return Sw>0? cv::Point2f(float(mx/Sw), float(my/Sw)) : pts[0];
+}
+
+bool weightedLine(const std::vector<cv::Point2f>& pts, const std::vector<float>& w, Line2D& L){
+  LineMoments m(weightedMean(pts, w));
+  for (size_t i=0;i<pts.size();++i) if (w[i]>0) m.add(pts[i], w[i]);
+  return m.fit(L);
+}
+
+bool weightedKasa(const std::vector<cv::Point2f>& pts, const std::vector<float>& w, Circle& C){
+  CircleMoments m(weightedMean(pts, w));
+  for (size_t i=0;i<pts.size();++i) if (w[i]>0) m.add(pts[i], w[i]);
+  return m.fit(C);
+}
+
+int adaptiveIterations(int inliers, int n, int sampleSize, const RobustFitParams& prm){
+  double w = double(inliers)/n;
+  double pw = std::pow(w, sampleSize);
+  if (pw >= 1.0 - 1e-12) return 0;
+  if (pw <= 1e-12) return prm.maxIterations;
+  double k = std::log(1.0 - prm.confidence) / std::log(1.0 - pw);
+  return (int)std::min<double>(prm.maxIterations, std::ceil(k));
+}
+
+void lossWeights(const std::vector<float>& res, const RobustFitParams& prm, std::vector<float>& w){
+  w.resize(res.size());
+  const bool tukey = prm.loss==RobustFitParams::Loss::Tukey;
+  float s = float(prm.lossScalePx>0? prm.lossScalePx : (tukey? 2.0 : 1.0)*prm.inlierThresholdPx);
+  for (size_t i=0;i<res.size();++i){
+    float a = std::abs(res[i]);
+    if (tukey){ float q = a/s; w[i] = q<1.f? (1.f-q*q)*(1.f-q*q) : 0.f; }
+    else w[i] = a<=s? 1.f : (a<=3.f*s? s/a : 0.f); // gated: gross outliers stay out of the refit
+  }
+}
+
+FitQuality summarize(const std::vector<float>& res, float thr, std::vector<uchar>& mask){
+  FitQuality q; mask.assign(res.size(), 0);
+  double ss=0;
+  for (size_t i=0;i<res.size();++i){
+    float a = std::abs(res[i]);
+    if (a <= thr){ mask[i]=1; ++q.inliers; ss+=double(a)*a; q.maxAbsPx=std::max(q.maxAbsPx, double(a)); }
+  }
+  q.inlierRatio = res.empty()? 0.0 : double(q.inliers)/res.size();
+  q.rmsPx = q.inliers>0? std::sqrt(ss/q.inliers) : 0.0;
+  return q;
+}
+
+} // namespace
+
+void lineResiduals(const std::vector<cv::Point2f>& pts, const Line2D& L, std::vector<float>& out){
+  const int n = (int)pts.size(); out.resize(n);
+  if (n==0) return;
+  const cv::Point2f nrm = unitNormal(L);
+  const float* xy = &pts[0].x; float* r = out.data();
+  int i=0;
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float32 vpx=cv::vx_setall_f32(L.p.x), vpy=cv::vx_setall_f32(L.p.y);
+  const cv::v_float32 vnx=cv::vx_setall_f32(nrm.x), vny=cv::vx_setall_f32(nrm.y);
+  for (; i<=n-VL; i+=VL){
+    cv::v_float32 x, y; cv::v_load_deinterleave(xy+2*i, x, y);
+    cv::v_store(r+i, (x-vpx)*vnx + (y-vpy)*vny);
+  }
+#endif
+  for (; i<n; ++i) r[i] = (xy[2*i]-L.p.x)*nrm.x + (xy[2*i+1]-L.p.y)*nrm.y;
+}
+
+void circleResiduals(const std::vector<cv::Point2f>& pts, const Circle& C, std::vector<float>& out){
+  const int n = (int)pts.size(); out.resize(n);
+  if (n==0) return;
+  const float* xy = &pts[0].x; float* r = out.data();
+  int i=0;
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float32 vcx=cv::vx_setall_f32(C.c.x), vcy=cv::vx_setall_f32(C.c.y), vr=cv::vx_setall_f32(C.r);
+  for (; i<=n-VL; i+=VL){
+    cv::v_float32 x, y; cv::v_load_deinterleave(xy+2*i, x, y);
+    cv::v_float32 dx = x-vcx, dy = y-vcy;
+    cv::v_store(r+i, cv::v_sqrt(dx*dx + dy*dy) - vr);
+  }
+#endif
+  for (; i<n; ++i){
+    float dx = xy[2*i]-C.c.x, dy = xy[2*i+1]-C.c.y;
+    r[i] = std::sqrt(dx*dx + dy*dy) - C.r;
+  }
+}
+
+RobustLine fitLineRobust(const std::vector<cv::Point2f>& pts, const RobustFitParams& prm){
+  CV_Assert(pts.size()>=2);
+  const int n = (int)pts.size();
+  const float thr = (float)prm.inlierThresholdPx;
+  std::mt19937 rng(prm.seed);
+  std::uniform_int_distribution<int> pick(0, n-1);
+
+  RobustLine out; out.line = Line2D{pts[0], {1,0}};
+  int best=-1, need=prm.maxIterations, it=0;
+  for (; it<need; ++it){
+    int a=pick(rng), b=pick(rng);
+    Line2D L; if (a==b || !lineFrom2(pts[a], pts[b], L)) continue;
+    int c = countLineInliers(pts.data(), n, L.p, unitNormal(L), thr);
+    if (c > best){
+      best=c; out.line=L;
+      need = std::min(need, adaptiveIterations(best, n, 2, prm));
+      if (best==n) { ++it; break; }
+    }
+  }
+  if (best < 2) out.line = fitLineLSQ(pts);
+
+  std::vector<float> res, w;
+  for (int k=0;k<prm.irlsIterations;++k){
+    lineResiduals(pts, out.line, res);
+    lossWeights(res, prm, w);
+    if (!weightedLine(pts, w, out.line)) break;
+  }
+  lineResiduals(pts, out.line, res);
+  out.quality = summarize(res, thr, out.inliers);
+  out.quality.iterations = it;
+  return out;
+}
+
+RobustCircle fitCircleRobust(const std::vector<cv::Point2f>& pts, const RobustFitParams& prm){
+  CV_Assert(pts.size()>=3);
+  const int n = (int)pts.size();
+  const float thr = (float)prm.inlierThresholdPx;
+  std::mt19937 rng(prm.seed);
+  std::uniform_int_distribution<int> pick(0, n-1);
+
+  RobustCircle out; out.circle = Circle{pts[0], 0.f};
+  int best=-1, need=prm.maxIterations, it=0;
+  for (; it<need; ++it){
+    int a=pick(rng), b=pick(rng), c=pick(rng);
+    Circle C; if (a==b || b==c || a==c || !circleFrom3(pts[a], pts[b], pts[c], C)) continue;
+    float lo = std::max(0.f, C.r-thr), hi = C.r+thr;
+    int cnt = countCircleInliers(pts.data(), n, C.c, lo*lo, hi*hi);
+    if (cnt > best){
+      best=cnt; out.circle=C;
+      need = std::min(need, adaptiveIterations(best, n, 3, prm));
+      if (best==n) { ++it; break; }
+    }
+  }
+  if (best < 3) out.circle = fitCircleKasa(pts);
+
+  std::vector<float> res, w;
+  for (int k=0;k<prm.irlsIterations;++k){
+    circleResiduals(pts, out.circle, res);
+    lossWeights(res, prm, w);
+    if (!weightedKasa(pts, w, out.circle)) break;
+  }
+  circleResiduals(pts, out.circle, res);
+  out.quality = summarize(res, thr, out.inliers);
+  out.quality.iterations = it;
+  return out;
 }
 }
@@ -10,4 +10,69 @@ inline float distancePointToLine(const cv::Point2f& x, const Line2D& L){
   cv::Point2f w = x-L.p; float num = std::abs(w.x*L.v.y - w.y*L.v.x);
   float den = std::sqrt(L.v.x*L.v.x + L.v.y*L.v.y); return den>0? num/den : 0.f;
 }
+
+// Moment accumulators: the LSQ line and Kasa circle only need these sums, so
+// points can be added/removed one at a time and partial results from tiles,
+// threads or streaming edge detectors merged without a point vector. Sums are
+// taken relative to `origin` (keep it near the data); merging requires equal
+// origins. Weights enable IRLS-style reweighting.
+struct LineMoments {
+  cv::Point2f origin{0.f, 0.f};
+  double n=0, sx=0, sy=0, sxx=0, syy=0, sxy=0;
+  LineMoments() = default;
+  explicit LineMoments(cv::Point2f o): origin(o) {}
+  void add(const cv::Point2f& p, double w=1.0){
+    double x=p.x-origin.x, y=p.y-origin.y;
+    n+=w; sx+=w*x; sy+=w*y; sxx+=w*x*x; syy+=w*y*y; sxy+=w*x*y;
+  }
+  void remove(const cv::Point2f& p, double w=1.0){ add(p, -w); }
+  LineMoments& operator+=(const LineMoments& o);
+  LineMoments& operator-=(const LineMoments& o);
+  bool fit(Line2D& L) const;   // false when empty or all points coincide
+};
+struct CircleMoments {
+  cv::Point2f origin{0.f, 0.f};
+  double n=0, sx=0, sy=0, sxx=0, syy=0, sxy=0, sx3=0, sy3=0, sx2y=0, sxy2=0;
+  CircleMoments() = default;
+  explicit CircleMoments(cv::Point2f o): origin(o) {}
+  void add(const cv::Point2f& p, double w=1.0){
+    double x=p.x-origin.x, y=p.y-origin.y, x2=x*x, y2=y*y;
+    n+=w; sx+=w*x; sy+=w*y; sxx+=w*x2; syy+=w*y2; sxy+=w*x*y;
+    sx3+=w*x2*x; sy3+=w*y2*y; sx2y+=w*x2*y; sxy2+=w*x*y2;
+  }
+  void remove(const cv::Point2f& p, double w=1.0){ add(p, -w); }
+  CircleMoments& operator+=(const CircleMoments& o);
+  CircleMoments& operator-=(const CircleMoments& o);
+  bool fit(Circle& c) const;   // Kasa solve; false when degenerate (collinear, <3 points)
+};
+
+// Robust fitting: RANSAC on minimal samples (adaptive iteration count, stops
+// as soon as the consensus set is large enough for `confidence`), then IRLS
+// refinement of the winner with a Huber or Tukey weight function.
+struct RobustFitParams {
+  enum class Loss { Huber, Tukey };
+  double inlierThresholdPx = 1.0;  // |residual| bound for consensus / final mask
+  double confidence = 0.99;        // probability of drawing one clean sample
+  int maxIterations = 500;
+  int irlsIterations = 5;
+  Loss loss = Loss::Tukey;
+  double lossScalePx = 0.0;        // Huber k / Tukey c; 0 = derived from threshold
+  unsigned seed = 12345;
+};
+struct FitQuality {
+  int inliers = 0;          // points with |residual| <= inlierThresholdPx
+  int iterations = 0;       // RANSAC hypotheses evaluated
+  double inlierRatio = 0.0;
+  double rmsPx = 0.0;       // over inliers
+  double maxAbsPx = 0.0;    // over inliers
+};
+struct RobustLine { Line2D line; std::vector<uchar> inliers; FitQuality quality; };
+struct RobustCircle { Circle circle; std::vector<uchar> inliers; FitQuality quality; };
+
+RobustLine fitLineRobust(const std::vector<cv::Point2f>& pts, const RobustFitParams& prm = {});
+RobustCircle fitCircleRobust(const std::vector<cv::Point2f>& pts, const RobustFitParams& prm = {});
+
+// Signed residuals (perpendicular distance / radial deviation), SIMD over all points.
+void lineResiduals(const std::vector<cv::Point2f>& pts, const Line2D& L, std::vector<float>& out);
+void circleResiduals(const std::vector<cv::Point2f>& pts, const Circle& C, std::vector<float>& out);
 }
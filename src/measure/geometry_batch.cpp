@@ -0,0 +1,103 @@
+#include "measure/geometry_batch.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+namespace mp {
+namespace {
+
+// Fills the moments of s (origin already set) for n points. Points are
+// widened to double before the origin is subtracted and the sums stay in
+// double lanes, so long contours far from the image origin keep the
+// precision of CircleMoments::add.
+void accumulate(const float* x, const float* y, int n, CircleMoments& s){
+  const double x0 = s.origin.x, y0 = s.origin.y;
+  int i=0;
+#if CV_SIMD_64F
+  const int VL = cv::v_float32::nlanes;
+  const cv::v_float64 vx0=cv::vx_setall_f64(x0), vy0=cv::vx_setall_f64(y0);
+  cv::v_float64 a0=cv::vx_setzero_f64(), a1=a0, a2=a0, a3=a0, a4=a0, a5=a0, a6=a0, a7=a0, a8=a0;
+  auto add = [&](const cv::v_float64& u, const cv::v_float64& v){
+    const cv::v_float64 uu = u*u, vv = v*v;
+    a0 += u; a1 += v; a2 += uu; a3 += vv; a4 += u*v;
+    a5 += uu*u; a6 += vv*v; a7 += uu*v; a8 += u*vv;
+  };
+  for (; i<=n-VL; i+=VL){
+    const cv::v_float32 fx = cv::vx_load(x+i), fy = cv::vx_load(y+i);
+    add(cv::v_cvt_f64(fx) - vx0, cv::v_cvt_f64(fy) - vy0);
+    add(cv::v_cvt_f64_high(fx) - vx0, cv::v_cvt_f64_high(fy) - vy0);
+  }
+  s.sx += cv::v_reduce_sum(a0); s.sy += cv::v_reduce_sum(a1);
+  s.sxx += cv::v_reduce_sum(a2); s.syy += cv::v_reduce_sum(a3); s.sxy += cv::v_reduce_sum(a4);
+  s.sx3 += cv::v_reduce_sum(a5); s.sy3 += cv::v_reduce_sum(a6);
+  s.sx2y += cv::v_reduce_sum(a7); s.sxy2 += cv::v_reduce_sum(a8);
+#endif
+  s.n += n;
+  for (; i<n; ++i){
+    double u=x[i]-x0, v=y[i]-y0, uu=u*u, vv=v*v;
+    s.sx+=u; s.sy+=v; s.sxx+=uu; s.syy+=vv; s.sxy+=u*v;
+    s.sx3+=uu*u; s.sy3+=vv*v; s.sx2y+=uu*v; s.sxy2+=u*vv;
+  }
+}
+
+void radialRange(const float* x, const float* y, int n, float cx, float cy, float& mn, float& mx){
+  int i=0; mn = FLT_MAX; mx = 0.f;
+#if CV_SIMD
+  const int VL = cv::v_float32::nlanes;
+  if (n >= VL){
+    const cv::v_float32 vcx=cv::vx_setall_f32(cx), vcy=cv::vx_setall_f32(cy);
+    cv::v_float32 vmn=cv::vx_setall_f32(FLT_MAX), vmx=cv::vx_setzero_f32();
+    for (; i<=n-VL; i+=VL){
+      cv::v_float32 dx = cv::vx_load(x+i) - vcx, dy = cv::vx_load(y+i) - vcy;
+      cv::v_float32 d2 = dx*dx + dy*dy;
+      vmn = cv::v_min(vmn, d2); vmx = cv::v_max(vmx, d2);
+    }
+    mn = cv::v_reduce_min(vmn); mx = cv::v_reduce_max(vmx);
+  }
+#endif
+  for (; i<n; ++i){
+    float dx = x[i]-cx, dy = y[i]-cy, d2 = dx*dx + dy*dy;
+    mn = std::min(mn, d2); mx = std::max(mx, d2);
+  }
+}
+
+CircleGauge fitOne(const float* x, const float* y, int n){
+  CircleGauge g; g.count = n;
+  CircleMoments m(cv::Point2f(x[0], y[0]));
+  accumulate(x, y, n, m);
+  if (!m.fit(g.circle)) return g;
+  const double r = g.circle.r;
+  g.diameterPx = 2.0*r;
+
+  float mn2, mx2; radialRange(x, y, n, g.circle.c.x, g.circle.c.y, mn2, mx2);
+  double maxdev = std::max(std::sqrt(double(mx2)) - r, r - std::sqrt(double(mn2)));
+  g.roundnessPx = 2.0*std::max(0.0, maxdev);
+  g.valid = true;
+  return g;
+}
+
+} // namespace
+
+void fitCirclesBatch(const PointSetsSoA& sets, std::vector<CircleGauge>& out, int minPoints){
+  const int K = sets.size();
+  out.assign(K, CircleGauge{});
+  auto body = [&](const cv::Range& r){
+    for (int k=r.start; k<r.end; ++k){
+      int n = sets.count(k);
+      if (n < std::max(3, minPoints)){ out[k].count = n; continue; }
+      int o = sets.offsets[k];
+      out[k] = fitOne(sets.x.data()+o, sets.y.data()+o, n);
+    }
+  };
+  // small batches are cheaper inline than waking the thread pool
+  if (K >= 8) cv::parallel_for_(cv::Range(0, K), body);
+  else body(cv::Range(0, K));
+}
+
+CircleGauge fitCircleGauge(const std::vector<cv::Point2f>& pts){
+  PointSetsSoA s; s.add(pts);
+  std::vector<CircleGauge> out; fitCirclesBatch(s, out);
+  return out[0];
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+#include "measure/geometry.h"
+namespace mp {
+
+// Many point sets packed structure-of-arrays; set k owns [offsets[k], offsets[k+1]).
+struct PointSetsSoA {
+  std::vector<float> x, y;
+  std::vector<int> offsets{0};
+  int size() const { return (int)offsets.size()-1; }
+  int count(int k) const { return offsets[k+1]-offsets[k]; }
+  void clear(){ x.clear(); y.clear(); offsets.assign(1, 0); }
+  template<class P> void add(const std::vector<P>& pts, cv::Point2f shift = {0.f, 0.f}){
+    x.reserve(x.size()+pts.size()); y.reserve(y.size()+pts.size());
+    for (auto& p : pts){ x.push_back(float(p.x)+shift.x); y.push_back(float(p.y)+shift.y); }
+    offsets.push_back((int)x.size());
+  }
+};
+
+// Kasa fit and radial deviation of one set, produced by a single fused kernel.
+struct CircleGauge {
+  Circle circle{{0.f, 0.f}, 0.f};
+  double diameterPx = 0.0;
+  double roundnessPx = 0.0;  // 2 * max |r_i - r|
+  int count = 0;
+  bool valid = false;
+};
+
+// Fits every set (sets below minPoints stay invalid). Accumulation runs on
+// SIMD double lanes relative to each set's first point; the deviation pass
+// tracks min/max squared radius so no per-point sqrt is needed.
+void fitCirclesBatch(const PointSetsSoA& sets, std::vector<CircleGauge>& out, int minPoints = 3);
+CircleGauge fitCircleGauge(const std::vector<cv::Point2f>& pts);
+
+}
@@ -0,0 +1,149 @@
+#include "measure/locator.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+namespace mp {
+namespace {
+constexpr int kMinCoarseSide = 24;   // auto levels stop before the template gets smaller
+constexpr int kSearchRadius = 3;     // per-level re-search window (px at that level)
+constexpr double kRadToDeg = 57.29577951308232;
+
+cv::Mat toGray(const cv::Mat& img){
+  cv::Mat g; if (img.channels()==3) cv::cvtColor(img, g, cv::COLOR_BGR2GRAY); else g = img;
+  return g;
+}
+// matchTemplate takes 8U or 32F of equal depth. 16-bit images (or a 16-bit
+// image against an 8-bit reference) are matched in float, which the
+// gain/offset invariance of TM_CCOEFF_NORMED allows.
+bool needsFloat(const cv::Mat& img, const cv::Mat& t){
+  return img.depth() != t.depth() || (img.depth() != CV_8U && img.depth() != CV_32F);
+}
+void match(const cv::Mat& img, const cv::Mat& t, cv::Mat& res){
+  if (!needsFloat(img, t)){ cv::matchTemplate(img, t, res, cv::TM_CCOEFF_NORMED); return; }
+  cv::Mat a, b;
+  if (img.depth()==CV_32F) a = img; else img.convertTo(a, CV_32F);
+  if (t.depth()==CV_32F) b = t; else t.convertTo(b, CV_32F);
+  cv::matchTemplate(a, b, res, cv::TM_CCOEFF_NORMED);
+}
+// vertex offset of a parabola through (-1,a) (0,b) (1,c)
+double peak(double a, double b, double c){
+  double d = a - 2*b + c; return d < 0? std::clamp(0.5*(a - c)/d, -0.5, 0.5) : 0.0;
+}
+}
+
+bool ShapeLocator::train(const cv::Mat& refIn, const cv::Rect& regionIn, const LocatorParams& prm){
+  prm_ = prm; patch_.clear(); patchCenter_.clear(); size_.clear(); coarse_.clear(); coarseAngles_.clear();
+  cv::Mat ref = toGray(refIn);
+  const cv::Rect region = regionIn & cv::Rect(0, 0, ref.cols, ref.rows);
+  if (region.width < 8 || region.height < 8) return false;
+  int levels = prm.levels;
+  if (levels < 0){
+    levels = 0;
+    while (levels < 4 && std::min(region.width, region.height) >> (levels+1) >= kMinCoarseSide) ++levels;
+  }
+  refCenter_ = cv::Point2f(region.x + (region.width-1)*0.5f, region.y + (region.height-1)*0.5f);
+
+  // pad so rotated templates never sample outside the patch
+  const double diag = std::hypot(region.width, region.height);
+  const int pad = (int)std::ceil(0.5*(diag - std::min(region.width, region.height))) + (2 << levels);
+  const cv::Rect padded(region.x - pad, region.y - pad, region.width + 2*pad, region.height + 2*pad);
+  const cv::Rect inside = padded & cv::Rect(0, 0, ref.cols, ref.rows);
+  cv::Mat P;
+  cv::copyMakeBorder(ref(inside), P, inside.y - padded.y, padded.br().y - inside.br().y,
+                     inside.x - padded.x, padded.br().x - inside.br().x, cv::BORDER_REPLICATE);
+  cv::buildPyramid(P, patch_, levels);
+  for (int l=0; l<=levels; ++l){
+    const float s = float(1 << l);
+    patchCenter_.emplace_back((refCenter_.x - padded.x)/s, (refCenter_.y - padded.y)/s);
+    size_.emplace_back(std::max(1, (int)std::lround(region.width/s)), std::max(1, (int)std::lround(region.height/s)));
+  }
+
+  // coarse angle step: about one pixel of arc at the template's far corner
+  const cv::Size cs = size_.back();
+  coarseStep_ = 2.0*std::atan(1.0/std::max(cs.width, cs.height)) * kRadToDeg;
+  const int n = prm.angleRangeDeg > 0? (int)std::ceil(prm.angleRangeDeg / coarseStep_) : 0;
+  for (int i=-n; i<=n; ++i){
+    coarseAngles_.push_back(i*coarseStep_);
+    coarse_.push_back(templ(levels, i*coarseStep_, &coarseCenter_));
+  }
+  return true;
+}
+
+cv::Mat ShapeLocator::templ(int level, double angleDeg, cv::Point2f* center) const{
+  const cv::Point2f q = patchCenter_[level];
+  const cv::Size sz = size_[level];
+  const cv::Point tl((int)std::lround(q.x - (sz.width-1)*0.5), (int)std::lround(q.y - (sz.height-1)*0.5));
+  if (center) *center = q - cv::Point2f((float)tl.x, (float)tl.y);
+  const cv::Rect crop(tl, sz);
+  if (angleDeg == 0.0) return patch_[level](crop);
+  cv::Mat M = cv::getRotationMatrix2D(q, angleDeg, 1.0);
+  // shift so the crop lands at the origin: only the template area is resampled
+  M.at<double>(0,2) -= tl.x; M.at<double>(1,2) -= tl.y;
+  cv::Mat out; cv::warpAffine(patch_[level], out, M, sz, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  return out;
+}
+
+Pose ShapeLocator::locate(const cv::Mat& imgIn) const{
+  Pose pose;
+  if (!trained()) return pose;
+  const int L = (int)patch_.size() - 1;
+  std::vector<cv::Mat> pyr; cv::buildPyramid(toGray(imgIn), pyr, L);
+  if (pyr[L].cols < size_[L].width || pyr[L].rows < size_[L].height) return pose;
+  if (needsFloat(pyr[L], coarse_[0])){ cv::Mat f; pyr[L].convertTo(f, CV_32F); pyr[L] = f; }   // once, not per angle
+
+  // coarsest level: every angle over the whole image
+  double best = -2; cv::Point bestLoc; size_t bestA = 0;
+  cv::Mat res;
+  for (size_t a=0; a<coarse_.size(); ++a){
+    match(pyr[L], coarse_[a], res);
+    double mx; cv::Point loc; cv::minMaxLoc(res, nullptr, &mx, nullptr, &loc);
+    if (mx > best){ best = mx; bestLoc = loc; bestA = a; }
+  }
+  cv::Point2f center = cv::Point2f((float)bestLoc.x, (float)bestLoc.y) + coarseCenter_;
+  double angle = coarseAngles_[bestA], step = coarseStep_;
+  pose.score = best;
+
+  // finer levels: small window around the prediction, neighbouring angles
+  for (int l=L-1; l>=0; --l){
+    center *= 2.f;
+    step *= 0.5;
+    const bool rotating = prm_.angleRangeDeg > 0;
+    double scores[3] = {-2, -2, -2}; cv::Mat maps[3]; cv::Point2f tc[3];
+    int ba = 1; double bs = -2; cv::Point bl; cv::Rect win;
+    for (int k=0; k<3; ++k){
+      if (!rotating && k != 1) continue;
+      cv::Mat t = templ(l, angle + (k-1)*step, &tc[k]);
+      const cv::Point tl((int)std::lround(center.x - tc[k].x) - kSearchRadius, (int)std::lround(center.y - tc[k].y) - kSearchRadius);
+      cv::Rect w = cv::Rect(tl, cv::Size(t.cols + 2*kSearchRadius, t.rows + 2*kSearchRadius)) & cv::Rect(0, 0, pyr[l].cols, pyr[l].rows);
+      if (w.width < t.cols || w.height < t.rows) continue;
+      match(pyr[l](w), t, maps[k]);
+      double mx; cv::Point loc; cv::minMaxLoc(maps[k], nullptr, &mx, nullptr, &loc);
+      scores[k] = mx;
+      if (mx > bs){ bs = mx; ba = k; bl = loc; win = w; }
+    }
+    if (bs < -1) return pose;   // ran off the image
+    cv::Point2f sub(0.f, 0.f);
+    if (l == 0){
+      const cv::Mat& m = maps[ba];
+      if (bl.x > 0 && bl.x < m.cols-1) sub.x = (float)peak(m.at<float>(bl.y, bl.x-1), m.at<float>(bl.y, bl.x), m.at<float>(bl.y, bl.x+1));
+      if (bl.y > 0 && bl.y < m.rows-1) sub.y = (float)peak(m.at<float>(bl.y-1, bl.x), m.at<float>(bl.y, bl.x), m.at<float>(bl.y+1, bl.x));
+    }
+    center = cv::Point2f((float)(win.x + bl.x), (float)(win.y + bl.y)) + sub + tc[ba];
+    double da = 0;
+    if (l == 0 && rotating && ba == 1 && scores[0] > -2 && scores[2] > -2) da = peak(scores[0], scores[1], scores[2]);
+    angle += (ba - 1 + da)*step;
+    pose.score = bs;
+  }
+  pose.center = center;
+  pose.angleDeg = angle;
+  pose.found = pose.score >= prm_.minScore;
+  return pose;
+}
+
+cv::Matx23d ShapeLocator::transform(const Pose& pose) const{
+  const double a = pose.angleDeg / kRadToDeg, c = std::cos(a), s = std::sin(a);
+  // getRotationMatrix2D's linear part: [c s; -s c]
+  return cv::Matx23d(c, s, pose.center.x - (c*refCenter_.x + s*refCenter_.y),
+                     -s, c, pose.center.y - (-s*refCenter_.x + c*refCenter_.y));
+}
+}
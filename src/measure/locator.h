@@ -0,0 +1,39 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+namespace mp {
+struct LocatorParams {
+  double angleRangeDeg = 15.0;  // search +-range; 0 = translation only
+  int levels = -1;              // pyramid levels; -1 = auto (coarse template >= 24 px)
+  double minScore = 0.6;        // NCC needed to accept a pose
+};
+// Part pose in the current image: where the trained region's centre landed
+// and how far it turned (degrees, cv::getRotationMatrix2D convention).
+struct Pose { cv::Point2f center; double angleDeg = 0.0; double score = 0.0; bool found = false; };
+
+// NCC part locator. train() keeps the reference region and its pyramid;
+// locate() scans the coarsest level over all angles, then re-searches a
+// few pixels and neighbouring angles per finer level, with sub-pixel and
+// sub-step peak interpolation at full resolution.
+class ShapeLocator {
+public:
+  bool train(const cv::Mat& ref, const cv::Rect& region, const LocatorParams& prm = {});
+  bool trained() const { return !coarse_.empty(); }
+  Pose locate(const cv::Mat& img) const;
+  cv::Point2f refCenter() const { return refCenter_; }
+  // Affine map from reference-image to current-image coordinates.
+  cv::Matx23d transform(const Pose& pose) const;
+
+private:
+  cv::Mat templ(int level, double angleDeg, cv::Point2f* center = nullptr) const;
+  LocatorParams prm_;
+  cv::Point2f refCenter_;
+  std::vector<cv::Mat> patch_;           // padded reference patch per level
+  std::vector<cv::Point2f> patchCenter_; // region centre inside patch_[l]
+  std::vector<cv::Size> size_;           // template size per level
+  std::vector<double> coarseAngles_;
+  std::vector<cv::Mat> coarse_;          // pre-rotated coarsest templates
+  cv::Point2f coarseCenter_;             // region centre inside a coarse template
+  double coarseStep_ = 0.0;
+};
+}
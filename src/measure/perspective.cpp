@@ -1,12 +1,167 @@
 #include "measure/perspective.h"
 #include <opencv2/imgproc.hpp>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <mutex>
 namespace mp {
+namespace {
+// On-disk table: header, then map1 (CV_16SC2) and map2 (CV_16UC1) rows, packed.
+struct RemapHeader {
+  char magic[8];
+  int32_t width, height;
+  double H[9];
+  char pad[128 - 8 - 8 - 9*8];
+};
+static_assert(sizeof(RemapHeader)==128, "remap header must stay 128 bytes");
+constexpr char kMagic[8] = {'M','P','R','E','M','A','P','1'};
+constexpr int kStripeRows = 32;
+constexpr size_t kMaxCached = 8;
+
+std::mutex g_mtx;
+std::string g_cacheDir;
+std::list<std::shared_ptr<const PerspectiveRemap>> g_cache;  // most recently used first
+
+cv::Matx33d toMatx(const cv::Mat& H){
+  CV_Assert(H.rows==3 && H.cols==3 && H.channels()==1);
+  cv::Mat d; H.convertTo(d, CV_64F);
+  cv::Matx33d m;
+  for (int i=0;i<3;++i) for (int j=0;j<3;++j) m(i,j) = d.at<double>(i,j);
+  return m;
+}
+std::string cacheName(const cv::Matx33d& H, cv::Size s){
+  // FNV-1a over the matrix bits and output size
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&](const void* p, size_t n){
+    auto b = static_cast<const unsigned char*>(p);
+    for (size_t i=0;i<n;++i){ h ^= b[i]; h *= 1099511628211ull; }
+  };
+  mix(H.val, sizeof(H.val)); mix(&s.width, sizeof(s.width)); mix(&s.height, sizeof(s.height));
+  char buf[32]; std::snprintf(buf, sizeof buf, "%016llx.remap", (unsigned long long)h);
+  return buf;
+}
+bool sameTable(const PerspectiveRemap& r, const cv::Matx33d& H, cv::Size s){
+  return r.size()==s && std::memcmp(r.H().val, H.val, sizeof(H.val))==0;
+}
+}
+
 cv::Mat estimateH(const std::array<cv::Point2f,4>& src, const std::array<cv::Point2f,4>& dst){
   std::vector<cv::Point2f> s(src.begin(), src.end()), d(dst.begin(), dst.end());
   return cv::getPerspectiveTransform(s,d);
 }
 cv::Mat warpWithH(const cv::Mat& img, const cv::Mat& H, cv::Size outSize){
-  cv::Mat out; cv::warpPerspective(img, out, H, outSize, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  return PerspectiveRemap::cached(H, outSize)->warp(img);
+}
+
+PerspectiveRemap::PerspectiveRemap(const cv::Mat& H, cv::Size outSize): H_(toMatx(H)), size_(outSize){
+  CV_Assert(outSize.width>0 && outSize.height>0);
+  const cv::Matx33d Hi = H_.inv();
+  map1_.create(outSize, CV_16SC2); map2_.create(outSize, CV_16UC1);
+  // Float maps are only ever a stripe at a time; each stripe is converted
+  // straight into its rows of the fixed-point tables.
+  const int stripes = (outSize.height + kStripeRows-1) / kStripeRows;
+  cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& r){
+    cv::Mat mx(kStripeRows, outSize.width, CV_32FC1), my(kStripeRows, outSize.width, CV_32FC1);
+    for (int s=r.start; s<r.end; ++s){
+      const int y0 = s*kStripeRows, y1 = std::min(outSize.height, y0+kStripeRows);
+      for (int y=y0; y<y1; ++y){
+        float* px = mx.ptr<float>(y-y0); float* py = my.ptr<float>(y-y0);
+        const double X = Hi(0,1)*y + Hi(0,2), Y = Hi(1,1)*y + Hi(1,2), W = Hi(2,1)*y + Hi(2,2);
+        for (int x=0; x<outSize.width; ++x){
+          double w = W + Hi(2,0)*x; w = w!=0? 1.0/w : 0.0;
+          px[x] = float((X + Hi(0,0)*x)*w); py[x] = float((Y + Hi(1,0)*x)*w);
+        }
+      }
+      cv::Mat m1 = map1_.rowRange(y0,y1), m2 = map2_.rowRange(y0,y1);
+      cv::convertMaps(mx.rowRange(0,y1-y0), my.rowRange(0,y1-y0), m1, m2, CV_16SC2);
+    }
+  });
+}
+
+PerspectiveRemap::~PerspectiveRemap() = default;
+
+cv::Mat PerspectiveRemap::warp(const cv::Mat& img) const{
+  cv::Mat out; cv::remap(img, out, map1_, map2_, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
   return out;
 }
+
+cv::Mat PerspectiveRemap::warpRoi(const cv::Mat& img, const cv::Rect& outRoi) const{
+  cv::Rect r = outRoi & cv::Rect(0,0,size_.width,size_.height);
+  cv::Mat out; if (r.empty()) return out;
+  cv::remap(img, out, map1_(r), map2_(r), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  return out;
+}
+
+bool PerspectiveRemap::save(const std::string& path) const{
+  QSaveFile f(QString::fromStdString(path));
+  if (!f.open(QIODevice::WriteOnly)) return false;
+  RemapHeader h{};
+  std::memcpy(h.magic, kMagic, sizeof kMagic);
+  h.width = size_.width; h.height = size_.height;
+  std::memcpy(h.H, H_.val, sizeof h.H);
+  bool ok = f.write(reinterpret_cast<const char*>(&h), sizeof h) == (qint64)sizeof h;
+  for (int y=0; ok && y<size_.height; ++y) ok = f.write(map1_.ptr<char>(y), (qint64)size_.width*4) == (qint64)size_.width*4;
+  for (int y=0; ok && y<size_.height; ++y) ok = f.write(map2_.ptr<char>(y), (qint64)size_.width*2) == (qint64)size_.width*2;
+  if (!ok){ f.cancelWriting(); return false; }
+  return f.commit();
+}
+
+std::shared_ptr<const PerspectiveRemap> PerspectiveRemap::load(const std::string& path){
+  auto f = std::make_unique<QFile>(QString::fromStdString(path));
+  if (!f->open(QIODevice::ReadOnly) || f->size() < (qint64)sizeof(RemapHeader)) return nullptr;
+  RemapHeader h;
+  if (f->read(reinterpret_cast<char*>(&h), sizeof h) != (qint64)sizeof h) return nullptr;
+  if (std::memcmp(h.magic, kMagic, sizeof kMagic)!=0 || h.width<=0 || h.height<=0) return nullptr;
+  const size_t px = size_t(h.width)*h.height;
+  if (f->size() != qint64(sizeof h + px*6)) return nullptr;
+  uchar* p = f->map(0, f->size());
+  if (!p) return nullptr;
+  std::shared_ptr<PerspectiveRemap> r(new PerspectiveRemap());
+  std::memcpy(r->H_.val, h.H, sizeof h.H);
+  r->size_ = cv::Size(h.width, h.height);
+  r->map1_ = cv::Mat(r->size_, CV_16SC2, p + sizeof h);
+  r->map2_ = cv::Mat(r->size_, CV_16UC1, p + sizeof h + px*4);
+  r->file_ = std::move(f);
+  return r;
+}
+
+std::shared_ptr<const PerspectiveRemap> PerspectiveRemap::cached(const cv::Mat& Hm, cv::Size outSize){
+  const cv::Matx33d H = toMatx(Hm);
+  std::string dir;
+  {
+    std::lock_guard<std::mutex> lk(g_mtx);
+    for (auto it=g_cache.begin(); it!=g_cache.end(); ++it){
+      if (!sameTable(**it, H, outSize)) continue;
+      auto hit = *it; g_cache.erase(it); g_cache.push_front(hit);
+      return hit;
+    }
+    dir = g_cacheDir;
+  }
+  // Build (or map) outside the lock; a racing duplicate is harmless.
+  std::shared_ptr<const PerspectiveRemap> r;
+  const std::string path = dir.empty()? std::string() : dir + "/" + cacheName(H, outSize);
+  if (!path.empty()){
+    r = load(path);
+    if (r && !sameTable(*r, H, outSize)) r.reset();
+  }
+  if (!r){
+    auto fresh = std::make_shared<PerspectiveRemap>(cv::Mat(H), outSize);
+    if (!path.empty()) fresh->save(path);
+    r = fresh;
+  }
+  std::lock_guard<std::mutex> lk(g_mtx);
+  g_cache.push_front(r);
+  if (g_cache.size() > kMaxCached) g_cache.pop_back();
+  return r;
+}
+
+void PerspectiveRemap::setCacheDir(const std::string& dir){
+  if (!dir.empty()) QDir().mkpath(QString::fromStdString(dir));
+  std::lock_guard<std::mutex> lk(g_mtx);
+  g_cacheDir = dir;
+}
 }
@@ -1,7 +1,40 @@
 #pragma once
 #include <opencv2/core.hpp>
 #include <array>
+#include <memory>
+#include <string>
+class QFile;
 namespace mp {
 cv::Mat estimateH(const std::array<cv::Point2f,4>& src, const std::array<cv::Point2f,4>& dst);
 cv::Mat warpWithH(const cv::Mat& img, const cv::Mat& H, cv::Size outSize);
+
+// Fixed-point remap tables (CV_16SC2 + CV_16UC1) for one homography and
+// output size, built once so per-frame rectification is a table lookup.
+// warpRoi() looks up only an output sub-rectangle.
+class PerspectiveRemap {
+public:
+  PerspectiveRemap(const cv::Mat& H, cv::Size outSize);
+  ~PerspectiveRemap();
+
+  cv::Mat warp(const cv::Mat& img) const;
+  cv::Mat warpRoi(const cv::Mat& img, const cv::Rect& outRoi) const;
+  cv::Size size() const { return size_; }
+  const cv::Matx33d& H() const { return H_; }
+
+  // Raw table file; load() memory-maps it instead of reading it.
+  bool save(const std::string& path) const;
+  static std::shared_ptr<const PerspectiveRemap> load(const std::string& path);
+
+  // Process-wide cache keyed by (H, outSize). With a cache dir set, tables
+  // are also persisted there and mapped straight from disk on startup.
+  static std::shared_ptr<const PerspectiveRemap> cached(const cv::Mat& H, cv::Size outSize);
+  static void setCacheDir(const std::string& dir);
+
+private:
+  PerspectiveRemap() = default;
+  cv::Matx33d H_;
+  cv::Size size_;
+  cv::Mat map1_, map2_;
+  std::unique_ptr<QFile> file_;  // keeps a mapped table alive
+};
 }
@@ -0,0 +1,170 @@
+#include "measure/polar_ring.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <mutex>
+#include "core/gray_levels.h"
+namespace mp {
+namespace {
+constexpr size_t kMaxCached = 8;
+std::mutex g_mtx;
+std::list<std::shared_ptr<const PolarUnwrap>> g_cache;   // most recently used first
+
+// Per column, the largest rising and falling central difference over the
+// strip's rows 2..n-3 (so the parabola has both neighbours) and its row.
+// Starting at 0, a column without a step of that sign keeps row -1.
+void radialSteps(const cv::Mat& s, std::vector<float>& hi, std::vector<float>& hiAt,
+                 std::vector<float>& lo, std::vector<float>& loAt){
+  const int W = s.cols, n = s.rows;
+  hi.assign(W, 0.f); lo.assign(W, 0.f); hiAt.assign(W, -1.f); loAt.assign(W, -1.f);
+  for (int j=2; j<n-2; ++j){
+    const float* a = s.ptr<float>(j-1);
+    const float* b = s.ptr<float>(j+1);
+    int x = 0;
+#if CV_SIMD
+    const int VL = cv::v_float32::nlanes;
+    const cv::v_float32 vj = cv::vx_setall_f32((float)j);
+    for (; x <= W-VL; x += VL){
+      const cv::v_float32 d = cv::vx_load(b+x) - cv::vx_load(a+x);
+      const cv::v_float32 h = cv::vx_load(&hi[x]), l = cv::vx_load(&lo[x]);
+      const cv::v_float32 up = d > h, down = d < l;
+      cv::v_store(&hi[x], cv::v_select(up, d, h));
+      cv::v_store(&hiAt[x], cv::v_select(up, vj, cv::vx_load(&hiAt[x])));
+      cv::v_store(&lo[x], cv::v_select(down, d, l));
+      cv::v_store(&loAt[x], cv::v_select(down, vj, cv::vx_load(&loAt[x])));
+    }
+#endif
+    for (; x < W; ++x){
+      const float d = b[x] - a[x];
+      if (d > hi[x]){ hi[x] = d; hiAt[x] = (float)j; }
+      if (d < lo[x]){ lo[x] = d; loAt[x] = (float)j; }
+    }
+  }
+}
+
+// Sub-pixel radius of the step at row j of column x, or NaN below `thr`
+float refine(const cv::Mat& s, const PolarUnwrap& u, int x, float row, float peak, float thr){
+  if (row < 0 || std::abs(peak) < thr) return std::numeric_limits<float>::quiet_NaN();
+  const int j = (int)row;
+  auto d = [&](int k){ return s.at<float>(k+1, x) - s.at<float>(k-1, x); };
+  const float dm = d(j-1), d0 = d(j), dp = d(j+1), den = dm - 2*d0 + dp;
+  const float off = den != 0.f ? std::clamp(0.5f*(dm - dp)/den, -0.5f, 0.5f) : 0.f;
+  return u.radius(j + off);
+}
+
+float median(std::vector<float>& v){
+  std::nth_element(v.begin(), v.begin() + v.size()/2, v.end());
+  return v[v.size()/2];
+}
+
+// Drops radii off the median of their angular neighbourhood, then the whole
+// set if under a quarter of the rays keep an edge. Returns the median radius,
+// -1 for an empty set.
+float cleanProfile(std::vector<float>& r, float maxJump){
+  const int W = (int)r.size(), k = 3;
+  const std::vector<float> in = r;
+  std::vector<float> win, all;
+  for (int i=0; i<W; ++i){
+    if (std::isnan(in[i])) continue;
+    win.clear();
+    for (int o=-k; o<=k; ++o){ const float v = in[(i + o + W) % W]; if (!std::isnan(v)) win.push_back(v); }
+    if (win.size() < 3 || std::abs(in[i] - median(win)) > maxJump) r[i] = std::numeric_limits<float>::quiet_NaN();
+    else all.push_back(r[i]);
+  }
+  if ((int)all.size() * 4 < W){ std::fill(r.begin(), r.end(), std::numeric_limits<float>::quiet_NaN()); return -1.f; }
+  return median(all);
+}
+}
+
+PolarUnwrap::PolarUnwrap(float rInner, float rOuter, int angles, float step)
+  : rInner_(rInner), rOuter_(rOuter), step_(step), angles_(angles), half_((int)std::ceil(rOuter) + 2){
+  CV_Assert(rInner >= 0 && rOuter > rInner && angles >= 8 && step > 0);
+  const int n = (int)std::floor((rOuter - rInner)/step) + 1;
+  cv::Mat mx(n, angles, CV_32F), my(n, angles, CV_32F);
+  for (int i=0; i<angles; ++i){
+    const double t = 2*CV_PI*i/angles, c = std::cos(t), s = std::sin(t);
+    for (int j=0; j<n; ++j){
+      const double r = rInner + j*step;
+      mx.at<float>(j, i) = float(half_ + r*c);
+      my.at<float>(j, i) = float(half_ + r*s);
+    }
+  }
+  cv::convertMaps(mx, my, map1_, map2_, CV_16SC2);
+}
+
+void PolarUnwrap::unwrap(const cv::Mat& gray, cv::Point c, cv::Mat& strip) const{
+  CV_Assert(gray.channels() == 1);
+  const cv::Rect box(c.x - half_, c.y - half_, 2*half_ + 1, 2*half_ + 1);
+  const cv::Rect in = box & cv::Rect(cv::Point(), gray.size());
+  if (in.empty()){ strip = cv::Mat::zeros(rows(), angles_, gray.type()); return; }
+  cv::Mat src;
+  if (in == box) src = gray(box);
+  else cv::copyMakeBorder(gray(in), src, in.y - box.y, box.br().y - in.br().y, in.x - box.x, box.br().x - in.br().x,
+                          cv::BORDER_REPLICATE);
+  cv::remap(src, strip, map1_, map2_, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+}
+
+std::shared_ptr<const PolarUnwrap> PolarUnwrap::cached(float rInner, float rOuter, int angles, float step){
+  std::lock_guard<std::mutex> lk(g_mtx);
+  for (auto it=g_cache.begin(); it!=g_cache.end(); ++it){
+    const PolarUnwrap& u = **it;
+    if (u.rInner_ != rInner || u.rOuter_ != rOuter || u.angles_ != angles || u.step_ != step) continue;
+    auto hit = *it; g_cache.erase(it); g_cache.push_front(hit);
+    return hit;
+  }
+  auto r = std::make_shared<const PolarUnwrap>(rInner, rOuter, angles, step);
+  g_cache.push_front(r);
+  if (g_cache.size() > kMaxCached) g_cache.pop_back();
+  return r;
+}
+
+void RingProfile::points(const std::vector<float>& r, std::vector<cv::Point2f>& pts, cv::Point2f shift) const{
+  const int W = (int)r.size();
+  for (int i=0; i<W; ++i){
+    if (std::isnan(r[i])) continue;
+    const double t = 2*CV_PI*i/W;
+    pts.emplace_back(center.x + shift.x + float(r[i]*std::cos(t)), center.y + shift.y + float(r[i]*std::sin(t)));
+  }
+}
+
+void ringProfile(const cv::Mat& img, cv::Point center, int rInner, int rOuter,
+                 RingProfile& out, const PolarRingParams& prm){
+  CV_Assert(!img.empty() && (img.depth() == CV_8U || img.depth() == CV_16U));
+  out.center = cv::Point2f(center);
+  out.outer.clear(); out.inner.clear();
+  const float step = std::clamp(prm.step, 0.1f, 2.f);
+  if (rOuter - std::max(rInner, 0) < 5*step) return;
+  auto u = PolarUnwrap::cached((float)std::max(rInner, 0), (float)rOuter, std::clamp(prm.angles, 8, 8192), step);
+
+  // only the ring's box is converted to grey
+  cv::Mat gray = img, strip, s;
+  if (img.channels() == 3){
+    const int h = rOuter + 3;
+    const cv::Rect box = cv::Rect(center.x - h, center.y - h, 2*h + 1, 2*h + 1) & cv::Rect(cv::Point(), img.size());
+    if (box.empty()) return;
+    cv::cvtColor(img(box), gray, cv::COLOR_BGR2GRAY);
+    center -= box.tl();
+  }
+  u->unwrap(gray, center, strip);
+  strip.convertTo(s, CV_32F);
+
+  std::vector<float> hi, hiAt, lo, loAt;
+  radialSteps(s, hi, hiAt, lo, loAt);
+  // central differences span 2 samples; the threshold is a slope per px
+  const float thr = float(prm.threshold * 2*step * levelScale(img.depth(), prm.bits));
+  const int W = u->angles();
+  std::vector<float> rise(W), fall(W);
+  for (int x=0; x<W; ++x){
+    rise[x] = refine(s, *u, x, hiAt[x], hi[x], thr);
+    fall[x] = refine(s, *u, x, loAt[x], lo[x], thr);
+  }
+  const float mRise = cleanProfile(rise, prm.maxJumpPx), mFall = cleanProfile(fall, prm.maxJumpPx);
+  // the set further out is the outer edge; a lone set is always the outer one
+  const bool riseOuter = mRise > mFall;
+  out.outer = riseOuter ? std::move(rise) : std::move(fall);
+  out.inner = riseOuter ? std::move(fall) : std::move(rise);
+}
+}
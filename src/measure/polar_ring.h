@@ -0,0 +1,53 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
+namespace mp {
+struct PolarRingParams {
+  int angles = 720;          // rays around the ring (strip columns)
+  float step = 0.5f;         // radial sample spacing (px)
+  float threshold = 20.f;    // minimum radial slope, grey levels per px on the 8-bit scale
+  float maxJumpPx = 1.5f;    // radius change against the median of the 3 rays either side
+  int bits = 0;              // significant bits of 16-bit input, 0 = 16 (core/gray_levels.h)
+};
+
+// Fixed-point remap tables (CV_16SC2 + CV_16UC1) that unwrap an annulus into
+// a narrow strip: column i is the ray at angle 2*pi*i/angles, row j the
+// radius rInner + j*step. Tables are relative to the ring centre, so one
+// set serves every position of rings with the same radii.
+class PolarUnwrap {
+public:
+  PolarUnwrap(float rInner, float rOuter, int angles, float step);
+  // Strip of `gray` (one channel) around `center`; pixels outside the image repeat its border.
+  void unwrap(const cv::Mat& gray, cv::Point center, cv::Mat& strip) const;
+  int angles() const { return angles_; }
+  int rows() const { return map1_.rows; }
+  float radius(float row) const { return rInner_ + row*step_; }
+
+  // Process-wide cache keyed by (rInner, rOuter, angles, step).
+  static std::shared_ptr<const PolarUnwrap> cached(float rInner, float rOuter, int angles, float step);
+
+private:
+  float rInner_, rOuter_, step_;
+  int angles_, half_;        // tables address a (2*half_+1)^2 box centred on the ring
+  cv::Mat map1_, map2_;
+};
+
+// Edge radius per ray, NaN where the ray has none. `outer` is the edge set
+// lying further out, `inner` the other polarity (the bore of a ring, when
+// the annulus spans it).
+struct RingProfile {
+  cv::Point2f center;
+  std::vector<float> outer, inner;
+  // Edge points of one radius set, shifted by `shift`.
+  void points(const std::vector<float>& r, std::vector<cv::Point2f>& pts, cv::Point2f shift = {0.f, 0.f}) const;
+};
+
+// Unwraps the annulus [rInner, rOuter] around `center` and finds, per ray,
+// the strongest rising and the strongest falling radial step, refined by a
+// parabola to a fraction of a sample. Radii that jump against their angular
+// neighbours are dropped, as is a polarity found on under a quarter of the
+// rays. 8U and 16U, grey or BGR.
+void ringProfile(const cv::Mat& img, cv::Point center, int rInner, int rOuter,
+                 RingProfile& out, const PolarRingParams& prm = {});
+}
@@ -0,0 +1,156 @@
+#include "measure/pyramid.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "core/gray_levels.h"
+#include "measure/gauges.h"
+namespace mp {
+namespace {
+constexpr float kTileLen = 64.f;   // band length covered by one Canny tile (px)
+constexpr int kCannySupport = 2;   // Sobel + NMS reach beyond the band
+constexpr double kTwoPi = 6.28318530717958647692;
+}
+
+MeasurePyramid::MeasurePyramid(const cv::Mat& img, const PyramidParams& prm): prm_(prm){
+  CV_Assert(!img.empty());
+  cv::Mat gray; if (img.channels()==3) cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY); else gray = img;
+  pyr_.push_back(gray);
+  for (int i=0; i<prm.levels && std::min(pyr_.back().cols, pyr_.back().rows) >= 32; ++i){
+    cv::Mat d; cv::pyrDown(pyr_.back(), d); pyr_.push_back(d);
+  }
+}
+
+float MeasurePyramid::band() const{
+  return prm_.bandPx > 0? prm_.bandPx : 2.f*scale() + 2.f;
+}
+
+std::vector<std::vector<cv::Point2f>> MeasurePyramid::coarseContours(const cv::Mat& mask) const{
+  cv::Mat e; cannyEdges(pyr_.back(), e, prm_.cannyLow, prm_.cannyHigh, 3, true, prm_.bits);
+  if (!mask.empty()){
+    cv::Mat m; cv::resize(mask, m, e.size(), 0, 0, cv::INTER_NEAREST);
+    cv::bitwise_and(e, m, e);
+  }
+  std::vector<std::vector<cv::Point>> cs;
+  cv::findContours(e, cs, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+  std::sort(cs.begin(), cs.end(), [](auto& a, auto& b){ return cv::contourArea(a) > cv::contourArea(b); });
+  // pyrDown centres coarse pixel i on full-res pixel 2i
+  const float s = (float)scale();
+  std::vector<std::vector<cv::Point2f>> out(cs.size());
+  for (size_t i=0;i<cs.size();++i){
+    out[i].reserve(cs[i].size());
+    for (auto& p : cs[i]) out[i].emplace_back(p.x*s, p.y*s);
+  }
+  return out;
+}
+
+int MeasurePyramid::polarity(const std::vector<cv::Point2f>& contour, const Circle& C) const{
+  const cv::Mat& g = pyr_.back();
+  const float s = (float)scale();
+  auto at = [&](int y, int x){ return g.depth()==CV_8U? (double)g.at<uchar>(y, x) : (double)g.at<ushort>(y, x); };
+  double sum = 0;
+  for (auto& p : contour){
+    const int x = cvRound(p.x/s), y = cvRound(p.y/s);
+    if (x < 1 || y < 1 || x >= g.cols-1 || y >= g.rows-1) continue;
+    const double gx = at(y-1, x+1) + 2*at(y, x+1) + at(y+1, x+1) - at(y-1, x-1) - 2*at(y, x-1) - at(y+1, x-1);
+    const double gy = at(y+1, x-1) + 2*at(y+1, x) + at(y+1, x+1) - at(y-1, x-1) - 2*at(y-1, x) - at(y-1, x+1);
+    const double dx = p.x - C.c.x, dy = p.y - C.c.y, n = std::sqrt(dx*dx + dy*dy);
+    if (n > 0) sum += (gx*dx + gy*dy)/n;
+  }
+  return sum > 0? 1 : sum < 0? -1 : 0;
+}
+
+template<class Owns>
+void MeasurePyramid::tileEdges(const cv::Rect& tileIn, Owns owns, std::vector<cv::Point2f>& out, bool gradient) const{
+  const cv::Mat& g = pyr_[0];
+  const cv::Rect tile = tileIn & cv::Rect(0, 0, g.cols, g.rows);
+  if (tile.width < 3 || tile.height < 3) return;
+  cv::Mat e; cannyEdges(g(tile), e, prm_.cannyLow, prm_.cannyHigh, 3, true, prm_.bits);
+  cv::Mat gx, gy;
+  if (gradient){ cv::Sobel(g(tile), gx, CV_32F, 1, 0, 3); cv::Sobel(g(tile), gy, CV_32F, 0, 1, 3); }
+  for (int y=0; y<e.rows; ++y){
+    const uchar* r = e.ptr<uchar>(y);
+    for (int x=0; x<e.cols; ++x){
+      if (!r[x]) continue;
+      cv::Point2f q((float)(x + tile.x), (float)(y + tile.y));
+      const cv::Point2f d = gradient? cv::Point2f(gx.at<float>(y, x), gy.at<float>(y, x)) : cv::Point2f();
+      if (owns(q, d)) out.push_back(q);
+    }
+  }
+}
+
+void MeasurePyramid::bandEdges(const Line2D& L, const cv::Rect& roi, std::vector<cv::Point2f>& out) const{
+  const cv::Rect full(0, 0, pyr_[0].cols, pyr_[0].rows);
+  const cv::Rect box = roi.empty()? full : roi & full;
+  double ux = L.v.x, uy = L.v.y, n = std::sqrt(ux*ux + uy*uy);
+  if (n == 0 || box.empty()) return;
+  ux /= n; uy /= n;
+  // parameterise from the box centre's foot point on L
+  const double bx = box.x + box.width*0.5, by = box.y + box.height*0.5;
+  const double tc = (bx - L.p.x)*ux + (by - L.p.y)*uy;
+  const double cx = L.p.x + tc*ux, cy = L.p.y + tc*uy;
+  double t0 = -1e9, t1 = 1e9;
+  gauge::clipToRect(cx, cy, ux, uy, box.x, box.y, box.x + box.width, box.y + box.height, t0, t1);
+  if (!(t1 > t0)) return;
+
+  const float b = band();
+  const int tiles = std::max(1, (int)std::ceil((t1 - t0) / kTileLen));
+  const double step = (t1 - t0) / tiles;
+  const int pad = (int)std::ceil(b) + kCannySupport;
+  for (int k=0; k<tiles; ++k){
+    const double ta = t0 + k*step, tb = ta + step;
+    const cv::Point pa((int)std::floor(cx + ta*ux), (int)std::floor(cy + ta*uy));
+    const cv::Point pb((int)std::floor(cx + tb*ux), (int)std::floor(cy + tb*uy));
+    cv::Rect tile(cv::Point(std::min(pa.x, pb.x) - pad, std::min(pa.y, pb.y) - pad),
+                  cv::Point(std::max(pa.x, pb.x) + pad + 2, std::max(pa.y, pb.y) + pad + 2));
+    tileEdges(tile, [&](const cv::Point2f& q, const cv::Point2f&){
+      if (!box.contains(cv::Point((int)q.x, (int)q.y))) return false;
+      const double dx = q.x - cx, dy = q.y - cy;
+      if (std::abs(-uy*dx + ux*dy) > b) return false;
+      const int owner = std::clamp((int)std::floor(((dx*ux + dy*uy) - t0) / step), 0, tiles-1);
+      return owner == k;
+    }, out);
+  }
+}
+
+void MeasurePyramid::bandEdges(const Circle& C, std::vector<cv::Point2f>& out, int polarity) const{
+  if (!(C.r > 0)) return;
+  const float b = band();
+  const int sectors = std::max(8, (int)std::ceil(kTwoPi*C.r / kTileLen));
+  const double step = kTwoPi / sectors;
+  // an arc bulges past its end/mid points by at most r(1-cos(step/4))
+  const int pad = (int)std::ceil(b + C.r*(1 - std::cos(step*0.25))) + kCannySupport;
+  for (int k=0; k<sectors; ++k){
+    int xmin = INT_MAX, ymin = INT_MAX, xmax = INT_MIN, ymax = INT_MIN;
+    for (int j=0; j<3; ++j){
+      const double a = (k + 0.5*j)*step;
+      for (double rr : {C.r - b, C.r + b}){
+        const int x = (int)std::floor(C.c.x + rr*std::cos(a)), y = (int)std::floor(C.c.y + rr*std::sin(a));
+        xmin = std::min(xmin, x); ymin = std::min(ymin, y); xmax = std::max(xmax, x); ymax = std::max(ymax, y);
+      }
+    }
+    cv::Rect tile(cv::Point(xmin - pad, ymin - pad), cv::Point(xmax + pad + 2, ymax + pad + 2));
+    tileEdges(tile, [&](const cv::Point2f& q, const cv::Point2f& g){
+      const double dx = q.x - C.c.x, dy = q.y - C.c.y;
+      if (std::abs(std::sqrt(dx*dx + dy*dy) - C.r) > b) return false;
+      if (polarity && (dx*g.x + dy*g.y)*polarity <= 0) return false;
+      double a = std::atan2(dy, dx); if (a < 0) a += kTwoPi;
+      return std::min((int)(a / step), sectors-1) == k;
+    }, out, polarity != 0);
+  }
+}
+
+bool MeasurePyramid::refine(const Line2D& coarse, const cv::Rect& roi, Line2D& out, std::vector<cv::Point2f>* pts) const{
+  std::vector<cv::Point2f> local; auto& v = pts? *pts : local;
+  v.clear(); bandEdges(coarse, roi, v);
+  if (v.size() < 2) return false;
+  out = fitLineLSQ(v); return true;
+}
+
+bool MeasurePyramid::refine(const Circle& coarse, Circle& out, std::vector<cv::Point2f>* pts, int polarity) const{
+  std::vector<cv::Point2f> local; auto& v = pts? *pts : local;
+  v.clear(); bandEdges(coarse, v, polarity);
+  if (v.size() < 3) return false;
+  out = fitCircleKasa(v); return true;
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+#include "measure/geometry.h"
+namespace mp {
+struct PyramidParams {
+  int levels = 2;                 // coarse level is downsampled by 2^levels
+  double cannyLow = 50.0, cannyHigh = 150.0;
+  float bandPx = 0.f;             // refinement half-width in full-res px; 0 = 2*2^levels + 2
+  int bits = 0;                   // significant bits of 16-bit input, 0 = 16; Canny thresholds stay on the 8-bit scale
+};
+
+// Coarse-to-fine measurement. The Gaussian pyramid is built once; contours
+// and first fits come from the coarsest level, and full-resolution Canny
+// runs only on small tiles covering a narrow band around each coarse line
+// or circle. Every edge pixel is owned by exactly one tile.
+class MeasurePyramid {
+public:
+  explicit MeasurePyramid(const cv::Mat& img, const PyramidParams& prm = {});
+  int levels() const { return (int)pyr_.size() - 1; }
+  int scale() const { return 1 << levels(); }
+  float band() const;
+  const cv::Mat& level(int i) const { return pyr_[i]; }
+
+  // External contours of the coarse edge map, largest first, in full-res
+  // coordinates; `mask` (full-res, optional) limits them to an ROI.
+  std::vector<std::vector<cv::Point2f>> coarseContours(const cv::Mat& mask = cv::Mat()) const;
+
+  // Radial edge polarity of a coarse contour around C: +1 brighter outward,
+  // -1 darker outward, 0 undecided. A band around a stroke holds both of its
+  // sides; this tells bandEdges which one the contour was traced on.
+  int polarity(const std::vector<cv::Point2f>& contour, const Circle& C) const;
+
+  // Full-res edge pixels within band() of a coarse primitive. Lines are
+  // limited to `roi` (empty = whole image). Circles keep only pixels whose
+  // radial gradient has sign `polarity` (0 = keep all).
+  void bandEdges(const Line2D& L, const cv::Rect& roi, std::vector<cv::Point2f>& out) const;
+  void bandEdges(const Circle& C, std::vector<cv::Point2f>& out, int polarity = 0) const;
+  bool refine(const Line2D& coarse, const cv::Rect& roi, Line2D& out, std::vector<cv::Point2f>* pts = nullptr) const;
+  bool refine(const Circle& coarse, Circle& out, std::vector<cv::Point2f>* pts = nullptr, int polarity = 0) const;
+
+private:
+  // Canny on one tile; owns(q, g) gets the pixel and its Sobel gradient
+  // (zero unless `gradient`).
+  template<class Owns> void tileEdges(const cv::Rect& tile, Owns owns, std::vector<cv::Point2f>& out, bool gradient = false) const;
+  std::vector<cv::Mat> pyr_;   // gray, [0] = full resolution
+  PyramidParams prm_;
+};
+}
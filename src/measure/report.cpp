@@ -1,13 +1,114 @@
 #include "measure/report.h"
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 namespace mp {
-std::string toJson(const std::vector<Item>& items){
-  std::ostringstream os; os << "{\"results\":[";
-  for (size_t i=0;i<items.size();++i){
-    const auto& it=items[i];
-    os << "{\"name\":\"" << it.name << "\",\"value\":" << it.value << ",\"unit\":\"" << it.unit << "\"}";
-    if (i+1<items.size()) os << ",";
+void appendNumber(std::string& out, double v){
+  char buf[32];
+  auto r = std::to_chars(buf, buf+sizeof buf, v);
+  out.append(buf, r.ptr);
+}
+
+void appendJsonString(std::string& out, const std::string& s){
+  static const char hex[] = "0123456789abcdef";
+  out += '"';
+  for (unsigned char c : s){
+    switch (c){
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      default:
+        if (c < 0x20){ char u[6] = {'\\','u','0','0',hex[c>>4],hex[c&15]}; out.append(u, 6); }
+        else out += char(c);
+    }
+  }
+  out += '"';
+}
+
+void appendCsvField(std::string& out, const std::string& s){
+  if (s.find_first_of(",\"\r\n") == std::string::npos){ out += s; return; }
+  out += '"';
+  for (char c : s){ if (c=='"') out += '"'; out += c; }
+  out += '"';
+}
+
+namespace {
+class JsonWriter : public IReportWriter {
+public:
+  explicit JsonWriter(const char* root): root_(root) {}
+  void begin(std::string& out) override { out += "{\""; out += root_; out += "\":["; first_ = true; }
+  void item(std::string& out, const Item& it) override {
+    if (!first_) out += ','; first_ = false;
+    out += "{\"name\":"; appendJsonString(out, it.name);
+    out += ",\"value\":"; if (std::isfinite(it.value)) appendNumber(out, it.value); else out += "null";
+    out += ",\"unit\":"; appendJsonString(out, it.unit);
+    out += it.ok? ",\"ok\":true" : ",\"ok\":false";
+    if (!it.note.empty()){ out += ",\"note\":"; appendJsonString(out, it.note); }
+    out += '}';
+  }
+  void end(std::string& out) override { out += "]}"; }
+private:
+  std::string root_;
+  bool first_ = true;
+};
+
+class CsvWriter : public IReportWriter {
+public:
+  void begin(std::string& out) override { if (out.empty()) out += kReportCsvHeader; }
+  void item(std::string& out, const Item& it) override {
+    appendCsvField(out, it.name); out += ',';
+    appendNumber(out, it.value); out += ',';
+    appendCsvField(out, it.unit); out += it.ok? ",1," : ",0,";
+    appendCsvField(out, it.note); out += '\n';
+  }
+  void end(std::string&) override {}
+};
+
+class BinaryWriter : public IReportWriter {
+public:
+  void begin(std::string&) override {}
+  void item(std::string& out, const Item& it) override {
+    ReportRecord r{};
+    copyField(r.name, sizeof r.name, it.name);
+    copyField(r.unit, sizeof r.unit, it.unit);
+    copyField(r.note, sizeof r.note, it.note);
+    r.value = it.value; r.ok = it.ok? 1 : 0;
+    out.append(reinterpret_cast<const char*>(&r), sizeof r);
   }
-  os << "]}"; return os.str();
+  void end(std::string&) override {}
+private:
+  // Cuts at a code-point boundary, so a truncated field is still valid UTF-8.
+  static void copyField(char* dst, size_t cap, const std::string& s){
+    size_t n = std::min(cap, s.size());
+    if (n < s.size()) while (n > 0 && (static_cast<unsigned char>(s[n]) & 0xC0) == 0x80) --n;
+    std::memcpy(dst, s.data(), n);
+  }
+};
+}
+
+std::unique_ptr<IReportWriter> makeReportWriter(ReportFormat f, const char* jsonRoot){
+  switch (f){
+    case ReportFormat::Csv: return std::make_unique<CsvWriter>();
+    case ReportFormat::Binary: return std::make_unique<BinaryWriter>();
+    default: return std::make_unique<JsonWriter>(jsonRoot);
+  }
+}
+
+void writeReport(IReportWriter& w, const std::vector<Item>& items, std::string& out){
+  out.clear();
+  w.begin(out);
+  for (const auto& it : items) w.item(out, it);
+  w.end(out);
+}
+
+std::string toJson(const std::vector<Item>& items){
+  std::string s; JsonWriter w("results");
+  writeReport(w, items, s);
+  return s;
 }
 }
@@ -1,7 +1,49 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 namespace mp {
-struct Item{ std::string name; double value; std::string unit; };
+struct Item{ std::string name; double value; std::string unit; bool ok = true; std::string note; };
+struct SpecLimits { double lsl, usl; };  // per Item; NaN where a side has no limit
 std::string toJson(const std::vector<Item>& items);
+
+// Streaming report back-ends. Records are appended to a caller-owned buffer,
+// so a buffer reused across parts stops allocating once it has grown. All
+// back-ends share the Item schema: name, value, unit, ok, note.
+enum class ReportFormat { Json, Csv, Binary };
+class IReportWriter {
+public: virtual ~IReportWriter() = default;
+  virtual void begin(std::string& out) = 0;
+  virtual void item(std::string& out, const Item& it) = 0;
+  virtual void end(std::string& out) = 0;
+};
+// Json: {"<root>":[{"name":..,"value":..,"unit":..,"ok":..,"note":..},...]}, non-finite values as null.
+// Csv: one row per item, fields quoted only when needed; begin() on an empty
+//   buffer writes kReportCsvHeader, so appending parts to a log repeats no header.
+// Binary: one ReportRecord per item, strings truncated to their fields.
+std::unique_ptr<IReportWriter> makeReportWriter(ReportFormat f, const char* jsonRoot = "results");
+// Clears `out`, then writes begin / items / end.
+void writeReport(IReportWriter& w, const std::vector<Item>& items, std::string& out);
+
+constexpr const char* kReportCsvHeader = "name,value,unit,ok,note\n";
+#pragma pack(push, 1)
+// Layout 2 (96 bytes; layout 1 was 64 with a 24-byte name): the name holds
+// multi-ROI items "<roi>.<item>" with ROI names of up to kReportRoiNameMax bytes.
+struct ReportRecord {           // little-endian, NUL-padded UTF-8 strings cut at a code point
+  char name[56];
+  char unit[8];
+  char note[16];
+  double value;
+  uint8_t ok;
+  uint8_t reserved[7];
+};
+#pragma pack(pop)
+static_assert(sizeof(ReportRecord) == 96, "ReportRecord is a fixed 96-byte record");
+constexpr size_t kReportRoiNameMax = 32;   // + '.' + the longest item name fits ReportRecord::name
+
+// Formatting primitives shared by the back-ends (shortest round-trip doubles).
+void appendNumber(std::string& out, double v);
+void appendJsonString(std::string& out, const std::string& s);
+void appendCsvField(std::string& out, const std::string& s);
 }
@@ -0,0 +1,126 @@
+#include "measure/subpixel.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include "core/gray_levels.h"
+namespace mp {
+namespace {
+struct EdgePt { float x, y, gx, gy, mod; int next = -1, prev = -1; };
+inline float dist2(const EdgePt& a, const EdgePt& b){ float dx=a.x-b.x, dy=a.y-b.y; return dx*dx + dy*dy; }
+}
+
+void subpixelEdges(const cv::Mat& grayIn, std::vector<EdgeChain>& chains, const SubpixelEdgeParams& prm, const cv::Mat& mask){
+  chains.clear();
+  CV_Assert(!grayIn.empty());
+  CV_Assert(mask.empty() || (mask.type()==CV_8UC1 && mask.size()==grayIn.size()));
+  cv::Mat gray; if (grayIn.channels()==3) cv::cvtColor(grayIn, gray, cv::COLOR_BGR2GRAY); else gray = grayIn;
+  cv::Mat f; gray.convertTo(f, CV_32F);
+  if (prm.sigma > 0) cv::GaussianBlur(f, f, cv::Size(), prm.sigma);
+  // central differences
+  cv::Mat gx, gy, mod;
+  cv::Sobel(f, gx, CV_32F, 1, 0, 1, 0.5); cv::Sobel(f, gy, CV_32F, 0, 1, 1, 0.5);
+  cv::magnitude(gx, gy, mod);
+  const int W = f.cols, H = f.rows;
+  const float k = (float)levelScale(gray.depth(), prm.bits), low = prm.low*k, high = prm.high*k;
+
+  // 1) non-maximum suppression along the dominant axis, parabolic offset
+  std::vector<int> at(size_t(W)*H, -1);
+  std::vector<EdgePt> pts;
+  for (int y=1; y<H-1; ++y){
+    const float *m0 = mod.ptr<float>(y-1), *m1 = mod.ptr<float>(y), *m2 = mod.ptr<float>(y+1);
+    const float *px = gx.ptr<float>(y), *py = gy.ptr<float>(y);
+    const uchar* mk = mask.empty()? nullptr : mask.ptr<uchar>(y);
+    for (int x=1; x<W-1; ++x){
+      const float c = m1[x];
+      if (c < low || (mk && !mk[x])) continue;
+      const bool horiz = std::abs(px[x]) > std::abs(py[x]);
+      const float a = horiz? m1[x-1] : m0[x], b = horiz? m1[x+1] : m2[x];
+      if (!(c > a && c >= b)) continue;
+      const float d = a - 2*c + b, off = d < 0? 0.5f*(a - b)/d : 0.f;
+      EdgePt e; e.x = x + (horiz? off : 0.f); e.y = y + (horiz? 0.f : off);
+      e.gx = px[x]; e.gy = py[x]; e.mod = c;
+      at[size_t(y)*W + x] = (int)pts.size(); pts.push_back(e);
+    }
+  }
+
+  // 2) link each point to the nearest compatible neighbour ahead of and
+  //    behind it along the edge direction (gradient turned by 90 deg);
+  //    a closer claim on a neighbour replaces an older link
+  for (int i=0; i<(int)pts.size(); ++i){
+    const EdgePt& e = pts[i];
+    const int cx = (int)std::lround(e.x), cy = (int)std::lround(e.y);
+    int fwd = -1, bck = -1; float df = 1e9f, db = 1e9f;
+    for (int y=std::max(0, cy-2); y<=std::min(H-1, cy+2); ++y){
+      for (int x=std::max(0, cx-2); x<=std::min(W-1, cx+2); ++x){
+        const int j = at[size_t(y)*W + x];
+        if (j < 0 || j == i) continue;
+        const EdgePt& n = pts[j];
+        if (e.gx*n.gx + e.gy*n.gy <= 0) continue;            // opposite polarity
+        const float along = (n.x - e.x)*e.gy - (n.y - e.y)*e.gx;
+        const float d = dist2(e, n);
+        if (along > 0 && d < df){ df = d; fwd = j; }
+        else if (along < 0 && d < db){ db = d; bck = j; }
+      }
+    }
+    if (fwd >= 0 && pts[i].next != fwd && (pts[fwd].prev < 0 || dist2(pts[fwd], pts[pts[fwd].prev]) > df)){
+      if (pts[i].next >= 0) pts[pts[i].next].prev = -1;
+      if (pts[fwd].prev >= 0) pts[pts[fwd].prev].next = -1;
+      pts[i].next = fwd; pts[fwd].prev = i;
+    }
+    if (bck >= 0 && pts[i].prev != bck && (pts[bck].next < 0 || dist2(pts[bck], pts[pts[bck].next]) > db)){
+      if (pts[bck].next >= 0) pts[pts[bck].next].prev = -1;
+      if (pts[i].prev >= 0) pts[pts[i].prev].next = -1;
+      pts[bck].next = i; pts[i].prev = bck;
+    }
+  }
+
+  // 3) hysteresis: keep chains that reach `high` somewhere
+  std::vector<uchar> valid(pts.size(), 0);
+  std::vector<int> stack;
+  for (int i=0; i<(int)pts.size(); ++i){
+    if (valid[i] || pts[i].mod < high) continue;
+    stack.push_back(i); valid[i] = 1;
+    while (!stack.empty()){
+      const int k = stack.back(); stack.pop_back();
+      for (int n : {pts[k].next, pts[k].prev}) if (n >= 0 && !valid[n]){ valid[n] = 1; stack.push_back(n); }
+    }
+  }
+
+  // 4) walk chains from their first point (closed loops from any point)
+  std::vector<uchar> done(pts.size(), 0);
+  for (int i=0; i<(int)pts.size(); ++i){
+    if (!valid[i] || done[i]) continue;
+    int s = i;
+    for (size_t guard=0; pts[s].prev >= 0 && pts[s].prev != i && guard < pts.size(); ++guard) s = pts[s].prev;
+    EdgeChain c;
+    for (int k = s; k >= 0 && !done[k]; k = pts[k].next){ done[k] = 1; c.emplace_back(pts[k].x, pts[k].y); }
+    if ((int)c.size() >= prm.minLength) chains.push_back(std::move(c));
+  }
+}
+
+void keepOuterChains(std::vector<EdgeChain>& chains){
+  const size_t n = chains.size();
+  std::vector<double> area(n);
+  std::vector<uchar> closed(n);
+  std::vector<cv::Rect> box(n);
+  for (size_t i=0;i<n;++i){
+    const auto& c = chains[i];
+    closed[i] = c.size() >= 3 && cv::norm(c.front() - c.back()) <= 2.0;
+    area[i] = std::abs(cv::contourArea(c));
+    box[i] = cv::boundingRect(c);
+  }
+  std::vector<uchar> keep(n, 1);
+  for (size_t i=0;i<n;++i){
+    for (size_t j=0;j<n && keep[i];++j){
+      if (j == i || !closed[j] || area[j] <= area[i] || (box[i] & box[j]) != box[i]) continue;
+      if (cv::pointPolygonTest(chains[j], chains[i].front(), false) > 0) keep[i] = 0;
+    }
+  }
+  std::vector<size_t> order;
+  for (size_t i=0;i<n;++i) if (keep[i]) order.push_back(i);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b){ return area[a] > area[b]; });
+  std::vector<EdgeChain> out; out.reserve(order.size());
+  for (size_t i : order) out.push_back(std::move(chains[i]));
+  chains.swap(out);
+}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <vector>
+namespace mp {
+using EdgeChain = std::vector<cv::Point2f>;
+struct SubpixelEdgeParams {
+  double sigma = 1.0;        // Gaussian pre-smoothing; 0 = none
+  float low = 8.f, high = 20.f;  // hysteresis on gradient magnitude (gray levels / px)
+  int minLength = 8;         // shorter chains are dropped
+  int bits = 0;              // significant bits of 16-bit input, 0 = 16; low/high stay on the 8-bit scale
+};
+
+// Devernay-style sub-pixel edges: gradient maxima along the dominant axis,
+// refined by a parabola through the three magnitudes, linked into chains by
+// gradient orientation and filtered by hysteresis. Chains are ordinary
+// point sets, so every fitter and gauge takes them directly. `mask`
+// (8U, optional) limits where edge points may lie.
+void subpixelEdges(const cv::Mat& gray, std::vector<EdgeChain>& chains,
+                   const SubpixelEdgeParams& prm = {}, const cv::Mat& mask = cv::Mat());
+
+// Drops chains nested inside a larger closed chain (the chain analogue of
+// cv::RETR_EXTERNAL) and sorts the rest by enclosed area, largest first.
+void keepOuterChains(std::vector<EdgeChain>& chains);
+}
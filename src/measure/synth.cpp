@@ -0,0 +1,112 @@
+#include "measure/synth.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+namespace mp {
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+// Shades every pixel from `dist(x, y)`: signed distance to the outline in px,
+// negative inside the part. The profile across an edge is the unit step
+// convolved with the PSF and the pixel box (variance 1/12), taken as one
+// Gaussian; then illumination, noise and 8-bit quantisation are applied.
+template<class Dist>
+cv::Mat render(const SynthParams& p, Dist dist){
+  CV_Assert(p.size.width > 0 && p.size.height > 0);
+  const double s = std::sqrt(p.blurSigma*p.blurSigma + 1.0/12.0);
+  const double k = 1.0 / (std::sqrt(2.0)*s);
+  const double a = p.gradientAngleDeg*kPi/180.0, ga = std::cos(a), gb = std::sin(a);
+  const double cx = 0.5*(p.size.width-1), cy = 0.5*(p.size.height-1);
+  const double half = 0.5*std::hypot(p.size.width, p.size.height);
+  cv::Mat f(p.size, CV_32FC1);
+  cv::parallel_for_(cv::Range(0, p.size.height), [&](const cv::Range& r){
+    for (int y=r.start; y<r.end; ++y){
+      float* row = f.ptr<float>(y);
+      for (int x=0; x<p.size.width; ++x){
+        const double cov = 0.5*std::erfc(dist(double(x), double(y))*k);
+        const double light = 1.0 + 0.5*p.gradient*((x-cx)*ga + (y-cy)*gb)/half;
+        row[x] = float((p.background + (p.foreground - p.background)*cov)*light);
+      }
+    }
+  });
+  if (p.noiseSigma > 0){
+    cv::Mat n(p.size, CV_32FC1);
+    cv::RNG rng(p.seed);
+    rng.fill(n, cv::RNG::NORMAL, 0.0, p.noiseSigma);
+    f += n;
+  }
+  cv::Mat g, bgr;
+  f.convertTo(g, CV_8U);
+  cv::cvtColor(g, bgr, cv::COLOR_GRAY2BGR);
+  return bgr;
+}
+
+cv::Point2d centre(const SynthParams& p, cv::Point2d offset){
+  return cv::Point2d(0.5*(p.size.width-1), 0.5*(p.size.height-1)) + offset;
+}
+cv::Rect box(cv::Point2d c, double hw, double hh, cv::Size size){
+  return cv::Rect(cv::Point((int)std::floor(c.x-hw), (int)std::floor(c.y-hh)),
+                  cv::Point((int)std::ceil(c.x+hw), (int)std::ceil(c.y+hh))) & cv::Rect(cv::Point(), size);
+}
+}
+
+cv::Mat synthParallelLines(const SynthParams& p, double gapPx, double angleDeg, double tiltDeg,
+                           SynthTruth& truth, cv::Point2d offset){
+  CV_Assert(gapPx > 0);
+  const cv::Point2d c = centre(p, offset);
+  const double a = angleDeg*kPi/180.0, b = (angleDeg + tiltDeg)*kPi/180.0;
+  // unit normals, pointing from the top line towards the bottom one
+  const cv::Point2d n1(-std::sin(a), std::cos(a)), n2(-std::sin(b), std::cos(b));
+  const cv::Point2d p1 = c - 0.5*gapPx*n1, p2 = c + 0.5*gapPx*n1;
+  cv::Mat img = render(p, [&](double x, double y){
+    const double d1 = -((x-p1.x)*n1.x + (y-p1.y)*n1.y);   // > 0 above the top line
+    const double d2 = (x-p2.x)*n2.x + (y-p2.y)*n2.y;      // > 0 below the bottom line
+    return std::max(d1, d2);
+  });
+  // Along n1 through the centre the lines are exactly gapPx apart.
+  truth = SynthTruth{};
+  truth.lineGapPx = gapPx;
+  truth.parallelismDeg = std::abs(tiltDeg);
+  const double margin = std::max(12.0, 0.25*gapPx);
+  truth.roi = box(c, 0.35*p.size.width, 0.5*gapPx + margin, p.size);
+  return img;
+}
+
+cv::Mat synthRing(const SynthParams& p, double rOuterPx, double rInnerPx, cv::Point2d holeOffset,
+                  SynthTruth& truth, cv::Point2d offset){
+  CV_Assert(rOuterPx > rInnerPx + cv::norm(holeOffset) && rInnerPx > 0);
+  const cv::Point2d cA = centre(p, offset), cB = cA + holeOffset;
+  cv::Mat img = render(p, [&](double x, double y){
+    const double dA = std::hypot(x-cA.x, y-cA.y) - rOuterPx;
+    const double dB = std::hypot(x-cB.x, y-cB.y) - rInnerPx;
+    return std::max(dA, -dB);
+  });
+  truth = SynthTruth{};
+  truth.diameterAPx = 2*rOuterPx;
+  truth.roundnessAPx = 0;
+  truth.concentricityPx = cv::norm(holeOffset);
+  const double r = rOuterPx + std::max(8.0, 0.1*rOuterPx);
+  truth.roi = box(cA, r, r, p.size);
+  return img;
+}
+
+cv::Mat synthOutOfRound(const SynthParams& p, double r0Px, double ampPx, int lobes,
+                        SynthTruth& truth, cv::Point2d offset){
+  CV_Assert(lobes >= 2 && r0Px > std::abs(ampPx));
+  const cv::Point2d c = centre(p, offset);
+  cv::Mat img = render(p, [&](double x, double y){
+    const double dx = x-c.x, dy = y-c.y, rho = std::hypot(dx, dy);
+    const double t = std::atan2(dy, dx);
+    const double r = r0Px + ampPx*std::cos(lobes*t), dr = -ampPx*lobes*std::sin(lobes*t);
+    // radial offset scaled to the outline normal; exact to first order in dr/rho
+    return rho > 0 ? (rho - r) / std::sqrt(1.0 + dr*dr/(rho*rho)) : -r;
+  });
+  // Lobes >= 2 keep the least-squares centre on c and the radius at r0.
+  truth = SynthTruth{};
+  truth.diameterAPx = 2*r0Px;
+  truth.roundnessAPx = 2*std::abs(ampPx);
+  const double r = r0Px + std::abs(ampPx) + std::max(8.0, 0.1*r0Px);
+  truth.roi = box(c, r, r, p.size);
+  return img;
+}
+}
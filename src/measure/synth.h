@@ -0,0 +1,44 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <limits>
+namespace mp {
+// Imaging conditions for synthetic parts. Levels are 8-bit grey values.
+struct SynthParams {
+  cv::Size size{1280, 960};
+  double background = 40, foreground = 200;
+  double blurSigma = 0.8;         // Gaussian PSF (px); 0 = none
+  double noiseSigma = 2.0;        // additive Gaussian noise (grey levels)
+  double gradient = 0.0;          // illumination change across the image, e.g. 0.3 = +-15%
+  double gradientAngleDeg = 0.0;  // direction of increasing illumination
+  uint64_t seed = 1;
+};
+
+// Exact geometry of a rendered part, in px of the rendered image. Metrics a
+// scene does not define are NaN; roundness follows fitCircleGauge (2 * max
+// radial deviation) and the line gap is taken at the ROI centre.
+struct SynthTruth {
+  static constexpr double kNone = std::numeric_limits<double>::quiet_NaN();
+  double lineGapPx = kNone, parallelismDeg = kNone;
+  double diameterAPx = kNone, roundnessAPx = kNone, concentricityPx = kNone;
+  cv::Rect roi;  // box that holds the features with a margin
+};
+
+// Scene builders: each renders an 8-bit BGR image and fills `truth`. Pixels are
+// shaded analytically from their signed distance to the exact outline (a step
+// blurred by the PSF and the pixel footprint), so edges carry no grid or
+// kernel bias. Sizes are in px; `offset` moves the part from the image centre
+// and may be fractional.
+
+// Bright band between two lines; the bottom line is turned by `tiltDeg`
+// against the top one, the pair by `angleDeg` against the x axis.
+cv::Mat synthParallelLines(const SynthParams& p, double gapPx, double angleDeg, double tiltDeg,
+                           SynthTruth& truth, cv::Point2d offset = {});
+// Bright annulus; the hole (circle B) is displaced by `holeOffset` from the
+// outer circle (A).
+cv::Mat synthRing(const SynthParams& p, double rOuterPx, double rInnerPx, cv::Point2d holeOffset,
+                  SynthTruth& truth, cv::Point2d offset = {});
+// Bright disk with a lobed outline r(t) = r0 + amp*cos(lobes*t), lobes >= 2.
+cv::Mat synthOutOfRound(const SynthParams& p, double r0Px, double ampPx, int lobes,
+                        SynthTruth& truth, cv::Point2d offset = {});
+}
@@ -1,10 +1,19 @@
 #include "ops/threshold.h"
 #include <opencv2/imgproc.hpp>
+#include "core/gray_levels.h"
 namespace mp::op {
 mp::Frame Threshold::process(const mp::Frame& in){
   mp::Frame out=in; if (in.mat.empty()) return out;
   cv::Mat gray; if (in.mat.channels()==3) cv::cvtColor(in.mat, gray, cv::COLOR_BGR2GRAY); else gray=in.mat;
-  cv::Mat bw; cv::threshold(gray, bw, thr_, 255, type_);
+  cv::Mat bw;
+  if (gray.depth()==CV_8U) cv::threshold(gray, bw, thr_, 255, type_);
+  else {
+    // thr_ is on the 8-bit scale; binary types compare straight into an 8-bit mask
+    const double k = levelScale(gray.depth(), in.bits), level = thr_*k;
+    if (type_==cv::THRESH_BINARY || type_==cv::THRESH_BINARY_INV)
+      cv::compare(gray, level, bw, type_==cv::THRESH_BINARY? cv::CMP_GT : cv::CMP_LE);
+    else { cv::threshold(gray, bw, level, fullScale(gray.depth(), in.bits), type_); bw.convertTo(bw, CV_8U, 1.0/k); }
+  }
   cv::cvtColor(bw, out.mat, cv::COLOR_GRAY2BGR);
   out.tag = in.tag + "|thr"; return out;
 }
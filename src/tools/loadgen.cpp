@@ -0,0 +1,297 @@
+// myproject_loadgen: drives POST /measure on a local myproject_backend and
+// reports throughput and latency percentiles as JSON.
+//
+// Each connection runs on its own thread with a blocking socket. In open-loop
+// mode (--rate > 0) requests are scheduled at fixed intervals, and latency is
+// measured from the scheduled send time rather than the actual one, so a
+// stalled server is charged for the requests that queued up behind the stall
+// (coordinated-omission correction). With --rate 0 each connection sends its
+// next request as soon as the previous one completes (closed loop).
+//
+// The spec goes inline with every request, so a load test leaves no SPC
+// history behind; --spec-id measures against a stored spec and records there.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  QString host = "127.0.0.1";
+  quint16 port = 8080;
+  int connections = 4;
+  double rate = 0;          // requests/s over all connections; 0 = closed loop
+  double duration = 10, warmup = 2;
+  bool keepAlive = true;
+  QStringList images;
+  QString specId;           // stored spec; empty = send `specs` inline
+  QJsonObject specs;
+  QJsonObject roi;
+};
+
+struct Sample { double latencyUs, serviceUs; };
+
+struct ConnStats {
+  std::vector<Sample> samples;
+  qint64 errors = 0;
+};
+
+QByteArray requestBytes(const Options& o, const QString& image){
+  QJsonObject payload{{"image_path", image}};
+  if (o.specId.isEmpty()) payload["specs"] = o.specs;
+  else payload["spec_id"] = o.specId;
+  if (!o.roi.isEmpty()) payload["roi"] = o.roi;
+  const QByteArray body = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+  QByteArray req;
+  req += "POST /measure HTTP/1.1\r\n";
+  req += "Host: " + o.host.toUtf8() + "\r\n";
+  req += "Content-Type: application/json\r\n";
+  req += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+  req += o.keepAlive? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+  req += body;
+  return req;
+}
+
+// Sends one request and reads one full response (headers + Content-Length body).
+// Returns the HTTP status, or 0 on I/O failure.
+int exchange(QTcpSocket& s, const QByteArray& req, bool& serverCloses){
+  constexpr int kTimeoutMs = 30000;
+  s.write(req);
+  if (!s.waitForBytesWritten(kTimeoutMs)) return 0;
+  QByteArray buf;
+  qint64 headerEnd = -1;
+  while ((headerEnd = buf.indexOf("\r\n\r\n")) < 0){
+    if (!s.waitForReadyRead(kTimeoutMs)) return 0;
+    buf += s.readAll();
+  }
+  const QList<QByteArray> lines = buf.left(headerEnd).split('\n');
+  const QList<QByteArray> status = lines.first().trimmed().split(' ');
+  int code = status.size()>1? status[1].toInt() : 0;
+  qint64 length = 0;
+  serverCloses = false;
+  for (int i=1;i<lines.size();++i){
+    const auto colon = lines[i].indexOf(':');
+    if (colon < 0) continue;
+    const QByteArray key = lines[i].left(colon).trimmed().toLower();
+    if (key=="content-length") length = lines[i].mid(colon+1).trimmed().toLongLong();
+    else if (key=="connection") serverCloses = lines[i].mid(colon+1).trimmed().toLower()=="close";
+  }
+  while (buf.size() < headerEnd + 4 + length){
+    if (!s.waitForReadyRead(kTimeoutMs)) return 0;
+    buf += s.readAll();
+  }
+  return code;
+}
+
+void runConnection(const Options& o, const std::vector<QByteArray>& reqs, int conn,
+                   Clock::time_point start, ConnStats& st){
+  const auto warmEnd = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.warmup));
+  const auto end = warmEnd + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.duration));
+  const double interval = o.rate > 0 ? o.connections / o.rate : 0.0;   // per-connection spacing
+  const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+  // Stagger connections so the aggregate arrivals are evenly spaced.
+  auto intended = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval*conn/o.connections));
+  QTcpSocket s;
+  size_t next = conn;
+  for (;;){
+    if (o.rate > 0){
+      if (intended >= end) break;
+      std::this_thread::sleep_until(intended);
+    } else {
+      intended = Clock::now();
+      if (intended >= end) break;
+    }
+    if (s.state() != QAbstractSocket::ConnectedState){
+      s.abort();
+      s.connectToHost(o.host, o.port);
+      if (!s.waitForConnected(5000)){
+        if (intended >= warmEnd) ++st.errors;
+        s.abort();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        intended += step;
+        continue;
+      }
+    }
+    const auto sent = Clock::now();
+    bool closes = false;
+    const int code = exchange(s, reqs[next % reqs.size()], closes);
+    const auto done = Clock::now();
+    next += o.connections;
+    if (intended >= warmEnd){
+      if (code == 200)
+        st.samples.push_back({std::chrono::duration<double, std::micro>(done - intended).count(),
+                              std::chrono::duration<double, std::micro>(done - sent).count()});
+      else
+        ++st.errors;
+    }
+    if (code != 200 || closes || !o.keepAlive) s.abort();
+    intended += step;
+  }
+}
+
+QJsonObject percentiles(std::vector<double> v){
+  QJsonObject o;
+  if (v.empty()) return o;
+  std::sort(v.begin(), v.end());
+  auto at = [&](double p){ size_t i = (size_t)std::ceil(p*v.size()); return v[std::min(v.size()-1, i? i-1 : 0)] / 1000.0; };
+  double sum = 0; for (double x : v) sum += x;
+  o["p50"] = at(0.50); o["p90"] = at(0.90); o["p99"] = at(0.99); o["p999"] = at(0.999);
+  o["max"] = v.back() / 1000.0; o["mean"] = sum / v.size() / 1000.0;
+  return o;
+}
+
+bool waitHealthy(const Options& o, int timeoutMs){
+  const auto until = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (Clock::now() < until){
+    QTcpSocket s;
+    s.connectToHost(o.host, o.port);
+    if (s.waitForConnected(500)){
+      s.write("GET /health HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+      s.waitForBytesWritten(500);
+      QByteArray buf;
+      while (s.waitForReadyRead(500)) buf += s.readAll();
+      if (buf.startsWith("HTTP/1.1 200")) return true;
+    }
+    QThread::msleep(100);
+  }
+  return false;
+}
+
+QStringList resolveImages(const QString& arg){
+  QStringList out;
+  for (const QString& part : arg.split(',', Qt::SkipEmptyParts)){
+    QFileInfo fi(part);
+    if (fi.isDir()){
+      for (const QFileInfo& f : QDir(part).entryInfoList({"*.png","*.jpg","*.jpeg","*.bmp","*.tif","*.tiff"}, QDir::Files, QDir::Name))
+        out << f.absoluteFilePath();
+    } else if (fi.exists()) out << fi.absoluteFilePath();
+  }
+  return out;
+}
+
+// Inline spec from a file holding either one spec object or a specs.json map,
+// whose "default" entry is taken. A missing file gives the engine defaults.
+bool loadSpecs(const QString& path, bool required, QJsonObject& out){
+  QFile f(path);
+  if (!f.open(QIODevice::ReadOnly)) return !required;
+  const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+  if (!doc.isObject()) return false;
+  out = doc.object();
+  if (out.value("default").isObject()) out = out.value("default").toObject();
+  return true;
+}
+}
+
+int main(int argc, char** argv){
+  QCoreApplication app(argc, argv);
+  QCommandLineParser cli;
+  cli.setApplicationDescription("Load generator for myproject_backend POST /measure.");
+  cli.addHelpOption();
+  cli.addOptions({
+    {"port", "Backend port (default 8090 when spawned, 8080 with --no-spawn).", "port"},
+    {"connections", "Concurrent connections (default 4).", "n", "4"},
+    {"rate", "Open-loop arrival rate in requests/s over all connections; 0 = closed loop (default).", "rps", "0"},
+    {"duration", "Measured seconds (default 10).", "s", "10"},
+    {"warmup", "Warm-up seconds, not recorded (default 2).", "s", "2"},
+    {"no-keepalive", "Open a new connection for every request."},
+    {"images", "Comma-separated image files and/or directories (default tests/data).", "list"},
+    {"specs", "JSON file with the spec sent inline: a spec object or a specs.json map (its \"default\"). "
+              "Default: config/specs.json.", "path"},
+    {"spec-id", "Measure against this stored spec instead; every request is appended to its SPC history.", "id"},
+    {"roi", "Rect ROI as x,y,w,h.", "rect"},
+    {"backend", "Backend executable to spawn (default: next to this tool).", "path"},
+    {"no-spawn", "Use an already running backend."},
+    {"out", "Also write the JSON report to this file.", "path"},
+  });
+  cli.process(app);
+
+  Options o;
+  const bool spawn = !cli.isSet("no-spawn");
+  o.port = cli.isSet("port")? (quint16)cli.value("port").toUInt() : spawn? 8090 : 8080;
+  o.connections = std::max(1, cli.value("connections").toInt());
+  o.rate = std::max(0.0, cli.value("rate").toDouble());
+  o.duration = cli.value("duration").toDouble();
+  o.warmup = cli.value("warmup").toDouble();
+  o.keepAlive = !cli.isSet("no-keepalive");
+  o.specId = cli.value("spec-id");
+  if (o.specId.isEmpty()){
+    const bool given = cli.isSet("specs");
+    const QString path = given? cli.value("specs") : QCoreApplication::applicationDirPath() + "/../../config/specs.json";
+    if (!loadSpecs(path, given, o.specs)){ qCritical() << "cannot read spec from" << path; return 2; }
+  }
+  o.images = resolveImages(cli.isSet("images")? cli.value("images") : QCoreApplication::applicationDirPath() + "/../../tests/data");
+  if (cli.isSet("roi")){
+    const QStringList r = cli.value("roi").split(',');
+    if (r.size()!=4){ qCritical("--roi expects x,y,w,h"); return 2; }
+    o.roi = QJsonObject{{"type","rect"}, {"x",r[0].toInt()}, {"y",r[1].toInt()}, {"w",r[2].toInt()}, {"h",r[3].toInt()}};
+  }
+  if (o.images.isEmpty()){ qCritical("no images found"); return 2; }
+
+  QProcess backend;
+  if (spawn){
+    QString exe = cli.value("backend");
+    if (exe.isEmpty()) exe = QDir(QCoreApplication::applicationDirPath()).filePath("myproject_backend");
+    backend.setProgram(exe);
+    backend.setArguments({"--port", QString::number(o.port)});
+    backend.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    backend.start();
+    if (!backend.waitForStarted(5000)){ qCritical() << "cannot start" << exe; return 1; }
+  }
+  if (!waitHealthy(o, spawn? 10000 : 2000)){
+    qCritical() << "backend not healthy on port" << o.port;
+    if (spawn){ backend.kill(); backend.waitForFinished(); }
+    return 1;
+  }
+
+  std::vector<QByteArray> reqs;
+  for (const QString& img : o.images) reqs.push_back(requestBytes(o, img));
+
+  std::vector<ConnStats> stats(o.connections);
+  std::vector<std::thread> threads;
+  const auto start = Clock::now() + std::chrono::milliseconds(50);
+  for (int c=0;c<o.connections;++c)
+    threads.emplace_back([&, c]{ runConnection(o, reqs, c, start, stats[c]); });
+  for (auto& t : threads) t.join();
+
+  std::vector<double> lat, svc;
+  qint64 errors = 0;
+  for (const ConnStats& st : stats){
+    for (const Sample& s : st.samples){ lat.push_back(s.latencyUs); svc.push_back(s.serviceUs); }
+    errors += st.errors;
+  }
+  QJsonObject report{
+    {"config", QJsonObject{{"connections", o.connections}, {"rate_rps", o.rate}, {"mode", o.rate > 0? "open" : "closed"},
+                           {"duration_s", o.duration}, {"warmup_s", o.warmup}, {"keepalive", o.keepAlive},
+                           {"images", o.images.size()}, {"spec_id", o.specId.isEmpty()? QJsonValue("inline") : QJsonValue(o.specId)}}},
+    {"requests", (qint64)lat.size()},
+    {"errors", errors},
+    {"throughput_rps", lat.size() / o.duration},
+    // latency is measured from the scheduled send time (equal to the actual one in closed loop)
+    {"latency_ms", percentiles(lat)},
+    {"service_ms", percentiles(svc)},
+  };
+  const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+  QTextStream(stdout) << json;
+  if (cli.isSet("out")){
+    QFile f(cli.value("out"));
+    if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size()) qWarning() << "cannot write" << f.fileName();
+  }
+  if (spawn){ backend.kill(); backend.waitForFinished(); }
+  return errors && lat.empty()? 1 : 0;
+}
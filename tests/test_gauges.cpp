@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <opencv2/opencv.hpp>
 #include "measure/gauges.h"
+#include "measure/gauge_batch.h"
 
 using namespace mp;
 
@@ -39,3 +40,43 @@ TEST(Gauges, RoundnessSynthetic){
   auto m = gauge::metricRoundnessMM(pts, cal);
   EXPECT_LT(m.value_mm, 0.05); // 50 microns at this scale
 }
+
+TEST(Gauges, LineGapIgnoresDirectionSign){
+  Line2D a{{0,0},{1,0}}, b{{100,10},{-1,0}}; // antiparallel fit of the same edge pair
+  EXPECT_NEAR(gauge::lineLineDistancePx(a,b, cv::Rect(0,0,100,100)), 10.0, 1e-9);
+}
+
+TEST(Gauges, LineGapClosedFormTiltedLine){
+  // L2 tilted: gap goes linearly from 5 to 15 px across the ROI width
+  Line2D a{{0,50},{1,0}}, b{{0,55},{100,10}};
+  EXPECT_NEAR(gauge::lineLineDistancePx(a,b, cv::Rect(0,0,100,100)), 10.0*100/std::hypot(100.0,10.0), 1e-3);
+}
+
+TEST(Gauges, BatchMatchesScalar){
+  Calibration cal; cal.scale_mm_per_px = 0.05;
+  gauge::GaugeBatch gb;
+  cv::RNG rng(42);
+  for (int i=0;i<64;++i){
+    float ang = (float)rng.uniform(-0.3, 0.3);
+    gb.lines.add(Line2D{{(float)rng.uniform(0.,200.), (float)rng.uniform(0.,200.)}, {std::cos(ang), std::sin(ang)}});
+    gb.circles.add(Circle{{(float)rng.uniform(0.,200.), (float)rng.uniform(0.,200.)}, 10});
+  }
+  std::vector<cv::Rect> rois;
+  for (int i=0;i<63;++i){
+    rois.emplace_back(rng.uniform(0,100), rng.uniform(0,100), rng.uniform(10,100), rng.uniform(10,100));
+    gb.addLinePair(i, i+1, rois.back(), 5.0, 0.2, 0.1);
+    gb.addCirclePair(i, i+1, 1.0);
+  }
+  gauge::GaugeBatch::Result r; gb.evaluate(cal, r);
+  ASSERT_EQ(r.gapMM.size(), 63u);
+  for (int i=0;i<63;++i){
+    Line2D L1{{gb.lines.px[i], gb.lines.py[i]}, {gb.lines.vx[i], gb.lines.vy[i]}};
+    Line2D L2{{gb.lines.px[i+1], gb.lines.py[i+1]}, {gb.lines.vx[i+1], gb.lines.vy[i+1]}};
+    Circle A{{gb.circles.cx[i], gb.circles.cy[i]}, 10}, B{{gb.circles.cx[i+1], gb.circles.cy[i+1]}, 10};
+    EXPECT_NEAR(r.gapMM[i], gauge::metricLineGapMM(L1, L2, rois[i], cal).value_mm, 1e-6);
+    EXPECT_NEAR(r.parallelDeg[i], gauge::lineLineParallelismDeg(L1, L2), 1e-4);
+    EXPECT_NEAR(r.concentricityMM[i], gauge::metricConcentricityMM(A, B, cal).value_mm, 1e-6);
+    EXPECT_EQ(r.concentricityOk[i] != 0, r.concentricityMM[i] <= 1.0);
+  }
+  EXPECT_EQ(r.metrics().size(), 3u*63u);
+}
@@ -6,22 +6,45 @@
 #include "ops/morph.h"
 #include "ops/threshold.h"
 #include "measure/geometry.h"
+#include "measure/geometry_batch.h"
 #include "measure/gauges.h"
 #include "measure/calibration.h"
+#include "measure/pyramid.h"
 
 using namespace mp;
 
 static cv::Rect full(const cv::Mat& m){ return {0,0,m.cols,m.rows}; }
 
-static void extractContours(const cv::Mat& bgr, std::vector<std::vector<cv::Point>>& contours){
+// External contours of the edge map, largest first; `mask` limits them to
+// an ROI, as the engine's ROI masks do.
+static void extractContours(const cv::Mat& bgr, std::vector<std::vector<cv::Point>>& contours, const cv::Mat& mask = cv::Mat()){
   cv::Mat gray;
   if (bgr.channels()==3) cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY); else gray=bgr;
   cv::Mat e; cv::Canny(gray, e, 50, 150, 3, true);
   cv::Mat bw; cv::threshold(e, bw, 0,255, cv::THRESH_OTSU);
+  if (!mask.empty()) cv::bitwise_and(bw, mask, bw);
   cv::findContours(bw, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
   std::sort(contours.begin(), contours.end(), [](auto& a, auto& b){ return cv::contourArea(a) > cv::contourArea(b); });
 }
 
+// The ring images hold an outer ring (r=120) around an inner one (r=60); the
+// outer one encloses the inner, so each gets its own ROI mask.
+static cv::Mat ringMask(const cv::Mat& img, int r0, int r1){
+  cv::Mat m = cv::Mat::zeros(img.size(), CV_8UC1);
+  const cv::Point c(img.cols/2, img.rows/2);
+  cv::circle(m, c, r1, cv::Scalar(255), cv::FILLED);
+  if (r0 > 0) cv::circle(m, c, r0, cv::Scalar(0), cv::FILLED);
+  return m;
+}
+static const int kOuterRing[2] = {90, 150}, kInnerRing[2] = {0, 90};
+
+static std::vector<cv::Point2f> ringContour(const cv::Mat& img, const int (&ring)[2]){
+  std::vector<std::vector<cv::Point>> cs; extractContours(img, cs, ringMask(img, ring[0], ring[1]));
+  std::vector<cv::Point2f> pts;
+  if (!cs.empty()) for (auto& p: cs[0]) pts.push_back(p);
+  return pts;
+}
+
 TEST(Golden, ParallelLinesGapAndParallelism){
   cv::Mat img = cv::imread("tests/data/parallel_lines.png");
   ASSERT_FALSE(img.empty());
@@ -49,11 +72,8 @@ TEST(Golden, ParallelLinesGapAndParallelism){
 TEST(Golden, ConcentricRingsConcentricityZero){
   cv::Mat img = cv::imread("tests/data/rings_concentric.png");
   ASSERT_FALSE(img.empty());
-  std::vector<std::vector<cv::Point>> cs; extractContours(img, cs);
-  ASSERT_GE(cs.size(), 2);
-  std::vector<cv::Point2f> a, b;
-  for (auto&p: cs[0]) a.push_back(p);
-  for (auto&p: cs[1]) b.push_back(p);
+  auto a = ringContour(img, kOuterRing), b = ringContour(img, kInnerRing);
+  ASSERT_GE(a.size(), 50u); ASSERT_GE(b.size(), 50u);
   auto A = fitCircleKasa(a), B = fitCircleKasa(b);
   Calibration cal; cal.scale_mm_per_px = 0.02;
   auto conc = gauge::metricConcentricityMM(A,B,cal);
@@ -63,11 +83,8 @@ TEST(Golden, ConcentricRingsConcentricityZero){
 TEST(Golden, OffsetRingsConcentricityKnown){
   cv::Mat img = cv::imread("tests/data/rings_offset.png");
   ASSERT_FALSE(img.empty());
-  std::vector<std::vector<cv::Point>> cs; extractContours(img, cs);
-  ASSERT_GE(cs.size(), 2);
-  std::vector<cv::Point2f> a, b;
-  for (auto&p: cs[0]) a.push_back(p);
-  for (auto&p: cs[1]) b.push_back(p);
+  auto a = ringContour(img, kOuterRing), b = ringContour(img, kInnerRing);
+  ASSERT_GE(a.size(), 50u); ASSERT_GE(b.size(), 50u);
   auto A = fitCircleKasa(a), B = fitCircleKasa(b);
   Calibration cal; cal.scale_mm_per_px = 0.02;
   auto conc = gauge::metricConcentricityMM(A,B,cal);
@@ -87,3 +104,60 @@ TEST(Golden, RoundnessWithinBounds){
   EXPECT_GE(rnd.value_mm, cal.toMM(2.0));
   EXPECT_LE(rnd.value_mm, cal.toMM(6.0));
 }
+
+// Pyramid mode: coarse contours/fits at 1/4 resolution, full-res edges only in
+// bands around them; must agree with the full-resolution path above.
+TEST(Golden, PyramidLinesMatchFullRes){
+  cv::Mat img = cv::imread("tests/data/parallel_lines.png");
+  ASSERT_FALSE(img.empty());
+  std::vector<std::vector<cv::Point>> cs; extractContours(img, cs);
+  std::vector<cv::Point2f> topPts, botPts;
+  for (auto& c: cs) for (auto&p: c) (p.y < img.rows*0.5 ? topPts : botPts).push_back(p);
+  auto Ltop = fitLineLSQ(topPts), Lbot = fitLineLSQ(botPts);
+
+  MeasurePyramid pyr(img);
+  ASSERT_EQ(pyr.scale(), 4);
+  auto cc = pyr.coarseContours();
+  std::vector<cv::Point2f> ct, cb;
+  for (auto& c: cc) for (auto& p: c) (p.y < img.rows*0.5 ? ct : cb).push_back(p);
+  ASSERT_GE(ct.size(), 5u); ASSERT_GE(cb.size(), 5u);
+  Line2D Pt, Pb;
+  ASSERT_TRUE(pyr.refine(fitLineLSQ(ct), full(img), Pt));
+  ASSERT_TRUE(pyr.refine(fitLineLSQ(cb), full(img), Pb));
+
+  Calibration cal; cal.scale_mm_per_px = 0.05;
+  double gapFull = gauge::metricLineGapMM(Ltop, Lbot, full(img), cal).value_mm;
+  double gapPyr = gauge::metricLineGapMM(Pt, Pb, full(img), cal).value_mm;
+  EXPECT_NEAR(gapPyr, gapFull, cal.toMM(0.25));
+  EXPECT_NEAR(gapPyr, cal.toMM(100.0), cal.toMM(1.0));
+  EXPECT_LE(gauge::lineLineParallelismDeg(Pt, Pb), 0.05);
+}
+
+TEST(Golden, PyramidCirclesMatchFullRes){
+  cv::Mat img = cv::imread("tests/data/rings_offset.png");
+  ASSERT_FALSE(img.empty());
+  MeasurePyramid pyr(img);
+  Circle P[2];
+  for (int k=0; k<2; ++k){
+    const int (&ring)[2] = k==0? kOuterRing : kInnerRing;
+    auto full = ringContour(img, ring);
+    ASSERT_GE(full.size(), 50u);
+    const auto F = fitCircleGauge(full);
+
+    auto cc = pyr.coarseContours(ringMask(img, ring[0], ring[1]));
+    ASSERT_GE(cc.size(), 1u);
+    const Circle coarse = fitCircleKasa(cc[0]);
+    // the band spans both sides of the 5 px stroke; the polarity keeps the
+    // outer side, which the full-res external contour is traced on
+    const int pol = pyr.polarity(cc[0], coarse);
+    EXPECT_EQ(pol, -1);
+    std::vector<cv::Point2f> pts;
+    ASSERT_TRUE(pyr.refine(coarse, P[k], &pts, pol));
+    const auto G = fitCircleGauge(pts);
+    EXPECT_LE(gauge::circleCenterDistancePx(F.circle, P[k]), 0.5);
+    EXPECT_NEAR(G.diameterPx, F.diameterPx, 0.3);
+    EXPECT_NEAR(G.roundnessPx, F.roundnessPx, 0.5);
+  }
+  Calibration cal; cal.scale_mm_per_px = 0.02;
+  EXPECT_NEAR(gauge::metricConcentricityMM(P[0], P[1], cal).value_mm, cal.toMM(20.0), cal.toMM(1.0));
+}
@@ -2,6 +2,8 @@
 #include <chrono>
 #include "core/pipeline.h"
 #include "ops/canny.h"
+#include "measure/geometry.h"
+#include <random>
 using namespace mp;
 TEST(Perf, Canny1080pOver1fps){
   cv::Mat img = cv::Mat::ones(1080,1920,CV_8UC3)*127;
@@ -13,3 +15,25 @@ TEST(Perf, Canny1080pOver1fps){
   double fps = N/dt;
   EXPECT_GT(fps, 1.0);
 }
+TEST(Perf, RobustFitCostPer10kPoints){
+  std::vector<cv::Point2f> circ, line;
+  std::mt19937 rng(7); std::normal_distribution<float> noise(0.f, 0.3f);
+  for (int i=0;i<10000;++i){
+    float t = float(i)*float(2*CV_PI/10000);
+    circ.push_back({500+200*std::cos(t)+noise(rng), 500+200*std::sin(t)+noise(rng)});
+    line.push_back({float(i)*0.1f, 0.3f*float(i)*0.1f + 20 + noise(rng)});
+  }
+  for (int i=0;i<500;++i){ circ[i*20].x += 15.f; line[i*20].y -= 15.f; } // 5% outliers
+  const int N=20;
+  auto t0 = std::chrono::high_resolution_clock::now();
+  for (int i=0;i<N;++i) (void)fitCircleRobust(circ);
+  double msCircle = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t0).count()/N;
+  t0 = std::chrono::high_resolution_clock::now();
+  for (int i=0;i<N;++i) (void)fitLineRobust(line);
+  double msLine = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t0).count()/N;
+  // timings go to the gtest XML report (--gtest_output=xml), not to stdout
+  RecordProperty("robust_circle_us_per_10k", int(msCircle*1000));
+  RecordProperty("robust_line_us_per_10k", int(msLine*1000));
+  EXPECT_LT(msCircle, 100.0);
+  EXPECT_LT(msLine, 100.0);
+}
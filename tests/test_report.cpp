@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <limits>
+#include "measure/report.h"
+using namespace mp;
+static std::vector<Item> sampleItems(){
+  return {{"line_gap", 5.0125, "mm", true, "5+-0.2"},
+          {"odd \"name\",x", 0.1, "deg", false, "line1\nline2"},
+          {"nan_metric", std::numeric_limits<double>::quiet_NaN(), "mm", false, ""}};
+}
+TEST(Report, JsonEscapesAndRoundTrips){
+  auto w = makeReportWriter(ReportFormat::Json, "metrics");
+  std::string out; writeReport(*w, sampleItems(), out);
+  EXPECT_EQ(out.rfind("{\"metrics\":[{\"name\":\"line_gap\",\"value\":5.0125,\"unit\":\"mm\",\"ok\":true,", 0), 0u);
+  EXPECT_NE(out.find("\"name\":\"odd \\\"name\\\",x\""), std::string::npos);
+  EXPECT_NE(out.find("\"note\":\"line1\\nline2\""), std::string::npos);
+  EXPECT_NE(out.find("\"value\":null"), std::string::npos);
+  EXPECT_EQ(out.substr(out.size()-2), "]}");
+  EXPECT_EQ(toJson({}), "{\"results\":[]}");
+}
+TEST(Report, CsvQuotesOnlyWhenNeeded){
+  auto w = makeReportWriter(ReportFormat::Csv);
+  std::string out; writeReport(*w, sampleItems(), out);
+  ASSERT_EQ(out.rfind(kReportCsvHeader, 0), 0u);
+  EXPECT_NE(out.find("\nline_gap,5.0125,mm,1,5+-0.2\n"), std::string::npos);
+  EXPECT_NE(out.find("\"odd \"\"name\"\",x\",0.1,deg,0,\"line1\nline2\"\n"), std::string::npos);
+  // appending a second part to the same log does not repeat the header
+  const size_t one = out.size();
+  w->begin(out); w->item(out, sampleItems()[0]); w->end(out);
+  EXPECT_EQ(out.find("name,value", 1), std::string::npos);
+  EXPECT_GT(out.size(), one);
+}
+TEST(Report, BinaryFixedRecords){
+  auto w = makeReportWriter(ReportFormat::Binary);
+  auto items = sampleItems();
+  std::string out; writeReport(*w, items, out);
+  ASSERT_EQ(out.size(), items.size()*sizeof(ReportRecord));
+  ReportRecord r; std::memcpy(&r, out.data(), sizeof r);
+  EXPECT_STREQ(r.name, "line_gap");
+  EXPECT_STREQ(r.unit, "mm");
+  EXPECT_EQ(r.value, 5.0125);
+  EXPECT_EQ(r.ok, 1);
+  std::memcpy(&r, out.data() + sizeof r, sizeof r);
+  EXPECT_EQ(std::string(r.note, sizeof r.note), std::string("line1\nline2\0\0\0\0\0", 16));
+}
+TEST(Report, BinaryTruncatesAtCodePoint){
+  auto w = makeReportWriter(ReportFormat::Binary);
+  // "\xC3\xA9" (e-acute) straddles the 16-byte note limit in the first item
+  // and ends exactly on it in the second
+  std::vector<Item> items{{"d", 1.0, "mm", true, std::string(15, 'a') + "\xC3\xA9"},
+                          {"d", 1.0, "mm", true, std::string(14, 'a') + "\xC3\xA9"}};
+  std::string out; writeReport(*w, items, out);
+  ReportRecord r; std::memcpy(&r, out.data(), sizeof r);
+  EXPECT_EQ(std::string(r.note, sizeof r.note), std::string(15, 'a') + std::string(1, '\0'));
+  std::memcpy(&r, out.data() + sizeof r, sizeof r);
+  EXPECT_EQ(std::string(r.note, sizeof r.note), items[1].note);
+}
+TEST(Report, BinaryKeepsMultiRoiNames){
+  auto w = makeReportWriter(ReportFormat::Binary);
+  // the longest ROI name the backend accepts for binary, plus the longest item
+  const std::string roi(kReportRoiNameMax, 'r');
+  std::vector<Item> items{{"bore_left.concentricity_AB", 0.01, "mm", true, ""},
+                          {"bore_right.concentricity_AB", 0.02, "mm", true, ""},
+                          {roi + ".concentricity_AB", 0.03, "mm", true, ""}};
+  std::string out; writeReport(*w, items, out);
+  ASSERT_EQ(out.size(), items.size()*sizeof(ReportRecord));
+  for (size_t i=0;i<items.size();++i){
+    ReportRecord r; std::memcpy(&r, out.data() + i*sizeof r, sizeof r);
+    EXPECT_EQ(std::string(r.name), items[i].name);
+  }
+}
+TEST(Report, ReusedBufferKeepsCapacity){
+  auto w = makeReportWriter(ReportFormat::Json);
+  auto items = sampleItems();
+  std::string out; writeReport(*w, items, out);
+  const char* data = out.data(); const size_t cap = out.capacity();
+  for (int i=0;i<100;++i) writeReport(*w, items, out);
+  EXPECT_EQ(out.data(), data);
+  EXPECT_EQ(out.capacity(), cap);
+}
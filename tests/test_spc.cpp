@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include "backend/spc_store.h"
+#include <QJsonArray>
+#include <QJsonObject>
+
+static QString tempSpcDir(const char* name){
+  auto p = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(p);
+  return QString::fromStdString(p.string());
+}
+
+TEST(Spc, OnlineStatsMatchBatch){
+  const QString dir = tempSpcDir("mp_spc_stats");
+  std::vector<double> xs;
+  for (int i=0;i<200;++i) xs.push_back(5.0 + 0.01*std::sin(i*0.7) + 0.002*(i%7));
+  {
+    SpcStore store(dir, 64);
+    for (size_t i=0;i<xs.size();++i)
+      ASSERT_TRUE(store.append("default", "line_gap", xs[i], std::abs(xs[i]-5.0) <= 0.01, 4.99, 5.01, int64_t(i)));
+  }
+  double mean=0; for (double x: xs) mean += x; mean /= xs.size();
+  double var=0; for (double x: xs) var += (x-mean)*(x-mean); var /= xs.size()-1;
+  double mr=0; for (size_t i=1;i<xs.size();++i) mr += std::abs(xs[i]-xs[i-1]); mr /= xs.size()-1;
+  int oot=0; for (double x: xs) oot += std::abs(x-5.0) > 0.01;
+
+  SpcStore store(dir, 64);   // reopened: statistics come from the mapped header
+  const SpcStats* st = store.stats("default", "line_gap");
+  ASSERT_NE(st, nullptr);
+  EXPECT_EQ(st->n, xs.size());
+  EXPECT_NEAR(st->mean, mean, 1e-12);
+  EXPECT_NEAR(st->stddev(), std::sqrt(var), 1e-12);
+  EXPECT_NEAR(st->sigmaShortTerm(), mr/1.128, 1e-12);
+  EXPECT_EQ(st->oot, (uint64_t)oot);
+  EXPECT_NEAR(st->cpk(), std::min(5.01-mean, mean-4.99) / (3*mr/1.128), 1e-9);
+  EXPECT_NEAR(st->ppk(), std::min(5.01-mean, mean-4.99) / (3*std::sqrt(var)), 1e-9);
+
+  // ring keeps the latest `capacity` records
+  auto last = store.recent("default", "line_gap", 1000);
+  ASSERT_EQ(last.size(), 64u);
+  EXPECT_EQ(last.front().t_ms, 200-64);
+  EXPECT_EQ(last.back().value, xs.back());
+
+  auto js = store.statsJson("default");
+  EXPECT_EQ(js.value("metrics").toArray().size(), 1);
+  EXPECT_EQ(store.stats("default", "missing"), nullptr);
+  std::filesystem::remove_all(dir.toStdString());
+}
+
+TEST(Spc, NamesThatSanitiseAlikeKeepSeparateSeries){
+  const QString dir = tempSpcDir("mp_spc_names");
+  {
+    SpcStore store(dir, 16);
+    ASSERT_TRUE(store.append("default", "a/b", 1.0, true, NAN, NAN, 0));
+    ASSERT_TRUE(store.append("default", "a_b", 2.0, true, NAN, NAN, 0));
+    ASSERT_TRUE(store.append("default", "a_b", 4.0, true, NAN, NAN, 1));
+    // spec ids share a directory the same way
+    ASSERT_TRUE(store.append("x/y", "gap", 7.0, true, NAN, NAN, 0));
+    ASSERT_TRUE(store.append("x_y", "gap", 9.0, true, NAN, NAN, 0));
+  }
+  SpcStore store(dir, 16);   // reopened: series are found through their headers
+  ASSERT_NE(store.stats("default", "a/b"), nullptr);
+  ASSERT_NE(store.stats("default", "a_b"), nullptr);
+  EXPECT_EQ(store.stats("default", "a/b")->n, 1u);
+  EXPECT_DOUBLE_EQ(store.stats("default", "a/b")->mean, 1.0);
+  EXPECT_EQ(store.stats("default", "a_b")->n, 2u);
+  EXPECT_DOUBLE_EQ(store.stats("default", "a_b")->mean, 3.0);
+  EXPECT_DOUBLE_EQ(store.stats("x/y", "gap")->mean, 7.0);
+  EXPECT_DOUBLE_EQ(store.stats("x_y", "gap")->mean, 9.0);
+
+  SpcStore fresh(dir, 16);
+  const QJsonArray metrics = fresh.statsJson("default").value("metrics").toArray();
+  ASSERT_EQ(metrics.size(), 2);
+  EXPECT_EQ(metrics.at(0).toObject().value("name").toString(), "a/b");
+  EXPECT_EQ(metrics.at(1).toObject().value("name").toString(), "a_b");
+  EXPECT_EQ(fresh.statsJson("x_y").value("metrics").toArray().size(), 1);
+  std::filesystem::remove_all(dir.toStdString());
+}
+
+TEST(Spc, NamesTooLongForTheHeaderAreRefused){
+  const QString dir = tempSpcDir("mp_spc_long");
+  SpcStore store(dir, 16);
+  const QString fits(63, QChar('m')), tooLong(64, QChar('m'));
+  EXPECT_TRUE(store.append("default", fits, 1.0, true, NAN, NAN, 0));
+  EXPECT_FALSE(store.append("default", tooLong, 1.0, true, NAN, NAN, 0));
+  EXPECT_FALSE(store.append(QString(64, QChar('s')), "gap", 1.0, true, NAN, NAN, 0));
+  EXPECT_EQ(store.stats("default", tooLong), nullptr);
+  SpcStore reopened(dir, 16);
+  const QJsonArray metrics = reopened.statsJson("default").value("metrics").toArray();
+  ASSERT_EQ(metrics.size(), 1);
+  EXPECT_EQ(metrics.at(0).toObject().value("name").toString(), fits);
+  std::filesystem::remove_all(dir.toStdString());
+}
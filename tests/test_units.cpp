@@ -1,8 +1,28 @@
 #include <gtest/gtest.h>
 #include <opencv2/opencv.hpp>
+#include "core/bayer.h"
+#include "core/engine_c.h"
+#include "core/measurement_engine.h"
+#include "core/frame_ring.h"
+#include "core/image_buffer.h"
+#include <QColor>
 #include "measure/caliper.h"
+#include "measure/edge_points.h"
 #include "measure/geometry.h"
+#include "measure/geometry_batch.h"
 #include "measure/calibration.h"
+#include "measure/locator.h"
+#include "measure/perspective.h"
+#include "measure/subpixel.h"
+#include "measure/synth.h"
+#include "backend/measure_service.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
 using namespace mp;
 TEST(Caliper, FindsEdge){
   cv::Mat img = cv::Mat::zeros(100,200,CV_8UC1);
@@ -20,3 +40,600 @@ TEST(Calibration, PxToMm){
   Calibration c; c.scale_mm_per_px = 0.02;
   EXPECT_NEAR(c.toMM(100.0), 2.0, 1e-6);
 }
+TEST(Geometry, RobustCircleIgnoresBurr){
+  std::vector<cv::Point2f> pts;
+  for (int i=0;i<360;++i){ float t=float(i)*float(CV_PI/180.0); pts.push_back({100+40*std::cos(t), 100+40*std::sin(t)}); }
+  for (int i=0;i<30;++i) pts.push_back({140.f+i, 100.f+0.5f*i}); // burr sticking out on the right
+  auto rc = fitCircleRobust(pts);
+  EXPECT_NEAR(rc.circle.r, 40.0, 0.1);
+  EXPECT_NEAR(rc.circle.c.x, 100.0, 0.1);
+  EXPECT_GE(rc.quality.inliers, 360);
+  EXPECT_LT(rc.quality.inliers, (int)pts.size());
+  EXPECT_EQ(rc.inliers.size(), pts.size());
+}
+TEST(Geometry, RobustLineIgnoresDust){
+  std::vector<cv::Point2f> pts;
+  for (int i=0;i<200;++i) pts.push_back({(float)i, 2.f*(float)i + 1.f});
+  for (int i=0;i<20;++i) pts.push_back({(float)(i*10), 500.f});
+  RobustFitParams prm; prm.loss = RobustFitParams::Loss::Huber;
+  auto rl = fitLineRobust(pts, prm);
+  EXPECT_NEAR(rl.line.v.y/rl.line.v.x, 2.0, 1e-3);
+  EXPECT_EQ(rl.quality.inliers, 200);
+  EXPECT_LT(rl.quality.rmsPx, 1e-3);
+}
+TEST(Geometry, BatchCircleMatchesKasaAndRoundness){
+  std::vector<cv::Point2f> a, b;
+  for (int i=0;i<720;++i){
+    float t=float(i)*float(CV_PI/360.0);
+    a.push_back({300+80*std::cos(t), 200+80*std::sin(t)});
+    b.push_back({320+(30+2*std::cos(3*t))*std::cos(t), 210+(30+2*std::cos(3*t))*std::sin(t)}); // 3-lobe, 2px amplitude
+  }
+  PointSetsSoA sets; sets.add(a); sets.add(b); sets.add(std::vector<cv::Point2f>(2));
+  std::vector<CircleGauge> out; fitCirclesBatch(sets, out, 3);
+  ASSERT_EQ(out.size(), 3u);
+  auto ka = fitCircleKasa(a);
+  EXPECT_TRUE(out[0].valid);
+  EXPECT_NEAR(out[0].circle.c.x, ka.c.x, 1e-2);
+  EXPECT_NEAR(out[0].circle.c.y, ka.c.y, 1e-2);
+  EXPECT_NEAR(out[0].diameterPx, 160.0, 1e-2);
+  EXPECT_LT(out[0].roundnessPx, 1e-2);
+  EXPECT_NEAR(out[1].roundnessPx, 4.0, 0.2);
+  EXPECT_FALSE(out[2].valid);
+}
+TEST(Geometry, BatchCircleKeepsPrecisionFarFromOrigin){
+  // long contour, large radius, centre far from the image origin
+  std::vector<cv::Point2f> pts;
+  for (int i=0;i<20000;++i){ double t=2*CV_PI*i/20000; pts.push_back({float(4000+1500*std::cos(t)), float(3000+1500*std::sin(t))}); }
+  auto g = fitCircleGauge(pts);
+  auto k = fitCircleKasa(pts);
+  ASSERT_TRUE(g.valid);
+  EXPECT_NEAR(g.circle.c.x, k.c.x, 1e-3);
+  EXPECT_NEAR(g.circle.c.y, k.c.y, 1e-3);
+  EXPECT_NEAR(g.circle.r, k.r, 1e-3);
+  EXPECT_NEAR(g.diameterPx, 3000.0, 2e-3);
+  EXPECT_LT(g.roundnessPx, 2e-3);
+}
+TEST(Geometry, MomentsMergeAndRemove){
+  std::vector<cv::Point2f> pts;
+  for (int i=0;i<400;++i){ float t=float(i)*float(CV_PI/200.0); pts.push_back({250+60*std::cos(t), 150+60*std::sin(t)}); }
+  const cv::Point2f org(250,150);
+  CircleMoments left(org), right(org), all(org);
+  for (size_t i=0;i<pts.size();++i){ (i%2? left : right).add(pts[i]); all.add(pts[i]); }
+  left += right;
+  Circle a{{0,0},0}, b{{0,0},0};
+  ASSERT_TRUE(left.fit(a)); ASSERT_TRUE(all.fit(b));
+  EXPECT_NEAR(a.r, b.r, 1e-4);
+  EXPECT_NEAR(a.r, 60.0, 1e-3);
+  // a stray point added and removed again leaves the fit untouched
+  all.add({400,400}); all.remove({400,400});
+  ASSERT_TRUE(all.fit(b));
+  EXPECT_NEAR(b.c.x, 250.0, 1e-3);
+
+  LineMoments lm;
+  for (int i=0;i<50;++i) lm.add({(float)i, 2.f*(float)i + 1.f});
+  Line2D L; ASSERT_TRUE(lm.fit(L));
+  EXPECT_NEAR(L.v.y/L.v.x, 2.0, 1e-4);
+  CircleMoments two; two.add({0,0}); two.add({1,1});
+  EXPECT_FALSE(two.fit(a));
+}
+TEST(Perspective, RemapRoiAndRoundTrip){
+  cv::Mat img(240, 320, CV_8UC1);
+  cv::randu(img, 0, 255);
+  auto H = estimateH({cv::Point2f(10,12), {300,5}, {310,230}, {4,220}},
+                     {cv::Point2f(0,0), {280,0}, {280,200}, {0,200}});
+  PerspectiveRemap rm(H, {280,200});
+  cv::Mat full = rm.warp(img);
+  ASSERT_EQ(full.size(), cv::Size(280,200));
+  const cv::Rect roi(40, 30, 100, 60);
+  cv::Mat part = rm.warpRoi(img, roi);
+  EXPECT_EQ(cv::norm(part, full(roi), cv::NORM_INF), 0.0);
+  EXPECT_TRUE(rm.warpRoi(img, {400,400,10,10}).empty());
+
+  auto path = (std::filesystem::temp_directory_path() / "mp_remap_test.remap").string();
+  ASSERT_TRUE(rm.save(path));
+  {
+    auto mapped = PerspectiveRemap::load(path);
+    ASSERT_TRUE(mapped);
+    EXPECT_EQ(mapped->size(), rm.size());
+    EXPECT_EQ(cv::norm(mapped->warp(img), full, cv::NORM_INF), 0.0);
+  }
+  std::filesystem::remove(path);
+  EXPECT_EQ(PerspectiveRemap::cached(H, {280,200}), PerspectiveRemap::cached(H, {280,200}));
+}
+TEST(Calibration, LensModelRoundTripAndGrid){
+  LensModel L; L.fx=L.fy=1200; L.cx=640; L.cy=480; L.k1=-0.28; L.k2=0.09; L.p1=1e-3; L.p2=-5e-4;
+  L.buildGrid({1280,960});
+  double maxBack=0, maxGrid=0;
+  for (int y=5;y<960;y+=37) for (int x=3;x<1280;x+=41){
+    cv::Point2d obs = L.distort({(double)x,(double)y});
+    cv::Point2d back = L.undistort(obs);
+    maxBack = std::max(maxBack, std::hypot(back.x-x, back.y-y));
+    if (obs.x<0 || obs.y<0 || obs.x>1279 || obs.y>959) continue;
+    cv::Point2f o((float)obs.x, (float)obs.y), g = L.map(o), e = L.exact(o);
+    maxGrid = std::max(maxGrid, (double)std::hypot(g.x-e.x, g.y-e.y));
+  }
+  EXPECT_LT(maxBack, 1e-4);
+  EXPECT_LT(maxGrid, 0.02);
+  EXPECT_TRUE(LensModel().identity());
+  EXPECT_FALSE(L.identity());
+}
+TEST(Locator, FindsShiftedRotatedPart){
+  cv::Mat ref(480, 640, CV_8UC1);
+  cv::randu(ref, 20, 40);
+  cv::rectangle(ref, {250,180}, {390,300}, 200, cv::FILLED);
+  cv::circle(ref, {290,220}, 18, 60, cv::FILLED);
+  cv::rectangle(ref, {340,260}, {375,285}, 120, cv::FILLED);
+  const cv::Rect region(230, 160, 180, 160);
+  ShapeLocator loc;
+  ASSERT_TRUE(loc.train(ref, region));
+
+  // move the part: rotate 7 deg about the region centre, then shift
+  const double angle = 7.0; const cv::Point2f shift(37.5f, -21.25f);
+  cv::Mat M = cv::getRotationMatrix2D(loc.refCenter(), angle, 1.0);
+  M.at<double>(0,2) += shift.x; M.at<double>(1,2) += shift.y;
+  cv::Mat img; cv::warpAffine(ref, img, M, ref.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+
+  Pose p = loc.locate(img);
+  ASSERT_TRUE(p.found);
+  EXPECT_NEAR(p.center.x, loc.refCenter().x + shift.x, 0.5);
+  EXPECT_NEAR(p.center.y, loc.refCenter().y + shift.y, 0.5);
+  EXPECT_NEAR(p.angleDeg, angle, 0.5);
+  // ROI corners follow the part
+  cv::Matx23d T = loc.transform(p);
+  cv::Point2f c(250, 180);
+  cv::Point2f expect((float)(M.at<double>(0,0)*c.x + M.at<double>(0,1)*c.y + M.at<double>(0,2)),
+                     (float)(M.at<double>(1,0)*c.x + M.at<double>(1,1)*c.y + M.at<double>(1,2)));
+  EXPECT_NEAR(T(0,0)*c.x + T(0,1)*c.y + T(0,2), expect.x, 1.0);
+  EXPECT_NEAR(T(1,0)*c.x + T(1,1)*c.y + T(1,2), expect.y, 1.0);
+}
+TEST(Locator, PoseComesBesideTheGaugeItems){
+  cv::Mat ref(480, 640, CV_8UC1);
+  cv::randu(ref, 20, 40);
+  cv::rectangle(ref, {250,180}, {390,300}, 200, cv::FILLED);
+  cv::circle(ref, {320,240}, 30, 60, cv::FILLED);
+  auto loc = std::make_shared<ShapeLocator>();
+  ASSERT_TRUE(loc->train(ref, cv::Rect(230, 160, 180, 160)));
+  MeasureSpec spec; spec.locator = loc;
+  MeasureRoi roi; roi.kind = MeasureRoi::Kind::Rect; roi.rect = cv::Rect(240, 170, 160, 140);
+
+  cv::Mat img; cv::warpAffine(ref, img, cv::Matx23d(1, 0, 12, 0, 1, -7), ref.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  std::vector<Item> items; std::vector<SpecLimits> limits; Pose pose;
+  MeasurementEngine::Session session;
+  session.measure(img, spec, roi, items, limits, 0, &pose);
+  ASSERT_TRUE(pose.found);
+  EXPECT_NEAR(pose.center.x, loc->refCenter().x + 12, 0.5);
+  EXPECT_FALSE(items.empty());
+  for (auto& it : items){
+    EXPECT_NE(it.name.rfind("pose_", 0), 0u) << it.name;
+    EXPECT_NE(it.name, "locate_score");
+  }
+  // a missing part fails through a single item
+  session.measure(cv::Mat(ref.size(), CV_8UC1, cv::Scalar(30)), spec, roi, items, limits, 0, &pose);
+  EXPECT_FALSE(pose.found);
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items[0].name, "locate_score");
+  EXPECT_FALSE(items[0].ok);
+}
+TEST(Locator, MeasureJsonReportsThePose){
+  cv::Mat ref(480, 640, CV_8UC1);
+  cv::randu(ref, 20, 40);
+  cv::rectangle(ref, {250,180}, {390,300}, 200, cv::FILLED);
+  cv::circle(ref, {320,240}, 30, 60, cv::FILLED);
+  const std::string path = (std::filesystem::temp_directory_path() / "mp_locator_ref.png").string();
+  ASSERT_TRUE(cv::imwrite(path, ref));
+  const QJsonObject specs{{"locator", QJsonObject{{"enabled", true}, {"reference_image", QString::fromStdString(path)},
+                                                  {"region", QJsonArray{230, 160, 180, 160}}}}};
+  const QJsonObject roi{{"type","rect"}, {"x",240}, {"y",170}, {"w",160}, {"h",140}};
+  cv::Mat img; cv::warpAffine(ref, img, cv::Matx23d(1, 0, 12, 0, 1, -7), ref.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  auto report = makeReportWriter(ReportFormat::Json, "metrics");
+  std::string body;
+
+  // one ROI: "pose" beside "metrics"
+  std::vector<Item> items; std::vector<SpecLimits> limits; Pose pose;
+  measureImage(img, QJsonObject{{"specs", specs}, {"roi", roi}}, items, limits, &pose);
+  writeReport(*report, items, body);
+  appendPoseJson(body, pose);
+  const QJsonObject one = QJsonDocument::fromJson(QByteArray::fromStdString(body)).object();
+  ASSERT_TRUE(one.value("metrics").isArray());
+  const QJsonObject p = one.value("pose").toObject();
+  EXPECT_TRUE(p.value("found").toBool());
+  EXPECT_NEAR(p.value("x").toDouble(), 320 + 12, 1.0);   // region centre, shifted
+  EXPECT_NEAR(p.value("y").toDouble(), 240 - 7, 1.0);
+  EXPECT_NEAR(p.value("angle_deg").toDouble(), 0.0, 0.5);
+  EXPECT_GT(p.value("score").toDouble(), 0.6);
+
+  // several ROIs: one entry per job
+  auto spec = std::make_shared<const MeasureSpec>(MeasureSpec::fromJson(specs));
+  std::vector<RoiJob> jobs(2);
+  jobs[0].name = "left"; jobs[1].name = "right";
+  for (auto& j : jobs){ j.spec = spec; j.roi = MeasureRoi::fromJson(roi); }
+  std::vector<int> jobOf; std::vector<Pose> poses;
+  MeasurementEngine::measureRois(img, jobs, items, limits, &jobOf, &poses);
+  writeReport(*report, items, body);
+  appendPosesJson(body, {"left", "right"}, poses);
+  const QJsonArray many = QJsonDocument::fromJson(QByteArray::fromStdString(body)).object().value("poses").toArray();
+  ASSERT_EQ(many.size(), 2);
+  EXPECT_EQ(many.at(1).toObject().value("roi").toString(), "right");
+  EXPECT_NEAR(many.at(1).toObject().value("x").toDouble(), 320 + 12, 1.0);
+  std::filesystem::remove(path);
+}
+TEST(Subpixel, EdgeChainsLocateBlurredRing){
+  // anti-aliased disk with a hole, centre and radii off the pixel grid
+  const double cx = 160.37, cy = 120.71, R = 50.3, r = 20.2, s = 1.2;
+  cv::Mat img(240, 320, CV_8UC1);
+  for (int y=0;y<img.rows;++y) for (int x=0;x<img.cols;++x){
+    double d = std::hypot(x-cx, y-cy);
+    double v = 40 + 80*std::erfc((d-R)/(std::sqrt(2.0)*s)) - 60*std::erfc((d-r)/(std::sqrt(2.0)*s));
+    img.at<uchar>(y,x) = cv::saturate_cast<uchar>(v);
+  }
+  std::vector<EdgeChain> chains;
+  subpixelEdges(img, chains);
+  ASSERT_GE(chains.size(), 2u);
+  keepOuterChains(chains);
+  ASSERT_EQ(chains.size(), 1u);
+  Circle c = fitCircleKasa(chains[0]);
+  EXPECT_NEAR(c.c.x, cx, 0.02);
+  EXPECT_NEAR(c.c.y, cy, 0.02);
+  EXPECT_NEAR(c.r, R, 0.05);
+}
+TEST(FrameRing, LatestFrameWinsAndAttachChecksGeometry){
+  const cv::Size sz(64, 48);
+  std::vector<uint64_t> mem((frameRingBytes(sz, CV_8UC1, 3) + 7)/8);
+  FrameRingHeader* ring = frameRingInit(mem.data(), sz, CV_8UC1, 3);
+  ASSERT_EQ(frameRingAttach(mem.data(), mem.size()*8), ring);
+  EXPECT_EQ(frameRingAttach(mem.data(), 100), nullptr);
+
+  cv::Mat out; uint64_t seq = 0;
+  EXPECT_FALSE(frameRingLatest(ring, out, seq));
+  for (int i=1; i<=2; ++i) frameRingPush(ring, cv::Mat(sz, CV_8UC1, cv::Scalar(i*10)));
+  ASSERT_TRUE(frameRingLatest(ring, out, seq));
+  EXPECT_EQ(seq, 2u);
+  EXPECT_EQ(out.at<uchar>(10, 10), 20);
+  EXPECT_FALSE(frameRingLatest(ring, out, seq));   // nothing newer
+
+  // raw Bayer rings name their mosaic in the header
+  ring = frameRingInit(mem.data(), sz, CV_8UC1, 3, BayerPattern::RG);
+  ASSERT_EQ(frameRingAttach(mem.data(), mem.size()*8), ring);
+  EXPECT_EQ(BayerPattern(ring->bayer), BayerPattern::RG);
+}
+TEST(FrameRing, ReaderLappedMidCopyReportsTornFrame){
+  // a 2-slot ring is rewritten as soon as the producer starts the next frame
+  const cv::Size sz(1024, 1024);
+  std::vector<uint64_t> mem((frameRingBytes(sz, CV_8UC1, 2) + 7)/8);
+  FrameRingHeader* ring = frameRingInit(mem.data(), sz, CV_8UC1, 2);
+  std::atomic<bool> stop{false};
+  std::thread producer([&]{
+    cv::Mat f(sz, CV_8UC1);
+    for (uint64_t i=0; !stop.load(std::memory_order_relaxed); ++i){ f.setTo(cv::Scalar(double(i % 251))); frameRingPush(ring, f); }
+  });
+  while (ring->seq.load() == 0) std::this_thread::yield();
+
+  cv::Mat out; uint64_t seq = 0;
+  int good = 0, torn = 0;
+  const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while ((torn == 0 || good == 0) && std::chrono::steady_clock::now() < until){
+    // with a newer frame published before the call, false can only mean lapped
+    const bool newer = ring->seq.load() != seq;
+    if (frameRingLatest(ring, out, seq)){
+      ++good;
+      // an accepted frame is whole: first and last pixel belong to frame `seq`
+      EXPECT_EQ(out.at<uchar>(0, 0), (seq - 1) % 251);
+      EXPECT_EQ(out.at<uchar>(sz.height-1, sz.width-1), (seq - 1) % 251);
+    }
+    else if (newer) ++torn;
+  }
+  stop = true;
+  producer.join();
+  EXPECT_GT(torn, 0);
+  EXPECT_GT(good, 0);
+}
+TEST(ImageBuffer, MatAndQImageShareNativePixels){
+  cv::Mat bgr(40, 60, CV_8UC3, cv::Scalar(10, 20, 30));
+  QImage q;
+  {
+    ImageBuffer b(bgr);
+    q = b.qimage();
+    EXPECT_EQ(q.format(), QImage::Format_BGR888);
+    EXPECT_EQ(q.constBits(), bgr.data);        // no copy
+  }
+  bgr.release();                                // the view keeps the pixels alive
+  ASSERT_EQ(q.width(), 60);
+  EXPECT_EQ(q.pixelColor(5, 5), QColor(30, 20, 10));
+
+  QImage g(32, 16, QImage::Format_Grayscale8);
+  g.fill(77);
+  ImageBuffer gb = ImageBuffer::fromQImage(g);
+  EXPECT_EQ(gb.mat().type(), CV_8UC1);
+  EXPECT_EQ(gb.mat().data, g.constBits());
+  EXPECT_EQ(gb.mat().at<uchar>(3, 3), 77);
+}
+TEST(Synth, RingTruthMatchesSubpixelFit){
+  SynthParams p; p.size = cv::Size(320, 240); p.blurSigma = 1.0; p.noiseSigma = 0; p.gradient = 0.3;
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 70, 30, {3.3, -1.6}, t, {0.37, -0.21});
+  ASSERT_EQ(img.type(), CV_8UC3);
+  EXPECT_TRUE(std::isnan(t.lineGapPx));
+  EXPECT_DOUBLE_EQ(t.diameterAPx, 140);
+  EXPECT_NEAR(t.concentricityPx, std::hypot(3.3, 1.6), 1e-12);
+  EXPECT_FALSE(t.roi.contains(cv::Point(20, 20)));
+  EXPECT_GT(t.roi.width, 140);
+
+  cv::Mat gray; cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+  std::vector<EdgeChain> chains;
+  subpixelEdges(gray, chains);
+  Circle A{{0,0},0}, B{{0,0},0};
+  for (auto& c : chains){
+    if (c.size() < 50) continue;
+    Circle f = fitCircleKasa(c);
+    (f.r > 50 ? A : B) = f;
+  }
+  const cv::Point2f cA(0.5f*319 + 0.37f, 0.5f*239 - 0.21f);
+  EXPECT_NEAR(A.c.x, cA.x, 0.02);
+  EXPECT_NEAR(A.c.y, cA.y, 0.02);
+  EXPECT_NEAR(2*A.r, t.diameterAPx, 0.1);
+  EXPECT_NEAR(cv::norm(A.c - B.c), t.concentricityPx, 0.05);
+}
+TEST(EdgePoints, RingFitsTruthWithoutEdgeImage){
+  SynthParams p; p.size = cv::Size(320, 240); p.blurSigma = 1.0; p.noiseSigma = 0; p.gradient = 0;
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 70, 30, {3.3, -1.6}, t, {0.37, -0.21});
+  cv::Mat gray; cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+  EdgePoints e;
+  edgePoints(gray, e);
+  ASSERT_GT(e.size(), 400u);
+  ASSERT_EQ(e.grad.size(), e.size());
+  ASSERT_EQ(e.mag.size(), e.size());
+
+  // outer edge: one group (the hole edge is nested), radial gradients
+  std::vector<std::vector<int>> groups;
+  outerEdgeGroups(e, groups);
+  ASSERT_GE(groups.size(), 1u);
+  const cv::Point2f cA(0.5f*319 + 0.37f, 0.5f*239 - 0.21f);
+  std::vector<cv::Point2f> a;
+  for (int i : groups[0]){
+    a.push_back(e.pt[i]);
+    const cv::Point2f r = e.pt[i] - cA;
+    EXPECT_GT(std::abs(r.dot(e.grad[i])) / (cv::norm(r) * e.mag[i]), 0.95);
+  }
+  Circle A = fitCircleKasa(a);
+  EXPECT_NEAR(A.c.x, cA.x, 0.05);
+  EXPECT_NEAR(A.c.y, cA.y, 0.05);
+  EXPECT_NEAR(2*A.r, t.diameterAPx, 0.2);
+
+  // the mask limits where points lie
+  cv::Mat mask = cv::Mat::zeros(gray.size(), CV_8UC1);
+  mask(cv::Rect(0, 0, 160, 240)).setTo(255);
+  edgePoints(gray, e, {}, mask);
+  ASSERT_FALSE(e.empty());
+  for (auto& q : e.pt) EXPECT_LT(q.x, 160.5f);
+}
+
+TEST(EdgePoints, TwelveBitMatchesEightBit){
+  SynthParams p; p.size = cv::Size(320, 240); p.blurSigma = 1.0; p.noiseSigma = 0; p.gradient = 0;
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 70, 30, {3.3, -1.6}, t, {0.37, -0.21});
+  cv::Mat gray, deep; cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+  gray.convertTo(deep, CV_16U, 16);   // 12-bit data, LSB-aligned
+  EdgePoints e8, e16;
+  edgePoints(gray, e8);
+  EdgePointParams prm; prm.bits = 12;
+  edgePoints(deep, e16, prm);
+  ASSERT_GT(e8.size(), 400u);
+  EXPECT_NEAR((double)e16.size(), (double)e8.size(), 0.02*e8.size());
+  std::vector<std::vector<int>> g8, g16;
+  outerEdgeGroups(e8, g8); outerEdgeGroups(e16, g16);
+  ASSERT_FALSE(g8.empty()); ASSERT_FALSE(g16.empty());
+  auto fit = [](const EdgePoints& e, const std::vector<int>& g){
+    std::vector<cv::Point2f> a; for (int i : g) a.push_back(e.pt[i]);
+    return fitCircleKasa(a);
+  };
+  const Circle A8 = fit(e8, g8[0]), A16 = fit(e16, g16[0]);
+  EXPECT_NEAR(A16.c.x, A8.c.x, 0.01);
+  EXPECT_NEAR(A16.c.y, A8.c.y, 0.01);
+  EXPECT_NEAR(A16.r, A8.r, 0.01);
+
+  // the caliper reads 16-bit pixels directly
+  const auto c8 = caliper1D(gray, {10, 120}, {309, 120}, 300);
+  const auto c16 = caliper1D(deep, {10, 120}, {309, 120}, 300);
+  EXPECT_EQ(c16.index, c8.index);
+  EXPECT_FLOAT_EQ(c16.response, 16*c8.response);
+
+  // whole engine: thresholds on the 8-bit scale, "bit_depth" names the 12 bits
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  const QJsonObject spec{{"mm_per_px", 0.01}, {"bit_depth", 12}};
+  MeasurementEngine::Session s;
+  s.measure(gray, MeasureSpec::fromJson(spec), MeasureRoi{}, items, limits);
+  std::vector<Item> deepItems;
+  s.measure(deep, MeasureSpec::fromJson(spec), MeasureRoi{}, deepItems, limits);
+  ASSERT_EQ(deepItems.size(), items.size());
+  for (size_t i=0;i<items.size();++i){
+    EXPECT_EQ(deepItems[i].name, items[i].name);
+    if (items[i].name.rfind("diameter", 0) == 0) EXPECT_NEAR(deepItems[i].value, items[i].value, 0.02);
+  }
+}
+
+TEST(Bayer, HalfGrayFromRawMosaic){
+  cv::Mat raw(7, 9, CV_8UC1);
+  cv::randu(raw, 0, 256);
+  cv::Mat green, luma;
+  bayerToHalfGray(raw, green, BayerPattern::RG);
+  bayerToHalfGray(raw, luma, BayerPattern::GB, BayerReduce::Luma);
+  ASSERT_EQ(green.size(), cv::Size(4, 3));
+  for (int y=0; y<3; ++y) for (int x=0; x<4; ++x){
+    const uchar* a = raw.ptr<uchar>(2*y) + 2*x, *b = raw.ptr<uchar>(2*y+1) + 2*x;
+    EXPECT_EQ(green.at<uchar>(y, x), (a[1] + b[0] + 1)/2);                          // R G / G B
+    EXPECT_NEAR(luma.at<uchar>(y, x), 0.299*b[0] + 0.587*0.5*(a[0] + b[1]) + 0.114*a[1], 1.0);   // G B / R G
+  }
+  // rows long enough for the vector kernels give the same cells
+  cv::Mat wide(4, 200, CV_16UC1), half;
+  cv::randu(wide, 0, 4096);
+  bayerToHalfGray(wide, half, BayerPattern::BG, BayerReduce::Luma);
+  for (int x=0; x<100; ++x){
+    const ushort* a = wide.ptr<ushort>(2) + 2*x, *b = wide.ptr<ushort>(3) + 2*x;
+    ASSERT_EQ(half.at<ushort>(1, x), (77*b[1] + 75*(a[1] + b[0]) + 29*a[0] + 128) >> 8);
+  }
+  EXPECT_EQ(bayerPattern("BayerGR8"), BayerPattern::GR);
+  EXPECT_EQ(bayerPattern("RGB"), BayerPattern::None);
+}
+
+TEST(Bayer, RawMosaicThroughCAbi){
+  SynthParams p; p.size = cv::Size(480, 360); p.noiseSigma = 0;
+  SynthTruth t;
+  cv::Mat bgr = synthRing(p, 100, 40, {4.0, 0.0}, t);
+  cv::Mat raw(bgr.size(), CV_8UC1);   // R G / G B
+  for (int y=0; y<raw.rows; ++y) for (int x=0; x<raw.cols; ++x)
+    raw.at<uchar>(y, x) = bgr.at<cv::Vec3b>(y, x)[y%2 == 0 ? (x%2 == 0 ? 2 : 1) : (x%2 == 0 ? 1 : 0)];
+
+  // half-size pixels: twice the calibration, half the ROI
+  mp_engine* e = mp_engine_create();
+  const char spec[] = R"({"mm_per_px": 0.02, "bayer_reduce": "luma"})";
+  ASSERT_EQ(mp_engine_put_spec(e, "ring", spec, sizeof spec - 1), MP_OK);
+  mp_session* s = mp_session_create(e);
+  mp_image im{raw.data, raw.cols, raw.rows, (int32_t)raw.step, MP_PIXEL_BAYER_RG8};
+  mp_roi roi{MP_ROI_RECT, t.roi.x/2, t.roi.y/2, t.roi.width/2, t.roi.height/2};
+  mp_metric out[16]; int32_t n = 0;
+  ASSERT_EQ(mp_measure(s, "ring", &im, &roi, 0, out, 16, &n), MP_OK);
+  bool sawDia = false;
+  for (int i=0; i<n; ++i)
+    if (std::string(out[i].name) == "diameter_A"){ sawDia = true; EXPECT_NEAR(out[i].value, t.diameterAPx*0.01, 0.04); }
+  EXPECT_TRUE(sawDia);
+  mp_session_destroy(s);
+  mp_engine_destroy(e);
+}
+TEST(Bayer, ImageIdIsNotReusedAcrossReduceModes){
+  SynthParams p; p.size = cv::Size(480, 360); p.noiseSigma = 0;
+  SynthTruth t;
+  cv::Mat bgr = synthRing(p, 100, 40, {4.0, 0.0}, t);
+  // the part shows on the red and blue sites only: green reduces to a flat frame
+  cv::Mat raw(bgr.size(), CV_8UC1);
+  for (int y=0; y<raw.rows; ++y) for (int x=0; x<raw.cols; ++x)
+    raw.at<uchar>(y, x) = (x + y)%2 ? 100 : bgr.at<cv::Vec3b>(y, x)[y%2 == 0 ? 2 : 0];
+
+  mp_engine* e = mp_engine_create();
+  const char green[] = R"({"mm_per_px": 0.02, "bayer_reduce": "green"})";
+  const char luma[] = R"({"mm_per_px": 0.02, "bayer_reduce": "luma"})";
+  ASSERT_EQ(mp_engine_put_spec(e, "green", green, sizeof green - 1), MP_OK);
+  ASSERT_EQ(mp_engine_put_spec(e, "luma", luma, sizeof luma - 1), MP_OK);
+  mp_image im{raw.data, raw.cols, raw.rows, (int32_t)raw.step, MP_PIXEL_BAYER_RG8};
+  mp_roi roi{MP_ROI_RECT, t.roi.x/2, t.roi.y/2, t.roi.width/2, t.roi.height/2};
+
+  mp_metric ref[16], out[16]; int32_t nRef = 0, n = 0;
+  mp_session* s = mp_session_create(e);
+  ASSERT_EQ(mp_measure(s, "luma", &im, &roi, 0, ref, 16, &nRef), MP_OK);
+  mp_session_destroy(s);
+  // one image id under both specs: the luma frame must not reuse the green edges
+  s = mp_session_create(e);
+  ASSERT_EQ(mp_measure(s, "green", &im, &roi, 7, out, 16, &n), MP_OK);
+  ASSERT_EQ(mp_measure(s, "luma", &im, &roi, 7, out, 16, &n), MP_OK);
+  ASSERT_EQ(n, nRef);
+  for (int i=0; i<n; ++i){
+    EXPECT_STREQ(out[i].name, ref[i].name);
+    EXPECT_DOUBLE_EQ(out[i].value, ref[i].value) << out[i].name;
+  }
+  mp_session_destroy(s);
+  mp_engine_destroy(e);
+}
+
+TEST(Engine, PolarRingGaugesMatchTruth){
+  SynthParams p; p.size = cv::Size(480, 360);
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 100, 40, {4.0, -1.5}, t, {0.3, 0.2});
+  const double mmPerPx = 0.01;
+  const QJsonObject specs{{"mm_per_px", mmPerPx}, {"polar_ring", QJsonObject{{"enabled", true}}}};
+  // the ROI centre need not be the part's: radii vary around the ring, the fit takes the offset out
+  QJsonObject roi{{"type", "ring"}, {"cx", 240}, {"cy", 180}, {"r_in", 20}, {"r_out", 120}};
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  auto value = [&](const char* name){
+    for (auto& it : items) if (it.name == name) return it.value;
+    return -1.0;
+  };
+  measureImage(img, QJsonObject{{"mm_per_px", mmPerPx}, {"specs", specs}, {"roi", roi}}, items, limits);
+  EXPECT_NEAR(value("diameter_A"), t.diameterAPx*mmPerPx, 0.1*mmPerPx);
+  EXPECT_NEAR(value("concentricity_AB"), t.concentricityPx*mmPerPx, 0.1*mmPerPx);
+  EXPECT_GE(value("roundness_A"), 0.0);
+  EXPECT_LT(value("roundness_A"), 1.5*mmPerPx);
+  EXPECT_EQ(value("line_gap"), -1.0);
+
+  // an annulus clear of the bore sees the outer edge only
+  roi["r_in"] = 60;
+  measureImage(img, QJsonObject{{"mm_per_px", mmPerPx}, {"specs", specs}, {"roi", roi}}, items, limits);
+  EXPECT_NEAR(value("diameter_A"), t.diameterAPx*mmPerPx, 0.1*mmPerPx);
+  EXPECT_EQ(value("concentricity_AB"), -1.0);
+}
+
+TEST(Engine, CAbiMatchesJsonServiceOnSyntheticRing){
+  SynthParams p; p.size = cv::Size(480, 360); p.noiseSigma = 0;
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 100, 40, {4.0, 0.0}, t);
+  const double mmPerPx = 0.01;
+
+  mp_engine* e = mp_engine_create();
+  ASSERT_NE(e, nullptr);
+  EXPECT_EQ(mp_engine_abi_version(), MP_ENGINE_ABI_VERSION);
+  const char spec[] = R"({"mm_per_px": 0.01, "diameter": {"target": 2.0, "tol": 0.05}})";
+  ASSERT_EQ(mp_engine_put_spec(e, "ring", spec, sizeof spec - 1), MP_OK);
+  EXPECT_EQ(mp_engine_put_spec(e, "bad", "[1]", 3), MP_E_SPEC);
+  mp_session* s = mp_session_create(e);
+
+  mp_image im{img.data, img.cols, img.rows, (int32_t)img.step, MP_PIXEL_BGR8};
+  mp_roi roi{MP_ROI_RECT, t.roi.x, t.roi.y, t.roi.width, t.roi.height};
+  mp_metric out[16]; int32_t n = 0;
+  ASSERT_EQ(mp_measure(s, "ring", &im, &roi, 7, out, 16, &n), MP_OK);
+  EXPECT_EQ(mp_measure(s, "ring", &im, &roi, 7, out, 1, &n), MP_E_CAPACITY);
+  EXPECT_EQ(mp_measure(s, "nope", &im, &roi, 7, out, 16, &n), MP_E_SPEC);
+  ASSERT_EQ(mp_measure(s, "ring", &im, &roi, 0, out, 16, &n), MP_OK);
+
+  // same recipe through the JSON entry point
+  std::vector<Item> items; std::vector<SpecLimits> limits;
+  QJsonObject payload{{"mm_per_px", mmPerPx},
+                      {"specs", QJsonDocument::fromJson(spec).object()},
+                      {"roi", QJsonObject{{"type","rect"}, {"x",t.roi.x}, {"y",t.roi.y}, {"w",t.roi.width}, {"h",t.roi.height}}}};
+  measureImage(img, payload, items, limits);
+  ASSERT_EQ((size_t)n, items.size());
+  // Outer contours only: the hole edge is nested inside the outer one, so
+  // only the outer diameter is checked against the truth (pixel contour, ±2 px).
+  bool sawDia = false;
+  for (int i=0;i<n;++i){
+    EXPECT_EQ(items[i].name, out[i].name);
+    EXPECT_DOUBLE_EQ(items[i].value, out[i].value);
+    if (items[i].name == "diameter_A"){ sawDia = true; EXPECT_NEAR(out[i].value, t.diameterAPx*mmPerPx, 2*mmPerPx); EXPECT_TRUE(out[i].ok); }
+  }
+  EXPECT_TRUE(sawDia);
+  mp_session_destroy(s);
+  mp_engine_destroy(e);
+}
+
+TEST(Engine, MeasureRoisMatchesOneRoiAtATime){
+  SynthParams p; p.size = cv::Size(480, 360); p.noiseSigma = 0;
+  SynthTruth t;
+  cv::Mat img = synthRing(p, 100, 40, {4.0, 0.0}, t);
+  auto spec = std::make_shared<const MeasureSpec>(MeasureSpec::fromJson(QJsonObject{{"mm_per_px", 0.01}}));
+  const cv::Rect half(t.roi.x, t.roi.y, t.roi.width, t.roi.height/2);
+
+  std::vector<RoiJob> jobs(3);
+  jobs[0].name = "ring"; jobs[0].spec = spec; jobs[0].roi.kind = MeasureRoi::Kind::Rect; jobs[0].roi.rect = t.roi;
+  jobs[1].name = "dia";  jobs[1].spec = spec; jobs[1].roi = jobs[0].roi; jobs[1].gauges = {"diameter"};
+  jobs[2].name = "top";  jobs[2].spec = spec; jobs[2].roi.kind = MeasureRoi::Kind::Rect; jobs[2].roi.rect = half;
+  std::vector<Item> items; std::vector<SpecLimits> limits; std::vector<int> jobOf;
+  MeasurementEngine::measureRois(img, jobs, items, limits, &jobOf);
+  ASSERT_EQ(items.size(), limits.size());
+  ASSERT_EQ(items.size(), jobOf.size());
+
+  // each job on its own through one session (same full-frame edge path)
+  MeasurementEngine::Session session;
+  size_t k = 0;
+  for (size_t j=0; j<jobs.size(); ++j){
+    std::vector<Item> one; std::vector<SpecLimits> oneLimits;
+    session.measure(img, *spec, jobs[j].roi, one, oneLimits, 1);
+    for (auto& it : one){
+      if (j==1 && it.name != "diameter_A") continue;
+      ASSERT_LT(k, items.size());
+      EXPECT_EQ(jobOf[k], (int)j);
+      EXPECT_EQ(items[k].name, jobs[j].name + "." + it.name);
+      EXPECT_DOUBLE_EQ(items[k].value, it.value);
+      ++k;
+    }
+  }
+  EXPECT_EQ(k, items.size());
+  EXPECT_TRUE(std::any_of(items.begin(), items.end(), [](const Item& it){ return it.name == "dia.diameter_A"; }));
+}